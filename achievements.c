@@ -0,0 +1,184 @@
+#include "achievements.h"
+#include "catalog.h"
+
+#define ACHIEVEMENT_EVENT(type) (1 << (type))
+
+#define FLAWLESS_STREAK 10
+#define GATLING_SPRINT_MS 1000
+#define SCORE_CLUB 50000
+#define MARATHON_LENGTH 100
+#define LAST_STAND_LENGTH 10
+
+_Static_assert(AchievementCount <= 32, "Unlocks are stored in a 32-bit set");
+
+typedef bool (*AchievementUpdate)(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event);
+
+typedef struct {
+    const char* name;
+    uint8_t events; // ACHIEVEMENT_EVENT mask
+    AchievementUpdate update;
+} AchievementDef;
+
+static bool achievement_flawless(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event) {
+    (void)achievements;
+    if(event->type == AchievementEventCompletion && event->mistakes == 0) {
+        return ++*progress >= FLAWLESS_STREAK;
+    }
+    // A new run, a wrong key or a timeout breaks the streak
+    *progress = 0;
+    return false;
+}
+
+static bool achievement_gatling_sprint(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event) {
+    (void)progress;
+    return event->stratagem == achievements->gatling && event->time_ms < GATLING_SPRINT_MS;
+}
+
+static bool achievement_score(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event) {
+    (void)achievements;
+    (void)progress;
+    return event->value >= SCORE_CLUB;
+}
+
+static bool achievement_marathon(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event) {
+    (void)achievements;
+    if(event->type == AchievementEventStart) {
+        *progress = 0;
+        return false;
+    }
+    return ++*progress >= MARATHON_LENGTH;
+}
+
+// Progress is 0 until the run drops to its last life, then counts from 1
+static bool achievement_last_stand(const Achievements* achievements, uint16_t* progress, const AchievementEvent* event) {
+    (void)achievements;
+    switch(event->type) {
+        case AchievementEventStart:
+            *progress = 0;
+            return false;
+        case AchievementEventLifeLost:
+            if(event->value == 1) *progress = 1;
+            return false;
+        default:
+            if(*progress == 0) return false;
+            return ++*progress > LAST_STAND_LENGTH;
+    }
+}
+
+static const AchievementDef achievement_defs[AchievementCount] = {
+    [AchievementFlawless] = {
+        "FLAWLESS",
+        ACHIEVEMENT_EVENT(AchievementEventStart) | ACHIEVEMENT_EVENT(AchievementEventCompletion) |
+            ACHIEVEMENT_EVENT(AchievementEventWrong) | ACHIEVEMENT_EVENT(AchievementEventTimeout),
+        achievement_flawless,
+    },
+    [AchievementGatlingSprint] = {
+        "GATLING SPRINT",
+        ACHIEVEMENT_EVENT(AchievementEventCompletion),
+        achievement_gatling_sprint,
+    },
+    [AchievementScore50k] = {
+        "50K CLUB",
+        ACHIEVEMENT_EVENT(AchievementEventCompletion),
+        achievement_score,
+    },
+    [AchievementMarathon] = {
+        "MARATHON",
+        ACHIEVEMENT_EVENT(AchievementEventStart) | ACHIEVEMENT_EVENT(AchievementEventCompletion),
+        achievement_marathon,
+    },
+    [AchievementLastStand] = {
+        "LAST STAND",
+        ACHIEVEMENT_EVENT(AchievementEventStart) | ACHIEVEMENT_EVENT(AchievementEventLifeLost) |
+            ACHIEVEMENT_EVENT(AchievementEventCompletion),
+        achievement_last_stand,
+    },
+};
+
+void achievements_init(Achievements* achievements, uint32_t unlocked) {
+    achievements->unlocked = unlocked;
+    achievements->dispatched = 0;
+    
+    // A catalog without the sprint stratagem leaves that one locked
+    int16_t gatling = catalog_find("Orbital Gatling Barrage");
+    achievements->gatling = gatling < 0 ? 0xFF : (uint8_t)gatling;
+    
+    for(uint8_t type = 0; type < AchievementEventCount; type++) {
+        achievements->subscriber_count[type] = 0;
+    }
+    for(uint8_t id = 0; id < AchievementCount; id++) {
+        achievements->progress[id] = 0;
+        if(unlocked & (1UL << id)) continue;
+        
+        for(uint8_t type = 0; type < AchievementEventCount; type++) {
+            if(achievement_defs[id].events & ACHIEVEMENT_EVENT(type)) {
+                achievements->subscribers[type][achievements->subscriber_count[type]++] = id;
+            }
+        }
+    }
+}
+
+static void achievements_unsubscribe(Achievements* achievements, uint8_t id) {
+    for(uint8_t type = 0; type < AchievementEventCount; type++) {
+        uint8_t* list = achievements->subscribers[type];
+        uint8_t* count = &achievements->subscriber_count[type];
+        for(uint8_t i = 0; i < *count; i++) {
+            if(list[i] == id) {
+                list[i] = list[--*count];
+                break;
+            }
+        }
+    }
+}
+
+uint32_t achievements_dispatch(Achievements* achievements, const AchievementEvent* event) {
+    achievements->dispatched++;
+    
+    uint32_t unlocked = 0;
+    uint8_t* list = achievements->subscribers[event->type];
+    for(uint8_t i = 0; i < achievements->subscriber_count[event->type]; i++) {
+        uint8_t id = list[i];
+        if(achievement_defs[id].update(achievements, &achievements->progress[id], event)) {
+            unlocked |= 1UL << id;
+        }
+    }
+    
+    // Unsubscribe after the walk, so the list does not shift under it
+    if(unlocked) {
+        achievements->unlocked |= unlocked;
+        for(uint8_t id = 0; id < AchievementCount; id++) {
+            if(unlocked & (1UL << id)) achievements_unsubscribe(achievements, id);
+        }
+    }
+    return unlocked;
+}
+
+const char* achievement_name(AchievementId id) {
+    return achievement_defs[id].name;
+}
+
+void achievements_encode(uint32_t unlocked, uint8_t* out) {
+    out[0] = ACHIEVEMENTS_MAGIC_0;
+    out[1] = ACHIEVEMENTS_MAGIC_1;
+    out[2] = ACHIEVEMENTS_VERSION;
+    out[3] = AchievementCount;
+    for(uint8_t i = 0; i < 4; i++) {
+        out[4 + i] = (unlocked >> (8 * i)) & 0xFF;
+    }
+}
+
+uint32_t achievements_decode(const uint8_t* data, size_t size) {
+    if(size != ACHIEVEMENTS_FILE_SIZE) return 0;
+    if(data[0] != ACHIEVEMENTS_MAGIC_0 || data[1] != ACHIEVEMENTS_MAGIC_1 || data[2] != ACHIEVEMENTS_VERSION) {
+        return 0;
+    }
+    
+    uint32_t unlocked = 0;
+    for(uint8_t i = 0; i < 4; i++) {
+        unlocked |= (uint32_t)data[4 + i] << (8 * i);
+    }
+    
+    // Ids are only appended, so a file from an older build stays valid
+    uint8_t count = data[3] < AchievementCount ? data[3] : AchievementCount;
+    return count >= 32 ? unlocked : unlocked & ((1UL << count) - 1);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Achievements, driven by the typed events the app emits as the core
+// reports what happened. Each achievement is a small state machine over one
+// progress counter and subscribes to the event types it cares about; the
+// engine keeps a subscriber list per type, so an event only touches its
+// listeners and an unlocked achievement drops off every list. Nothing runs
+// per frame or per tick. Unlocks persist as a bitset. Platform-free.
+
+#define ACHIEVEMENTS_MAGIC_0 'A'
+#define ACHIEVEMENTS_MAGIC_1 'C'
+#define ACHIEVEMENTS_VERSION 1
+#define ACHIEVEMENTS_FILE_SIZE 8
+
+typedef enum {
+    AchievementEventStart, // a run begins
+    AchievementEventCompletion, // stratagem, time, mistakes; value is the score
+    AchievementEventWrong,
+    AchievementEventTimeout,
+    AchievementEventLifeLost, // value is the lives left
+    AchievementEventCount,
+} AchievementEventType;
+
+typedef struct {
+    AchievementEventType type;
+    uint8_t stratagem;
+    uint8_t mistakes;
+    uint32_t time_ms;
+    uint32_t value;
+} AchievementEvent;
+
+// Stored as bit positions: only ever append
+typedef enum {
+    AchievementFlawless, // 10 stratagems in a row without a wrong key
+    AchievementGatlingSprint, // Orbital Gatling Barrage in under a second
+    AchievementScore50k, // 50,000 points in one run
+    AchievementMarathon, // 100 stratagems in one run
+    AchievementLastStand, // 10 stratagems after falling to the last life
+    AchievementCount,
+} AchievementId;
+
+typedef struct {
+    uint32_t unlocked; // bit per AchievementId
+    uint16_t progress[AchievementCount];
+    uint8_t gatling; // catalog index of the sprint stratagem
+    
+    uint8_t subscribers[AchievementEventCount][AchievementCount];
+    uint8_t subscriber_count[AchievementEventCount];
+    
+    uint32_t dispatched;
+} Achievements;
+
+void achievements_init(Achievements* achievements, uint32_t unlocked);
+
+// Returns the bits this event unlocked
+uint32_t achievements_dispatch(Achievements* achievements, const AchievementEvent* event);
+
+const char* achievement_name(AchievementId id);
+
+// out holds ACHIEVEMENTS_FILE_SIZE bytes
+void achievements_encode(uint32_t unlocked, uint8_t* out);
+
+// Unlock bits from a saved file, 0 if it is not one
+uint32_t achievements_decode(const uint8_t* data, size_t size);
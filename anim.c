@@ -0,0 +1,84 @@
+#include "anim.h"
+
+// Quarter sine wave in Q16, 64 steps plus the end point
+static const uint16_t anim_sin_quarter[65] = {
+    0, 1608, 3216, 4821, 6424, 8022, 9616, 11204,
+    12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062,
+    36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+    46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581,
+    54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+    60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944,
+    64277, 64571, 64827, 65043, 65220, 65358, 65457, 65516,
+    65535,
+};
+
+int32_t anim_ease(AnimEase ease, int32_t t) {
+    if(t <= 0) return 0;
+    if(t >= ANIM_ONE) return ANIM_ONE;
+    
+    switch(ease) {
+        case AnimEaseInQuad:
+            return (int32_t)(((int64_t)t * t) >> 16);
+        case AnimEaseOutQuad:
+            return 2 * t - (int32_t)(((int64_t)t * t) >> 16);
+        case AnimEaseInOutQuad:
+            if(t < ANIM_ONE / 2) {
+                return (int32_t)(((int64_t)t * t) >> 15);
+            } else {
+                int32_t u = ANIM_ONE - t;
+                return ANIM_ONE - (int32_t)(((int64_t)u * u) >> 15);
+            }
+        case AnimEaseStep:
+            return 0;
+        case AnimEaseLinear:
+        default:
+            return t;
+    }
+}
+
+uint32_t anim_duration(const AnimTrack* track) {
+    return track->keys[track->count - 1].time_ms;
+}
+
+bool anim_finished(const AnimTrack* track, uint32_t elapsed_ms) {
+    return !track->loop && elapsed_ms >= anim_duration(track);
+}
+
+int32_t anim_eval(const AnimTrack* track, uint32_t elapsed_ms) {
+    const AnimKey* keys = track->keys;
+    uint32_t duration = anim_duration(track);
+    
+    if(track->loop && duration > 0) {
+        elapsed_ms %= duration;
+    }
+    if(elapsed_ms <= keys[0].time_ms) return keys[0].value;
+    if(elapsed_ms >= duration) return keys[track->count - 1].value;
+    
+    // Tracks are a handful of keys, a scan beats anything cleverer
+    uint8_t i = 1;
+    while(keys[i].time_ms < elapsed_ms) i++;
+    
+    const AnimKey* from = &keys[i - 1];
+    const AnimKey* to = &keys[i];
+    int32_t t = (int32_t)(((elapsed_ms - from->time_ms) << 16) / (to->time_ms - from->time_ms));
+    int32_t eased = anim_ease(from->ease, t);
+    return from->value + (int32_t)(((int64_t)(to->value - from->value) * eased) >> 16);
+}
+
+int32_t anim_sin(uint32_t angle) {
+    angle &= ANIM_TURN - 1;
+    
+    uint32_t quadrant = angle >> 14;
+    uint32_t offset = angle & 0x3FFF;
+    if(quadrant & 1) offset = 0x4000 - offset;
+    
+    // 256 angle units per table step, interpolated linearly
+    uint32_t index = offset >> 8;
+    int32_t value = anim_sin_quarter[index];
+    if(index < 64) {
+        int32_t next = anim_sin_quarter[index + 1];
+        value += ((next - value) * (int32_t)(offset & 0xFF)) >> 8;
+    }
+    return (quadrant & 2) ? -value : value;
+}
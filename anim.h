@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Keyframe animation in Q16 fixed point. Tracks are const tables in flash
+// and are evaluated from elapsed milliseconds, so an animation plays at the
+// same speed whatever the frame rate or timer jitter. Platform-free.
+
+#define ANIM_ONE (1 << 16)
+#define ANIM_INT(value) ((int32_t)(value) * ANIM_ONE)
+#define ANIM_TO_INT(value) ((int32_t)(value) >> 16)
+
+// Angles for anim_sin: a full turn is ANIM_TURN
+#define ANIM_TURN 65536U
+
+typedef enum {
+    AnimEaseLinear,
+    AnimEaseInQuad,
+    AnimEaseOutQuad,
+    AnimEaseInOutQuad,
+    AnimEaseStep, // hold the value until the next key
+} AnimEase;
+
+// ease shapes the segment that starts at this key
+typedef struct {
+    uint16_t time_ms;
+    int32_t value;
+    uint8_t ease;
+} AnimKey;
+
+typedef struct {
+    const AnimKey* keys;
+    uint8_t count;
+    bool loop; // wrap at the last key's time
+} AnimTrack;
+
+#define ANIM_TRACK(keys_, loop_) {(keys_), sizeof(keys_) / sizeof((keys_)[0]), (loop_)}
+
+int32_t anim_eval(const AnimTrack* track, uint32_t elapsed_ms);
+bool anim_finished(const AnimTrack* track, uint32_t elapsed_ms);
+uint32_t anim_duration(const AnimTrack* track);
+
+// Eased Q16 progress t in [0, ANIM_ONE]
+int32_t anim_ease(AnimEase ease, int32_t t);
+
+// Q16 sine of a fraction of ANIM_TURN
+int32_t anim_sin(uint32_t angle);
@@ -0,0 +1,24 @@
+#include "arena.h"
+
+#include <string.h>
+
+void arena_init(Arena* arena, void* memory, size_t size) {
+    arena->base = memory;
+    arena->size = size;
+    arena->used = 0;
+    arena->sealed = false;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size_t slot = ARENA_SLOT(size);
+    if(arena->sealed || slot > arena->size - arena->used) return NULL;
+    
+    void* memory = arena->base + arena->used;
+    arena->used += slot;
+    memset(memory, 0, size);
+    return memory;
+}
+
+void arena_seal(Arena* arena) {
+    arena->sealed = true;
+}
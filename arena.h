@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator over the one block the app takes from the heap at startup.
+// Subsystem buffers are carved from it while the app comes up; once sealed
+// nothing more can be carved, so input, timers and rendering never reach the
+// allocator and cannot fragment the heap. Nothing is freed on its own, the
+// whole block goes back at exit. Platform-free.
+
+#define ARENA_ALIGN 8
+
+// Room a carve of size takes, for sizing the block up front
+#define ARENA_SLOT(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    bool sealed;
+} Arena;
+
+// memory is ARENA_ALIGN-aligned, as malloc's is
+void arena_init(Arena* arena, void* memory, size_t size);
+
+// Zeroed; NULL once the arena is sealed or out of room
+void* arena_alloc(Arena* arena, size_t size);
+
+void arena_seal(Arena* arena);
@@ -0,0 +1,20 @@
+#include "arrow_row.h"
+
+int16_t arrow_row_x(uint8_t length, uint8_t cursor, uint8_t i) {
+    int16_t span = (int16_t)(length > 0 ? length - 1 : 0) * ARROW_ROW_PITCH;
+    int16_t first = (ARROW_ROW_WIDTH - length * ARROW_ROW_PITCH) / 2 + ARROW_ROW_MARGIN;
+    
+    if(span > ARROW_ROW_WIDTH - 1 - 2 * ARROW_ROW_MARGIN) {
+        // Centre the cursor without scrolling past either end
+        int16_t lowest = ARROW_ROW_WIDTH - 1 - ARROW_ROW_MARGIN - span;
+        first = ARROW_ROW_WIDTH / 2 - (int16_t)cursor * ARROW_ROW_PITCH;
+        if(first > ARROW_ROW_MARGIN) first = ARROW_ROW_MARGIN;
+        if(first < lowest) first = lowest;
+    }
+    
+    return first + (int16_t)i * ARROW_ROW_PITCH;
+}
+
+bool arrow_row_visible(int16_t x) {
+    return x >= ARROW_ROW_MARGIN && x <= ARROW_ROW_WIDTH - 1 - ARROW_ROW_MARGIN;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Where the PLAY screen puts a stratagem's arrows. Seven fit across the
+// screen; a longer sequence scrolls so the arrow being entered stays in
+// view, and the arrows it pushes off the edges are not drawn. Coordinates
+// are signed and wide enough for any catalog sequence. Platform-free.
+
+#define ARROW_ROW_PITCH 18
+#define ARROW_ROW_WIDTH 128
+
+// Half an arrow; a visible arrow keeps this much clear of either edge
+#define ARROW_ROW_MARGIN 8
+
+// Centre x of arrow i of a sequence of length arrows while the arrow at
+// cursor is next; may lie off screen
+int16_t arrow_row_x(uint8_t length, uint8_t cursor, uint8_t i);
+
+bool arrow_row_visible(int16_t x);
@@ -0,0 +1,52 @@
+#include "catalog.h"
+#include "stratagem_catalog.h"
+
+#include <string.h>
+
+uint8_t catalog_count(void) {
+    return CATALOG_COUNT;
+}
+
+uint32_t catalog_id(void) {
+    return CATALOG_ID;
+}
+
+const CatalogEntry* catalog_get(uint8_t index) {
+    return &catalog_entries[index];
+}
+
+const char* catalog_name(const CatalogEntry* entry) {
+    return &catalog_string_pool[entry->name_offset];
+}
+
+uint8_t catalog_category_count(void) {
+    return CATALOG_CATEGORY_COUNT;
+}
+
+const char* catalog_category_name(uint8_t category) {
+    return &catalog_string_pool[catalog_category_names[category]];
+}
+
+// Must match name_hash() in the compiler, which picked the seed that makes
+// this collision-free over the catalog names
+static uint32_t catalog_hash(const char* name) {
+    uint32_t hash = 2166136261U ^ CATALOG_HASH_SEED;
+    while(*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619U;
+    }
+    return hash ^ (hash >> 16);
+}
+
+int16_t catalog_find(const char* name) {
+    uint8_t index = catalog_hash_index[catalog_hash(name) & (CATALOG_HASH_SIZE - 1)];
+    if(index == 0xFF) return -1;
+    if(strcmp(catalog_name(&catalog_entries[index]), name) != 0) return -1;
+    return index;
+}
+
+const uint8_t* catalog_icon(uint8_t index, uint16_t* size) {
+    *size = catalog_icon_offsets[index + 1] - catalog_icon_offsets[index];
+    if(*size == 0) return NULL;
+    return &catalog_icon_pool[catalog_icon_offsets[index]];
+}
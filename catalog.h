@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Stratagem catalog compiled from stratagems.txt by tools/catalog_compiler.py.
+// Entries live in flash; arrows are packed two bits each, first arrow lowest.
+
+typedef enum {
+    DIRECTION_UP,
+    DIRECTION_DOWN,
+    DIRECTION_LEFT,
+    DIRECTION_RIGHT,
+    DIRECTION_NONE
+} Direction;
+
+// Icons are 16x16 XBM, heatshrink-compressed one by one
+#define CATALOG_ICON_SIZE 16
+#define CATALOG_ICON_BYTES (CATALOG_ICON_SIZE * CATALOG_ICON_SIZE / 8)
+
+typedef struct {
+    uint32_t sequence;
+    uint16_t name_offset;
+    uint8_t length;
+    uint8_t name_width;
+    uint8_t category_mask;
+} CatalogEntry;
+
+uint8_t catalog_count(void);
+
+// Hash of the entry names in index order, for files that store per-index data
+uint32_t catalog_id(void);
+const CatalogEntry* catalog_get(uint8_t index);
+const char* catalog_name(const CatalogEntry* entry);
+
+uint8_t catalog_category_count(void);
+const char* catalog_category_name(uint8_t category);
+
+// Returns the entry index, or -1 if no stratagem has that name
+int16_t catalog_find(const char* name);
+
+// Compressed icon of an entry, NULL if it has none. An icon stored with
+// CATALOG_ICON_BYTES bytes did not compress and is plain XBM.
+const uint8_t* catalog_icon(uint8_t index, uint16_t* size);
+
+static inline Direction catalog_direction(const CatalogEntry* entry, uint8_t position) {
+    return (Direction)((entry->sequence >> (2 * position)) & 0x3);
+}
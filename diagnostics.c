@@ -0,0 +1,144 @@
+#include "diagnostics.h"
+
+#include <furi.h>
+#include <storage/storage.h>
+#include <string.h>
+
+struct Diagnostics {
+    uint32_t pending[DiagnosticsThreadCount]; // wakeups since the last sample
+    DiagnosticsBucket buckets[DIAGNOSTICS_STATE_MAX];
+    
+    FuriThreadList* thread_list;
+    const char* app_thread_name;
+    uint32_t last_sample;
+};
+
+_Static_assert(sizeof(struct Diagnostics) <= DIAGNOSTICS_ARENA_SIZE, "Diagnostics outgrew its arena share");
+
+// Kernel thread names of the services our callbacks run on; the app thread
+// and the telemetry writer are matched by their own names
+static const char* const diagnostics_thread_names[DiagnosticsThreadCount] = {
+    [DiagnosticsThreadMain] = NULL,
+    [DiagnosticsThreadGui] = "GuiSrv",
+    [DiagnosticsThreadTimer] = "Tmr Svc",
+    [DiagnosticsThreadNotification] = "NotificationSrv",
+    [DiagnosticsThreadTelemetry] = "StratagemHeroTelemetry",
+};
+
+static const char* const diagnostics_thread_labels[DiagnosticsThreadCount] = {
+    [DiagnosticsThreadMain] = "MAIN",
+    [DiagnosticsThreadGui] = "GUI",
+    [DiagnosticsThreadTimer] = "TIMER",
+    [DiagnosticsThreadNotification] = "NOTIFY",
+    [DiagnosticsThreadTelemetry] = "TELEM",
+};
+
+Diagnostics* diagnostics_alloc(Arena* arena) {
+    Diagnostics* diagnostics = arena_alloc(arena, sizeof(Diagnostics));
+    furi_check(diagnostics);
+    
+    diagnostics->thread_list = furi_thread_list_alloc();
+    diagnostics->app_thread_name = furi_thread_get_name(furi_thread_get_current_id());
+    
+    // The first enumeration only primes the run-time counters
+    furi_thread_enumerate(diagnostics->thread_list);
+    diagnostics->last_sample = furi_get_tick();
+    
+    return diagnostics;
+}
+
+void diagnostics_free(Diagnostics* diagnostics) {
+    if(!diagnostics) return;
+    
+    furi_thread_list_free(diagnostics->thread_list);
+}
+
+void diagnostics_wakeup(Diagnostics* diagnostics, DiagnosticsThread thread) {
+    if(!diagnostics) return;
+    __atomic_fetch_add(&diagnostics->pending[thread], 1, __ATOMIC_RELAXED);
+}
+
+void diagnostics_add_wakeups(Diagnostics* diagnostics, DiagnosticsThread thread, uint32_t count) {
+    if(!diagnostics) return;
+    __atomic_fetch_add(&diagnostics->pending[thread], count, __ATOMIC_RELAXED);
+}
+
+void diagnostics_sample(Diagnostics* diagnostics, uint8_t state) {
+    if(!diagnostics || state >= DIAGNOSTICS_STATE_MAX) return;
+    
+    uint32_t now = furi_get_tick();
+    uint32_t elapsed = now - diagnostics->last_sample;
+    diagnostics->last_sample = now;
+    
+    DiagnosticsBucket* bucket = &diagnostics->buckets[state];
+    bucket->time_ms += elapsed;
+    
+    for(uint8_t i = 0; i < DiagnosticsThreadCount; i++) {
+        bucket->wakeups[i] += __atomic_exchange_n(&diagnostics->pending[i], 0, __ATOMIC_RELAXED);
+    }
+    
+    // cpu is the share of run time each thread got since the last call
+    furi_thread_enumerate(diagnostics->thread_list);
+    for(size_t i = 0; i < furi_thread_list_size(diagnostics->thread_list); i++) {
+        const FuriThreadListItem* item = furi_thread_list_get_at(diagnostics->thread_list, i);
+        if(!item->name) continue;
+        
+        for(uint8_t thread = 0; thread < DiagnosticsThreadCount; thread++) {
+            const char* name = diagnostics_thread_names[thread];
+            if(thread == DiagnosticsThreadMain) name = diagnostics->app_thread_name;
+            
+            if(name && strcmp(item->name, name) == 0) {
+                bucket->cpu_ms[thread] += item->cpu * elapsed;
+                break;
+            }
+        }
+    }
+}
+
+const DiagnosticsBucket* diagnostics_get(Diagnostics* diagnostics, uint8_t state) {
+    if(!diagnostics || state >= DIAGNOSTICS_STATE_MAX) return NULL;
+    return &diagnostics->buckets[state];
+}
+
+const char* diagnostics_thread_label(DiagnosticsThread thread) {
+    return diagnostics_thread_labels[thread];
+}
+
+bool diagnostics_export(Diagnostics* diagnostics, const char* path, const char* build, const char* const* state_names) {
+    if(!diagnostics) return false;
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, path, FSAM_WRITE, FSOM_OPEN_APPEND);
+    
+    if(ok && storage_file_size(file) == 0) {
+        const char* header = "build,state,thread,seconds,cpu_percent,wakeups_per_second\n";
+        ok = storage_file_write(file, header, strlen(header)) == strlen(header);
+    }
+    
+    char line[96];
+    for(uint8_t state = 0; ok && state < DIAGNOSTICS_STATE_MAX; state++) {
+        const DiagnosticsBucket* bucket = &diagnostics->buckets[state];
+        if(bucket->time_ms == 0) continue;
+        
+        for(uint8_t thread = 0; ok && thread < DiagnosticsThreadCount; thread++) {
+            int length = snprintf(
+                line,
+                sizeof(line),
+                "%s,%s,%s,%lu.%03lu,%.2f,%.2f\n",
+                build,
+                state_names[state],
+                diagnostics_thread_labels[thread],
+                bucket->time_ms / 1000,
+                bucket->time_ms % 1000,
+                (double)(bucket->cpu_ms[thread] / bucket->time_ms),
+                (double)(bucket->wakeups[thread] * 1000.0f / bucket->time_ms));
+            ok = storage_file_write(file, line, length) == (size_t)length;
+        }
+    }
+    
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return ok;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arena.h"
+
+// Per-thread cost accounting. CPU share comes from the kernel's run-time
+// counters via furi_thread_enumerate(); wakeups are counted by the app at
+// each callback it receives. Both are accumulated per game state so the
+// idle menu can be compared with active play.
+
+#define DIAGNOSTICS_STATE_MAX 8
+
+// What diagnostics_alloc carves from the arena
+#define DIAGNOSTICS_ARENA_SIZE 448
+#define DIAGNOSTICS_SAMPLE_INTERVAL_MS 1000
+
+typedef enum {
+    DiagnosticsThreadMain, // the app thread: main loop, frame building and UART polling
+    DiagnosticsThreadGui, // draw and input callbacks
+    DiagnosticsThreadTimer, // the timer wheel's one-shot FuriTimer
+    DiagnosticsThreadNotification, // every notification_message we queue
+    DiagnosticsThreadTelemetry, // the SD writer
+    DiagnosticsThreadCount,
+} DiagnosticsThread;
+
+typedef struct {
+    uint32_t time_ms;
+    float cpu_ms[DiagnosticsThreadCount]; // CPU percent integrated over time
+    uint32_t wakeups[DiagnosticsThreadCount];
+} DiagnosticsBucket;
+
+typedef struct Diagnostics Diagnostics;
+
+Diagnostics* diagnostics_alloc(Arena* arena);
+void diagnostics_free(Diagnostics* diagnostics);
+
+// Safe from any thread
+void diagnostics_wakeup(Diagnostics* diagnostics, DiagnosticsThread thread);
+void diagnostics_add_wakeups(Diagnostics* diagnostics, DiagnosticsThread thread, uint32_t count);
+
+// Call periodically from the app thread; charges the time and wakeups since
+// the previous sample to the given state
+void diagnostics_sample(Diagnostics* diagnostics, uint8_t state);
+
+const DiagnosticsBucket* diagnostics_get(Diagnostics* diagnostics, uint8_t state);
+const char* diagnostics_thread_label(DiagnosticsThread thread);
+
+// Appends every non-empty state bucket as CSV rows tagged with build
+bool diagnostics_export(Diagnostics* diagnostics, const char* path, const char* build, const char* const* state_names);
@@ -0,0 +1,149 @@
+#include "display_list.h"
+
+#include <string.h>
+
+static DisplayListCommand* display_list_push(DisplayList* list, DisplayListOp op) {
+    if(list->count >= DISPLAY_LIST_MAX_COMMANDS) {
+        list->dropped++;
+        return NULL;
+    }
+    DisplayListCommand* command = &list->commands[list->count++];
+    memset(command, 0, sizeof(DisplayListCommand));
+    command->op = op;
+    return command;
+}
+
+static void display_list_shape(DisplayList* list, DisplayListOp op, int8_t x, int8_t y, uint8_t w, uint8_t h) {
+    DisplayListCommand* command = display_list_push(list, op);
+    if(!command) return;
+    command->x = x;
+    command->y = y;
+    command->w = w;
+    command->h = h;
+}
+
+void display_list_reset(DisplayList* list) {
+    list->count = 0;
+    list->dropped = 0;
+    list->text_size = 0;
+    list->bitmap_count = 0;
+}
+
+void display_list_clear(DisplayList* list) {
+    display_list_push(list, DisplayListOpClear);
+}
+
+void display_list_set_color(DisplayList* list, uint8_t color) {
+    DisplayListCommand* command = display_list_push(list, DisplayListOpColor);
+    if(command) command->arg = color;
+}
+
+void display_list_set_font(DisplayList* list, uint8_t font) {
+    DisplayListCommand* command = display_list_push(list, DisplayListOpFont);
+    if(command) command->arg = font;
+}
+
+void display_list_dot(DisplayList* list, int8_t x, int8_t y) {
+    display_list_shape(list, DisplayListOpDot, x, y, 0, 0);
+}
+
+void display_list_line(DisplayList* list, int8_t x1, int8_t y1, int8_t x2, int8_t y2) {
+    display_list_shape(list, DisplayListOpLine, x1, y1, (uint8_t)x2, (uint8_t)y2);
+}
+
+void display_list_box(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height) {
+    display_list_shape(list, DisplayListOpBox, x, y, width, height);
+}
+
+void display_list_frame(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height) {
+    display_list_shape(list, DisplayListOpFrame, x, y, width, height);
+}
+
+void display_list_circle(DisplayList* list, int8_t x, int8_t y, uint8_t radius) {
+    display_list_shape(list, DisplayListOpCircle, x, y, radius, 0);
+}
+
+static void display_list_text_command(DisplayList* list, DisplayListOp op, uint8_t arg, int8_t x, int8_t y, const char* text) {
+    size_t length = strlen(text) + 1;
+    if(list->text_size + length > DISPLAY_LIST_TEXT_SIZE) {
+        list->dropped++;
+        return;
+    }
+    DisplayListCommand* command = display_list_push(list, op);
+    if(!command) return;
+    
+    memcpy(&list->text[list->text_size], text, length);
+    command->arg = arg;
+    command->x = x;
+    command->y = y;
+    command->w = list->text_size & 0xFF;
+    command->h = list->text_size >> 8;
+    list->text_size += length;
+}
+
+void display_list_str(DisplayList* list, int8_t x, int8_t y, const char* text) {
+    display_list_text_command(list, DisplayListOpStr, 0, x, y, text);
+}
+
+void display_list_str_aligned(
+    DisplayList* list,
+    int8_t x,
+    int8_t y,
+    uint8_t horizontal,
+    uint8_t vertical,
+    const char* text) {
+    display_list_text_command(list, DisplayListOpStrAligned, horizontal | (vertical << 4), x, y, text);
+}
+
+void display_list_xbm(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height, const uint8_t* bitmap) {
+    uint8_t index = 0;
+    while(index < list->bitmap_count && list->bitmaps[index] != bitmap) {
+        index++;
+    }
+    if(index == DISPLAY_LIST_MAX_BITMAPS) {
+        list->dropped++;
+        return;
+    }
+    
+    DisplayListCommand* command = display_list_push(list, DisplayListOpXbm);
+    if(!command) return;
+    if(index == list->bitmap_count) {
+        list->bitmaps[list->bitmap_count++] = bitmap;
+    }
+    command->arg = index;
+    command->x = x;
+    command->y = y;
+    command->w = width;
+    command->h = height;
+}
+
+void display_list_shift(DisplayList* list, int8_t dx, int8_t dy) {
+    display_list_shape(list, DisplayListOpShift, dx, dy, 0, 0);
+}
+
+void display_list_layer_begin(DisplayList* list, uint16_t generation) {
+    display_list_shape(list, DisplayListOpLayerBegin, 0, 0, generation & 0xFF, generation >> 8);
+}
+
+void display_list_layer_end(DisplayList* list) {
+    display_list_push(list, DisplayListOpLayerEnd);
+}
+
+void display_list_transition(DisplayList* list, uint8_t kind, uint8_t progress) {
+    DisplayListCommand* command = display_list_push(list, DisplayListOpTransition);
+    if(!command) return;
+    command->arg = kind;
+    command->w = progress;
+}
+
+const char* display_list_text(const DisplayList* list, const DisplayListCommand* command) {
+    return &list->text[command->w | (command->h << 8)];
+}
+
+const uint8_t* display_list_bitmap(const DisplayList* list, const DisplayListCommand* command) {
+    return list->bitmaps[command->arg];
+}
+
+uint16_t display_list_generation(const DisplayListCommand* command) {
+    return command->w | (command->h << 8);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Recorded draw commands for one frame. The app builds a list on its own
+// threads whenever the scene changes and the draw callback only replays
+// the latest one, so the GUI thread holds the canvas for the raster work
+// alone. Colours, fonts and alignments are stored as the canvas enum
+// values, which the enums below repeat for builders without the GUI
+// headers. Platform-free.
+
+#define DISPLAY_LIST_MAX_COMMANDS 384
+#define DISPLAY_LIST_TEXT_SIZE 256
+#define DISPLAY_LIST_MAX_BITMAPS 4
+
+typedef enum {
+    DisplayListOpClear,
+    DisplayListOpColor, // arg: color
+    DisplayListOpFont, // arg: font
+    DisplayListOpDot, // x, y
+    DisplayListOpLine, // x, y to (int8_t)w, (int8_t)h
+    DisplayListOpBox, // x, y, w, h
+    DisplayListOpFrame, // x, y, w, h
+    DisplayListOpCircle, // x, y, radius in w
+    DisplayListOpStr, // x, y, text offset in w | h << 8
+    DisplayListOpStrAligned, // as Str, arg: horizontal | vertical << 4
+    DisplayListOpXbm, // x, y, w, h, arg: bitmap index
+    DisplayListOpShift, // move the finished frame by x, y
+    // Commands between LayerBegin and LayerEnd draw a layer that only
+    // changes with its generation (w | h << 8), so a replay can restore
+    // its own copy of the raster instead
+    DisplayListOpLayerBegin,
+    DisplayListOpLayerEnd,
+    // Blend the finished frame with the last one of the previous screen,
+    // arg: transition kind, w: progress 0-255
+    DisplayListOpTransition,
+} DisplayListOp;
+
+// Color, Font and Align of gui/canvas.h; stratagem_hero.c checks they match
+typedef enum {
+    DisplayListColorWhite,
+    DisplayListColorBlack,
+} DisplayListColor;
+
+typedef enum {
+    DisplayListFontPrimary,
+    DisplayListFontSecondary,
+} DisplayListFont;
+
+typedef enum {
+    DisplayListAlignLeft,
+    DisplayListAlignRight,
+    DisplayListAlignTop,
+    DisplayListAlignBottom,
+    DisplayListAlignCenter,
+} DisplayListAlign;
+
+typedef struct {
+    uint8_t op;
+    uint8_t arg;
+    int8_t x;
+    int8_t y;
+    uint8_t w;
+    uint8_t h;
+} DisplayListCommand;
+
+typedef struct {
+    DisplayListCommand commands[DISPLAY_LIST_MAX_COMMANDS];
+    uint16_t count;
+    uint16_t dropped; // commands that did not fit, for tuning the sizes
+    
+    char text[DISPLAY_LIST_TEXT_SIZE];
+    uint16_t text_size;
+    
+    const uint8_t* bitmaps[DISPLAY_LIST_MAX_BITMAPS];
+    uint8_t bitmap_count;
+} DisplayList;
+
+void display_list_reset(DisplayList* list);
+
+void display_list_clear(DisplayList* list);
+void display_list_set_color(DisplayList* list, uint8_t color);
+void display_list_set_font(DisplayList* list, uint8_t font);
+void display_list_dot(DisplayList* list, int8_t x, int8_t y);
+void display_list_line(DisplayList* list, int8_t x1, int8_t y1, int8_t x2, int8_t y2);
+void display_list_box(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height);
+void display_list_frame(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height);
+void display_list_circle(DisplayList* list, int8_t x, int8_t y, uint8_t radius);
+
+// The text is copied into the list
+void display_list_str(DisplayList* list, int8_t x, int8_t y, const char* text);
+void display_list_str_aligned(
+    DisplayList* list,
+    int8_t x,
+    int8_t y,
+    uint8_t horizontal,
+    uint8_t vertical,
+    const char* text);
+
+// The bitmap is referenced, it has to outlive the replay
+void display_list_xbm(DisplayList* list, int8_t x, int8_t y, uint8_t width, uint8_t height, const uint8_t* bitmap);
+
+void display_list_shift(DisplayList* list, int8_t dx, int8_t dy);
+void display_list_layer_begin(DisplayList* list, uint16_t generation);
+void display_list_layer_end(DisplayList* list);
+void display_list_transition(DisplayList* list, uint8_t kind, uint8_t progress);
+
+const char* display_list_text(const DisplayList* list, const DisplayListCommand* command);
+const uint8_t* display_list_bitmap(const DisplayList* list, const DisplayListCommand* command);
+uint16_t display_list_generation(const DisplayListCommand* command);
@@ -0,0 +1,127 @@
+#include "dither.h"
+
+#include <string.h>
+
+// Words may alias the byte buffers they are read from
+typedef uint32_t __attribute__((may_alias)) DitherWord;
+
+#define DITHER_ROW_WORDS (DITHER_FRAME_WIDTH / 4)
+
+// Level n sets the pixels whose Bayer threshold is below n, so every level
+// keeps the pixels of the one before it. Bit y of byte x is column x, row y
+// of the 8x8 tile; the first word holds columns 0-3, little-endian.
+static const uint32_t dither_masks[DITHER_LEVELS + 1][2] = {
+    {0x00000000, 0x00000000}, // 0
+    {0x00000001, 0x00000000}, // 1
+    {0x00000001, 0x00000010}, // 2
+    {0x00000001, 0x00000011}, // 3
+    {0x00000011, 0x00000011}, // 4
+    {0x00040011, 0x00000011}, // 5
+    {0x00040011, 0x00400011}, // 6
+    {0x00040011, 0x00440011}, // 7
+    {0x00440011, 0x00440011}, // 8
+    {0x00450011, 0x00440011}, // 9
+    {0x00450011, 0x00540011}, // 10
+    {0x00450011, 0x00550011}, // 11
+    {0x00550011, 0x00550011}, // 12
+    {0x00550015, 0x00550011}, // 13
+    {0x00550015, 0x00550051}, // 14
+    {0x00550015, 0x00550055}, // 15
+    {0x00550055, 0x00550055}, // 16
+    {0x00550255, 0x00550055}, // 17
+    {0x00550255, 0x00552055}, // 18
+    {0x00550255, 0x00552255}, // 19
+    {0x00552255, 0x00552255}, // 20
+    {0x08552255, 0x00552255}, // 21
+    {0x08552255, 0x80552255}, // 22
+    {0x08552255, 0x88552255}, // 23
+    {0x88552255, 0x88552255}, // 24
+    {0x8A552255, 0x88552255}, // 25
+    {0x8A552255, 0xA8552255}, // 26
+    {0x8A552255, 0xAA552255}, // 27
+    {0xAA552255, 0xAA552255}, // 28
+    {0xAA552A55, 0xAA552255}, // 29
+    {0xAA552A55, 0xAA55A255}, // 30
+    {0xAA552A55, 0xAA55AA55}, // 31
+    {0xAA55AA55, 0xAA55AA55}, // 32
+    {0xAA55AB55, 0xAA55AA55}, // 33
+    {0xAA55AB55, 0xAA55BA55}, // 34
+    {0xAA55AB55, 0xAA55BB55}, // 35
+    {0xAA55BB55, 0xAA55BB55}, // 36
+    {0xAE55BB55, 0xAA55BB55}, // 37
+    {0xAE55BB55, 0xEA55BB55}, // 38
+    {0xAE55BB55, 0xEE55BB55}, // 39
+    {0xEE55BB55, 0xEE55BB55}, // 40
+    {0xEF55BB55, 0xEE55BB55}, // 41
+    {0xEF55BB55, 0xFE55BB55}, // 42
+    {0xEF55BB55, 0xFF55BB55}, // 43
+    {0xFF55BB55, 0xFF55BB55}, // 44
+    {0xFF55BF55, 0xFF55BB55}, // 45
+    {0xFF55BF55, 0xFF55FB55}, // 46
+    {0xFF55BF55, 0xFF55FF55}, // 47
+    {0xFF55FF55, 0xFF55FF55}, // 48
+    {0xFF55FF57, 0xFF55FF55}, // 49
+    {0xFF55FF57, 0xFF55FF75}, // 50
+    {0xFF55FF57, 0xFF55FF77}, // 51
+    {0xFF55FF77, 0xFF55FF77}, // 52
+    {0xFF5DFF77, 0xFF55FF77}, // 53
+    {0xFF5DFF77, 0xFFD5FF77}, // 54
+    {0xFF5DFF77, 0xFFDDFF77}, // 55
+    {0xFFDDFF77, 0xFFDDFF77}, // 56
+    {0xFFDFFF77, 0xFFDDFF77}, // 57
+    {0xFFDFFF77, 0xFFFDFF77}, // 58
+    {0xFFDFFF77, 0xFFFFFF77}, // 59
+    {0xFFFFFF77, 0xFFFFFF77}, // 60
+    {0xFFFFFF7F, 0xFFFFFF77}, // 61
+    {0xFFFFFF7F, 0xFFFFFFF7}, // 62
+    {0xFFFFFF7F, 0xFFFFFFFF}, // 63
+    {0xFFFFFFFF, 0xFFFFFFFF}, // 64
+};
+
+void dither_fade(uint8_t* frame, const uint8_t* from, uint8_t level, size_t size) {
+    if(level > DITHER_LEVELS) level = DITHER_LEVELS;
+    
+    DitherWord* restrict out = (DitherWord*)frame;
+    const DitherWord* restrict in = (const DitherWord*)from;
+    uint32_t mask0 = dither_masks[level][0];
+    uint32_t mask1 = dither_masks[level][1];
+    
+    for(size_t i = 0; i < size / 4; i += 2) {
+        out[i] = (out[i] & mask0) | (in[i] & ~mask0);
+        out[i + 1] = (out[i + 1] & mask1) | (in[i + 1] & ~mask1);
+    }
+}
+
+void dither_wipe(uint8_t* frame, const uint8_t* from, uint16_t edge, bool reverse, size_t size) {
+    // One row of masks, then applied to every page. Columns the edge has
+    // passed are all new, the ones it has not reached are all old, and only
+    // the band in between needs the table. p counts from where it starts.
+    uint32_t row[DITHER_ROW_WORDS];
+    uint8_t* row_bytes = (uint8_t*)row;
+    uint16_t solid = edge > DITHER_WIPE_BAND ? edge - DITHER_WIPE_BAND : 0;
+    if(solid > DITHER_FRAME_WIDTH) solid = DITHER_FRAME_WIDTH;
+    uint16_t end = edge < DITHER_FRAME_WIDTH ? edge : DITHER_FRAME_WIDTH;
+    if(reverse) {
+        memset(row_bytes, 0x00, DITHER_FRAME_WIDTH - end);
+        memset(row_bytes + DITHER_FRAME_WIDTH - solid, 0xFF, solid);
+    } else {
+        memset(row_bytes, 0xFF, solid);
+        memset(row_bytes + end, 0x00, DITHER_FRAME_WIDTH - end);
+    }
+    for(uint16_t p = solid; p < end; p++) {
+        uint8_t x = reverse ? DITHER_FRAME_WIDTH - 1 - p : p;
+        const uint8_t* mask = (const uint8_t*)dither_masks[(edge - p) * DITHER_LEVELS / DITHER_WIPE_BAND];
+        row_bytes[x] = mask[x & 7];
+    }
+    
+    DitherWord* restrict out = (DitherWord*)frame;
+    const DitherWord* restrict in = (const DitherWord*)from;
+    for(size_t page = 0; page < size / DITHER_FRAME_WIDTH; page++) {
+        for(uint8_t word = 0; word < DITHER_ROW_WORDS; word++) {
+            uint32_t mask = row[word];
+            out[word] = (out[word] & mask) | (in[word] & ~mask);
+        }
+        out += DITHER_ROW_WORDS;
+        in += DITHER_ROW_WORDS;
+    }
+}
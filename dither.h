@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Ordered-dither blends between two 1bpp frames in the canvas's page layout,
+// where a byte holds 8 pixels down one column. The threshold masks of an 8x8
+// Bayer matrix are a flash table with one entry per coverage level; a mask
+// byte only depends on the column, so a level is two 32-bit words repeating
+// along every page. Blending is one pass of AND/OR over the words with no
+// per-pixel branches. Platform-free.
+
+#define DITHER_LEVELS 64
+#define DITHER_FRAME_WIDTH 128
+
+// Columns the wipe edge takes to go from all old to all new
+#define DITHER_WIPE_BAND 16
+
+// Shows level of DITHER_LEVELS Bayer cells from frame and the rest from
+// from, in place in frame. size is a multiple of 8 bytes.
+void dither_fade(uint8_t* frame, const uint8_t* from, uint8_t level, size_t size);
+
+// frame sweeps in over from, its dithered edge at column edge, which runs
+// from 0 to DITHER_FRAME_WIDTH + DITHER_WIPE_BAND. reverse sweeps in from
+// the right. size is a multiple of DITHER_FRAME_WIDTH.
+void dither_wipe(uint8_t* frame, const uint8_t* from, uint16_t edge, bool reverse, size_t size);
@@ -0,0 +1,44 @@
+#include "frame_budget.h"
+
+#include <string.h>
+
+_Static_assert(FRAME_BUDGET_WINDOW <= 8, "The window is kept in one byte");
+
+void frame_budget_init(FrameBudget* budget, uint32_t cost_budget, uint8_t max_tier) {
+    memset(budget, 0, sizeof(FrameBudget));
+    budget->budget = cost_budget;
+    budget->max_tier = max_tier;
+}
+
+// A new tier starts with a clean window, so it is judged on its own frames
+static FrameBudgetChange frame_budget_change(FrameBudget* budget, FrameBudgetChange change, uint8_t over) {
+    budget->tier += change == FrameBudgetChangeDegraded ? 1 : -1;
+    budget->change_over = over;
+    budget->change_peak = budget->peak;
+    
+    budget->history = 0;
+    budget->headroom = 0;
+    budget->peak = 0;
+    return change;
+}
+
+FrameBudgetChange frame_budget_record(FrameBudget* budget, uint32_t cost) {
+    bool over = cost > budget->budget;
+    budget->history = ((budget->history << 1) | over) & ((1U << FRAME_BUDGET_WINDOW) - 1);
+    if(cost > budget->peak) budget->peak = cost;
+    
+    if(cost < budget->budget / 2) {
+        budget->headroom++;
+    } else {
+        budget->headroom = 0;
+    }
+    
+    uint8_t over_count = __builtin_popcount(budget->history);
+    if(over_count >= FRAME_BUDGET_OVER_LIMIT && budget->tier < budget->max_tier) {
+        return frame_budget_change(budget, FrameBudgetChangeDegraded, over_count);
+    }
+    if(budget->headroom >= FRAME_BUDGET_HEADROOM_FRAMES && budget->tier > 0) {
+        return frame_budget_change(budget, FrameBudgetChangeRestored, over_count);
+    }
+    return FrameBudgetChangeNone;
+}
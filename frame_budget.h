@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame-budget watchdog. The draw callback reports what each frame cost;
+// when too many recent frames ran over budget the watchdog drops one
+// quality tier, and once frames have had headroom for a while it climbs
+// back one. Tier 0 is full quality, the owner decides what each higher
+// tier leaves out. Platform-free.
+
+// Frames looked back on, and how many of them may run over
+#define FRAME_BUDGET_WINDOW 8
+#define FRAME_BUDGET_OVER_LIMIT 3
+
+// Frames in a row under half the budget before a tier comes back
+#define FRAME_BUDGET_HEADROOM_FRAMES 40
+
+typedef enum {
+    FrameBudgetChangeNone,
+    FrameBudgetChangeDegraded,
+    FrameBudgetChangeRestored,
+} FrameBudgetChange;
+
+typedef struct {
+    uint32_t budget;
+    uint8_t max_tier;
+    uint8_t tier;
+    
+    uint8_t history; // bit per frame of the window, set if it ran over
+    uint16_t headroom; // frames in a row under half the budget
+    uint32_t peak; // most expensive frame since the last change
+    
+    // Why the last change happened: frames of the window over budget and
+    // the most expensive frame leading up to it
+    uint8_t change_over;
+    uint32_t change_peak;
+} FrameBudget;
+
+// budget and the costs reported are in the same unit, cycles for the app
+void frame_budget_init(FrameBudget* budget, uint32_t cost_budget, uint8_t max_tier);
+
+// Accounts one frame and says whether it moved the tier
+FrameBudgetChange frame_budget_record(FrameBudget* budget, uint32_t cost);
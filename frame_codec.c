@@ -0,0 +1,69 @@
+#include "frame_codec.h"
+
+static uint8_t frame_codec_crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for(size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint8_t frame_codec_byte(const uint8_t* frame, const uint8_t* previous, size_t i) {
+    return previous ? frame[i] ^ previous[i] : frame[i];
+}
+
+// Control byte n < 128: n + 1 literal bytes follow. n >= 128: the next byte
+// repeats n - 125 times. Runs shorter than 3 stay in the literal, otherwise
+// short runs between literals would cost more than they save.
+static size_t frame_codec_pack(const uint8_t* frame, const uint8_t* previous, uint8_t* out) {
+    size_t size = 0;
+    size_t i = 0;
+    
+    while(i < FRAME_CODEC_FRAME_SIZE) {
+        uint8_t value = frame_codec_byte(frame, previous, i);
+        size_t run = 1;
+        while(i + run < FRAME_CODEC_FRAME_SIZE && run < 130 &&
+              frame_codec_byte(frame, previous, i + run) == value) {
+            run++;
+        }
+        
+        if(run >= 3) {
+            out[size++] = (uint8_t)(run + 125);
+            out[size++] = value;
+            i += run;
+            continue;
+        }
+        
+        size_t start = i;
+        size_t control = size++;
+        while(i < FRAME_CODEC_FRAME_SIZE && i - start < 128) {
+            if(i + 2 < FRAME_CODEC_FRAME_SIZE &&
+               frame_codec_byte(frame, previous, i + 1) == frame_codec_byte(frame, previous, i) &&
+               frame_codec_byte(frame, previous, i + 2) == frame_codec_byte(frame, previous, i)) {
+                break;
+            }
+            out[size++] = frame_codec_byte(frame, previous, i);
+            i++;
+        }
+        out[control] = (uint8_t)(i - start - 1);
+    }
+    
+    return size;
+}
+
+size_t frame_codec_encode(const uint8_t* frame, const uint8_t* previous, uint8_t sequence, uint8_t* out) {
+    size_t payload = frame_codec_pack(frame, previous, &out[FRAME_CODEC_HEADER_SIZE]);
+    
+    out[0] = FRAME_CODEC_SYNC_0;
+    out[1] = FRAME_CODEC_SYNC_1;
+    out[2] = previous ? 0 : FRAME_CODEC_FLAG_KEYFRAME;
+    out[3] = sequence;
+    out[4] = payload & 0xFF;
+    out[5] = payload >> 8;
+    out[FRAME_CODEC_HEADER_SIZE + payload] = frame_codec_crc8(&out[2], FRAME_CODEC_HEADER_SIZE - 2 + payload);
+    
+    return FRAME_CODEC_HEADER_SIZE + payload + 1;
+}
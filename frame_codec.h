@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Wire format for streamed screen frames. A frame is the canvas buffer as
+// u8g2 lays it out: 8 pages of 128 columns, one byte holds 8 vertical
+// pixels with the top one in bit 0. Delta frames XOR against the previous
+// frame, keyframes against nothing; either is then PackBits compressed.
+// Platform-free.
+//
+// Packet: 'F', 'S', flags, sequence, payload length (le16), payload,
+// crc8 over flags through the end of the payload.
+
+#define FRAME_CODEC_WIDTH 128
+#define FRAME_CODEC_HEIGHT 64
+#define FRAME_CODEC_FRAME_SIZE (FRAME_CODEC_WIDTH * FRAME_CODEC_HEIGHT / 8)
+
+#define FRAME_CODEC_SYNC_0 'F'
+#define FRAME_CODEC_SYNC_1 'S'
+#define FRAME_CODEC_HEADER_SIZE 6
+#define FRAME_CODEC_FLAG_KEYFRAME (1 << 0)
+
+// PackBits never grows the data by more than one byte per 128
+#define FRAME_CODEC_MAX_PAYLOAD (FRAME_CODEC_FRAME_SIZE + FRAME_CODEC_FRAME_SIZE / 128)
+#define FRAME_CODEC_MAX_PACKET (FRAME_CODEC_HEADER_SIZE + FRAME_CODEC_MAX_PAYLOAD + 1)
+
+// Encodes frame as a keyframe when previous is NULL, as a delta otherwise.
+// Returns the packet size.
+size_t frame_codec_encode(const uint8_t* frame, const uint8_t* previous, uint8_t sequence, uint8_t* out);
@@ -0,0 +1,165 @@
+#include "frame_stream.h"
+#include "frame_codec.h"
+
+#include <furi.h>
+#include <furi_hal_usb.h>
+#include <furi_hal_usb_cdc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_STREAM_FLAG_FRAME (1 << 0)
+#define FRAME_STREAM_FLAG_STOP (1 << 1)
+#define FRAME_STREAM_FLAG_TX (1 << 2)
+
+#define FRAME_STREAM_THREAD_STACK_SIZE 1024
+#define FRAME_STREAM_TX_TIMEOUT_MS 50
+
+struct FrameStream {
+    // Written by the draw callback while empty, read by the thread while full
+    uint8_t capture[FRAME_CODEC_FRAME_SIZE];
+    bool capture_full;
+    bool running; // cleared under usb_mutex before the port goes back
+    
+    uint8_t current[FRAME_CODEC_FRAME_SIZE];
+    uint8_t previous[FRAME_CODEC_FRAME_SIZE];
+    uint8_t packet[FRAME_CODEC_MAX_PACKET];
+    uint8_t sequence;
+    uint8_t since_keyframe;
+    bool need_keyframe;
+    bool host_open;
+    
+    uint32_t sent;
+    uint32_t dropped;
+    
+    // Held while sending so the USB config never changes under a transfer
+    FuriMutex* usb_mutex;
+    FuriHalUsbInterface* usb_previous;
+    FuriThread* thread;
+};
+
+static void frame_stream_tx_callback(void* context) {
+    FrameStream* stream = context;
+    furi_thread_flags_set(furi_thread_get_id(stream->thread), FRAME_STREAM_FLAG_TX);
+}
+
+// Only send while a host has the port open, and start it off on a keyframe
+static void frame_stream_ctrl_line_callback(void* context, CdcCtrlLine ctrl_lines) {
+    FrameStream* stream = context;
+    bool open = (ctrl_lines & CdcCtrlLineDTR) != 0;
+    if(open && !stream->host_open) {
+        stream->need_keyframe = true;
+    }
+    stream->host_open = open;
+}
+
+static CdcCallbacks frame_stream_cdc_callbacks = {
+    .tx_ep_callback = frame_stream_tx_callback,
+    .ctrl_line_callback = frame_stream_ctrl_line_callback,
+};
+
+static bool frame_stream_send(FrameStream* stream, size_t size) {
+    for(size_t offset = 0; offset < size; offset += CDC_DATA_SZ) {
+        size_t chunk = size - offset < CDC_DATA_SZ ? size - offset : CDC_DATA_SZ;
+        furi_thread_flags_clear(FRAME_STREAM_FLAG_TX);
+        furi_hal_cdc_send(FRAME_STREAM_CDC_INTERFACE, &stream->packet[offset], chunk);
+        uint32_t flags = furi_thread_flags_wait(FRAME_STREAM_FLAG_TX, FuriFlagWaitAny, FRAME_STREAM_TX_TIMEOUT_MS);
+        if(flags & FuriFlagError) return false;
+    }
+    return true;
+}
+
+static int32_t frame_stream_thread(void* context) {
+    FrameStream* stream = context;
+    
+    while(true) {
+        uint32_t flags = furi_thread_flags_wait(
+            FRAME_STREAM_FLAG_FRAME | FRAME_STREAM_FLAG_STOP, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & FuriFlagError) continue;
+        if(flags & FRAME_STREAM_FLAG_STOP) break;
+        if(!__atomic_load_n(&stream->capture_full, __ATOMIC_ACQUIRE)) continue;
+        
+        memcpy(stream->current, stream->capture, FRAME_CODEC_FRAME_SIZE);
+        __atomic_store_n(&stream->capture_full, false, __ATOMIC_RELEASE);
+        
+        furi_mutex_acquire(stream->usb_mutex, FuriWaitForever);
+        if(!stream->running || !stream->host_open) {
+            furi_mutex_release(stream->usb_mutex);
+            continue;
+        }
+        
+        bool keyframe = stream->need_keyframe || stream->since_keyframe >= FRAME_STREAM_KEYFRAME_INTERVAL;
+        size_t size = frame_codec_encode(
+            stream->current, keyframe ? NULL : stream->previous, stream->sequence, stream->packet);
+        
+        // A packet cut short leaves the host mid-delta; resync on a keyframe
+        if(frame_stream_send(stream, size)) {
+            memcpy(stream->previous, stream->current, FRAME_CODEC_FRAME_SIZE);
+            stream->sequence++;
+            stream->since_keyframe = keyframe ? 1 : stream->since_keyframe + 1;
+            stream->need_keyframe = false;
+            __atomic_store_n(&stream->sent, stream->sent + 1, __ATOMIC_RELAXED);
+        } else {
+            stream->need_keyframe = true;
+        }
+        furi_mutex_release(stream->usb_mutex);
+    }
+    
+    return 0;
+}
+
+FrameStream* frame_stream_start(void) {
+    FrameStream* stream = calloc(1, sizeof(FrameStream));
+    if(!stream) return NULL;
+    stream->usb_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    
+    stream->usb_previous = furi_hal_usb_get_config();
+    furi_hal_usb_unlock();
+    furi_hal_usb_set_config(&usb_cdc_dual, NULL);
+    furi_hal_cdc_set_callbacks(FRAME_STREAM_CDC_INTERFACE, &frame_stream_cdc_callbacks, stream);
+    stream->need_keyframe = true;
+    stream->running = true;
+    
+    stream->thread = furi_thread_alloc_ex(
+        "StratagemHeroStream", FRAME_STREAM_THREAD_STACK_SIZE, frame_stream_thread, stream);
+    furi_thread_set_priority(stream->thread, FuriThreadPriorityLow);
+    furi_thread_start(stream->thread);
+    
+    return stream;
+}
+
+void frame_stream_stop(FrameStream* stream) {
+    if(!stream) return;
+    
+    furi_mutex_acquire(stream->usb_mutex, FuriWaitForever);
+    __atomic_store_n(&stream->running, false, __ATOMIC_RELEASE);
+    furi_hal_cdc_set_callbacks(FRAME_STREAM_CDC_INTERFACE, NULL, NULL);
+    furi_hal_usb_set_config(stream->usb_previous, NULL);
+    stream->host_open = false;
+    furi_mutex_release(stream->usb_mutex);
+    
+    furi_thread_flags_set(furi_thread_get_id(stream->thread), FRAME_STREAM_FLAG_STOP);
+    furi_thread_join(stream->thread);
+    furi_thread_free(stream->thread);
+    furi_mutex_free(stream->usb_mutex);
+    free(stream);
+}
+
+void frame_stream_capture(FrameStream* stream, const uint8_t* buffer, size_t size) {
+    if(!stream || !__atomic_load_n(&stream->running, __ATOMIC_ACQUIRE) || size != FRAME_CODEC_FRAME_SIZE) return;
+    
+    if(__atomic_load_n(&stream->capture_full, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&stream->dropped, stream->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(stream->capture, buffer, FRAME_CODEC_FRAME_SIZE);
+    __atomic_store_n(&stream->capture_full, true, __ATOMIC_RELEASE);
+    furi_thread_flags_set(furi_thread_get_id(stream->thread), FRAME_STREAM_FLAG_FRAME);
+}
+
+uint32_t frame_stream_get_sent(FrameStream* stream) {
+    return stream ? __atomic_load_n(&stream->sent, __ATOMIC_RELAXED) : 0;
+}
+
+uint32_t frame_stream_get_dropped(FrameStream* stream) {
+    return stream ? __atomic_load_n(&stream->dropped, __ATOMIC_RELAXED) : 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Streams every presented frame over the second USB CDC port, encoded with
+// frame_codec. The draw callback only hands over a copy of the canvas
+// buffer; encoding and USB transfers happen on a low-priority thread, and a
+// frame that arrives while the previous one is still going out is dropped.
+// The stream, its buffers and its thread only exist while it runs: they
+// come from the heap when it starts and go back when it stops, so a session
+// that never streams does not pay for them. tools/frame_stream.py decodes
+// the stream on the host.
+
+#define FRAME_STREAM_CDC_INTERFACE 1
+#define FRAME_STREAM_KEYFRAME_INTERVAL 30
+
+typedef struct FrameStream FrameStream;
+
+// Switches the USB port to dual CDC and starts the encoder thread. NULL
+// when there is no memory for it.
+FrameStream* frame_stream_start(void);
+
+// Puts the USB port back, ends the thread and frees the stream. The draw
+// callback must no longer be able to reach it.
+void frame_stream_stop(FrameStream* stream);
+
+// Draw callback side; never blocks. stream may be NULL.
+void frame_stream_capture(FrameStream* stream, const uint8_t* buffer, size_t size);
+
+uint32_t frame_stream_get_sent(FrameStream* stream);
+uint32_t frame_stream_get_dropped(FrameStream* stream);
@@ -0,0 +1,139 @@
+#include "game_core.h"
+
+#include <string.h>
+
+// xorshift32, so both devices in a versus match draw the same sequence
+static uint32_t game_random(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static uint8_t game_pick(const GameCore* game, uint32_t random) {
+    if(game->pick) {
+        return game->pick(random, game->pick_context);
+    }
+    return random % catalog_count();
+}
+
+static uint8_t game_next_stratagem(GameCore* game) {
+    game->rng_state = game_random(game->rng_state);
+    return game_pick(game, game->rng_state);
+}
+
+uint8_t game_peek_next(const GameCore* game) {
+    return game_pick(game, game_random(game->rng_state));
+}
+
+static void game_finish_stratagem(GameCore* game) {
+    game->last_stratagem = game->stratagem;
+    game->last_mistakes = game->mistakes;
+    game->last_time = game->stratagem_time;
+    
+    game->stratagem = game_next_stratagem(game);
+    game->input_index = 0;
+    game->mistakes = 0;
+    game->stratagem_time = 0;
+}
+
+void game_init(GameCore* game, GamePickCallback pick, void* pick_context) {
+    memset(game, 0, sizeof(GameCore));
+    game->pick = pick;
+    game->pick_context = pick_context;
+    game->over = true;
+}
+
+static uint32_t game_start(GameCore* game, uint32_t seed) {
+    game->rng_state = seed ? seed : 0x9E3779B9;
+    game->over = false;
+    game->lives = INITIAL_LIVES;
+    game->score = 0;
+    game->level = 0;
+    game->completed = 0;
+    game->time_limit = INITIAL_TIME;
+    game->time_remaining = game->time_limit;
+    game->stratagem = game_next_stratagem(game);
+    game->input_index = 0;
+    game->mistakes = 0;
+    game->stratagem_time = 0;
+    return 0;
+}
+
+// Runs the clock; a stratagem that runs out costs a life and is replaced
+static uint32_t game_advance(GameCore* game, uint32_t dt) {
+    game->stratagem_time += dt;
+    if(dt < game->time_remaining) {
+        game->time_remaining -= dt;
+        return 0;
+    }
+    
+    uint32_t outcome = GameOutcomeTimeout;
+    game->time_remaining = 0;
+    game_finish_stratagem(game);
+    
+    if(game->lives > 0) game->lives--;
+    if(game->lives == 0) {
+        game->over = true;
+        outcome |= GameOutcomeGameOver;
+    } else {
+        game->time_remaining = game->time_limit;
+    }
+    return outcome;
+}
+
+static uint32_t game_key(GameCore* game, Direction direction) {
+    const CatalogEntry* current = catalog_get(game->stratagem);
+    
+    if(direction != catalog_direction(current, game->input_index)) {
+        if(game->mistakes < UINT8_MAX) game->mistakes++;
+        game->input_index = 0;
+        
+        // Leave the final tick's worth rather than timing out on the spot
+        if(game->time_remaining > WRONG_PENALTY) {
+            game->time_remaining -= WRONG_PENALTY;
+        } else if(game->time_remaining > 100) {
+            game->time_remaining = 100;
+        }
+        return GameOutcomeWrong;
+    }
+    
+    game->input_index++;
+    if(game->input_index < current->length) {
+        return GameOutcomeCorrect;
+    }
+    
+    uint32_t outcome = GameOutcomeCorrect | GameOutcomeCompleted;
+    game->score += current->length * 100;
+    if(game->completed < UINT16_MAX) game->completed++;
+    
+    if(game->level < MAX_LEVEL && game->completed % STRATAGEMS_PER_LEVEL == 0) {
+        game->level++;
+        outcome |= GameOutcomeLevelUp;
+    }
+    
+    // The pool is not capped, a fast player banks time
+    game->time_remaining += TIME_BONUS;
+    
+    game_finish_stratagem(game);
+    return outcome;
+}
+
+uint32_t game_step(GameCore* game, const GameEvent* event, uint32_t dt) {
+    if(event->type == GameEventStart) {
+        return game_start(game, event->seed);
+    }
+    if(game->over) return 0;
+    
+    uint32_t outcome = game_advance(game, dt);
+    if(outcome & GameOutcomeGameOver) return outcome;
+    
+    // A key that arrives after its stratagem timed out is simply dropped
+    if(event->type == GameEventKey && !(outcome & GameOutcomeTimeout)) {
+        outcome |= game_key(game, event->direction);
+    }
+    
+    // The time it sat behind the landing animation is not the player's
+    if(event->type == GameEventReveal) game->stratagem_time = 0;
+    return outcome;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "catalog.h"
+
+// Game rules with no furi dependency. The app turns timer ticks and key
+// presses into events and feeds them to game_step() together with the
+// milliseconds elapsed since the previous step; the returned outcome flags
+// tell it which sounds, telemetry and animations to play. The same code
+// runs in tools/balance_sim.c.
+
+#define INITIAL_TIME 10000
+#define TIME_BONUS 2000
+#define WRONG_PENALTY 2000
+#define INITIAL_LIVES 3
+
+// Levels only count progress for the scores; they do not change the rules
+#define MAX_LEVEL 50
+#define STRATAGEMS_PER_LEVEL 10
+
+typedef enum {
+    GameEventStart,
+    GameEventTick,
+    GameEventKey,
+    GameEventReveal, // the current stratagem can be entered from now on
+} GameEventType;
+
+typedef struct {
+    GameEventType type;
+    Direction direction; // GameEventKey
+    uint32_t seed; // GameEventStart
+} GameEvent;
+
+typedef enum {
+    GameOutcomeCorrect = (1 << 0),
+    GameOutcomeWrong = (1 << 1),
+    GameOutcomeCompleted = (1 << 2),
+    GameOutcomeTimeout = (1 << 3),
+    GameOutcomeLevelUp = (1 << 4),
+    GameOutcomeGameOver = (1 << 5),
+} GameOutcome;
+
+// Returns the catalog index to play next from 32 random bits
+typedef uint8_t (*GamePickCallback)(uint32_t random, void* context);
+
+typedef struct {
+    GamePickCallback pick;
+    void* pick_context;
+    
+    uint32_t rng_state;
+    bool over;
+    
+    uint8_t lives;
+    uint32_t score;
+    uint8_t level;
+    uint16_t completed;
+    
+    uint32_t time_limit;
+    uint32_t time_remaining;
+    
+    uint8_t stratagem;
+    uint8_t input_index;
+    uint8_t mistakes;
+    uint32_t stratagem_time; // since its Reveal, or since it was drawn
+    
+    // The stratagem that the last Completed or Timeout outcome was about
+    uint8_t last_stratagem;
+    uint8_t last_mistakes;
+    uint32_t last_time;
+} GameCore;
+
+// pick may be NULL for a uniform draw over the catalog
+void game_init(GameCore* game, GamePickCallback pick, void* pick_context);
+
+uint32_t game_step(GameCore* game, const GameEvent* event, uint32_t dt);
+
+// The stratagem that will follow the current one. A pick callback whose
+// weights change in the meantime may still choose another.
+uint8_t game_peek_next(const GameCore* game);
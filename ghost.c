@@ -0,0 +1,223 @@
+#include "ghost.h"
+
+#include <furi.h>
+#include <storage/storage.h>
+#include <string.h>
+
+#define GHOST_LENGTH_BITS 4
+#define GHOST_LENGTH_MASK ((1 << GHOST_LENGTH_BITS) - 1)
+
+_Static_assert((GHOST_READ_AHEAD & (GHOST_READ_AHEAD - 1)) == 0, "Read-ahead size must be a power of two");
+
+size_t ghost_varint_encode(uint32_t value, uint8_t* out, size_t size) {
+    size_t length = 0;
+    do {
+        if(length >= size) return 0;
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[length++] = byte | (value ? 0x80 : 0);
+    } while(value);
+    return length;
+}
+
+size_t ghost_varint_decode(const uint8_t* data, size_t size, uint32_t* value) {
+    uint32_t result = 0;
+    for(size_t i = 0; i < size && i < 5; i++) {
+        result |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if(!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static void ghost_put_le32(uint8_t* out, uint32_t value) {
+    for(uint8_t i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint32_t ghost_get_le32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+// magic[2], version, reserved, score le32, duration le32, count le16
+static bool ghost_read_header(File* file, uint32_t* score, uint32_t* duration) {
+    uint8_t header[GHOST_HEADER_SIZE];
+    if(storage_file_read(file, header, sizeof(header)) != sizeof(header)) return false;
+    if(header[0] != GHOST_MAGIC_0 || header[1] != GHOST_MAGIC_1 || header[2] != GHOST_VERSION) {
+        return false;
+    }
+    *score = ghost_get_le32(&header[4]);
+    *duration = ghost_get_le32(&header[8]);
+    return true;
+}
+
+void ghost_init(Ghost* ghost) {
+    memset(ghost, 0, sizeof(Ghost));
+}
+
+void ghost_record_start(Ghost* ghost) {
+    ghost->record_size = 0;
+    ghost->record_count = 0;
+    ghost->record_ticks = 0;
+    ghost->record_score = 0;
+    ghost->record_full = false;
+}
+
+void ghost_record_completion(Ghost* ghost, uint32_t elapsed_ms, uint8_t length) {
+    ghost->record_score += length * 100;
+    if(ghost->record_full) return;
+    
+    uint32_t ticks = elapsed_ms / GHOST_TICK_MS;
+    uint32_t delta = ticks - ghost->record_ticks;
+    size_t written = ghost_varint_encode(
+        (delta << GHOST_LENGTH_BITS) | (length & GHOST_LENGTH_MASK),
+        &ghost->record[ghost->record_size],
+        GHOST_RECORD_SIZE - ghost->record_size);
+    
+    // A run too long to store whole is still scored, just not saved
+    if(!written) {
+        ghost->record_full = true;
+        return;
+    }
+    ghost->record_size += written;
+    ghost->record_count++;
+    ghost->record_ticks = ticks;
+}
+
+bool ghost_save_if_best(Ghost* ghost, const char* path, uint32_t duration_ms) {
+    if(ghost->record_full || ghost->record_count == 0) return false;
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    
+    uint32_t best_score = 0;
+    uint32_t best_duration = 0;
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        if(!ghost_read_header(file, &best_score, &best_duration)) best_score = 0;
+    }
+    storage_file_close(file);
+    
+    // Ties go to the quicker run
+    bool better = ghost->record_score > best_score ||
+                  (ghost->record_score == best_score && duration_ms < best_duration);
+    bool saved = false;
+    
+    if(better && storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        uint8_t header[GHOST_HEADER_SIZE] = {GHOST_MAGIC_0, GHOST_MAGIC_1, GHOST_VERSION, 0};
+        ghost_put_le32(&header[4], ghost->record_score);
+        ghost_put_le32(&header[8], duration_ms);
+        header[12] = ghost->record_count & 0xFF;
+        header[13] = ghost->record_count >> 8;
+        
+        saved = storage_file_write(file, header, sizeof(header)) == sizeof(header) &&
+                storage_file_write(file, ghost->record, ghost->record_size) == ghost->record_size;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    
+    return saved;
+}
+
+bool ghost_playback_open(Ghost* ghost, const char* path) {
+    ghost_playback_close(ghost);
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING) ||
+       !ghost_read_header(file, &ghost->best_score, &ghost->best_duration) ||
+       ghost->best_score == 0) {
+        storage_file_close(file);
+        storage_file_free(file);
+        furi_record_close(RECORD_STORAGE);
+        return false;
+    }
+    
+    ghost->file = file;
+    ghost->file_done = false;
+    ghost->ahead_head = 0;
+    ghost->ahead_tail = 0;
+    ghost->ghost_ticks = 0;
+    ghost->ghost_score = 0;
+    ghost->pending = false;
+    
+    ghost_playback_fill(ghost);
+    __atomic_store_n(&ghost->available, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void ghost_playback_fill(Ghost* ghost) {
+    if(!ghost->file || ghost->file_done) return;
+    
+    uint32_t head = ghost->ahead_head;
+    uint32_t tail = __atomic_load_n(&ghost->ahead_tail, __ATOMIC_ACQUIRE);
+    uint32_t space = GHOST_READ_AHEAD - (head - tail);
+    
+    // Top up only once half the ring is free, so reads stay a useful size
+    if(space < GHOST_READ_AHEAD / 2) return;
+    
+    while(space) {
+        uint32_t offset = head & (GHOST_READ_AHEAD - 1);
+        uint32_t chunk = GHOST_READ_AHEAD - offset;
+        if(chunk > space) chunk = space;
+        
+        size_t read = storage_file_read(ghost->file, &ghost->ahead[offset], chunk);
+        head += read;
+        space -= read;
+        if(read < chunk) {
+            ghost->file_done = true;
+            break;
+        }
+    }
+    __atomic_store_n(&ghost->ahead_head, head, __ATOMIC_RELEASE);
+}
+
+void ghost_playback_close(Ghost* ghost) {
+    __atomic_store_n(&ghost->available, false, __ATOMIC_RELEASE);
+    if(!ghost->file) return;
+    
+    storage_file_close(ghost->file);
+    storage_file_free(ghost->file);
+    furi_record_close(RECORD_STORAGE);
+    ghost->file = NULL;
+}
+
+// Decodes the next completion if its varint is fully inside the ring
+static bool ghost_next(Ghost* ghost) {
+    uint32_t tail = ghost->ahead_tail;
+    uint32_t head = __atomic_load_n(&ghost->ahead_head, __ATOMIC_ACQUIRE);
+    
+    uint8_t bytes[5];
+    size_t count = 0;
+    while(count < sizeof(bytes) && tail + count != head) {
+        bytes[count] = ghost->ahead[(tail + count) & (GHOST_READ_AHEAD - 1)];
+        count++;
+    }
+    
+    uint32_t value;
+    size_t used = ghost_varint_decode(bytes, count, &value);
+    if(!used) return false;
+    __atomic_store_n(&ghost->ahead_tail, tail + used, __ATOMIC_RELEASE);
+    
+    ghost->pending = true;
+    ghost->pending_ticks = ghost->ghost_ticks + (value >> GHOST_LENGTH_BITS);
+    ghost->pending_score = ghost->ghost_score + (value & GHOST_LENGTH_MASK) * 100;
+    return true;
+}
+
+uint32_t ghost_score_at(Ghost* ghost, uint32_t elapsed_ms) {
+    if(!__atomic_load_n(&ghost->available, __ATOMIC_ACQUIRE)) return 0;
+    
+    uint32_t ticks = elapsed_ms / GHOST_TICK_MS;
+    while(ghost->pending || ghost_next(ghost)) {
+        if(ghost->pending_ticks > ticks) break;
+        ghost->ghost_ticks = ghost->pending_ticks;
+        ghost->ghost_score = ghost->pending_score;
+        ghost->pending = false;
+    }
+    return ghost->ghost_score;
+}
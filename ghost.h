@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Personal-best ghost. A run is stored as one varint per completed
+// stratagem: (ticks since the previous completion << 4) | arrow count, with
+// ticks of GHOST_TICK_MS, so a typical completion takes two bytes and a
+// five-minute run a few hundred. Playback streams the file through a small
+// read-ahead ring that the app thread refills and the draw callback
+// consumes, so the ghost costs O(1) per frame.
+
+#define GHOST_MAGIC_0 'G'
+#define GHOST_MAGIC_1 'H'
+#define GHOST_VERSION 1
+#define GHOST_HEADER_SIZE 14
+
+#define GHOST_TICK_MS 10
+#define GHOST_RECORD_SIZE 1024
+#define GHOST_READ_AHEAD 64
+
+typedef struct {
+    // Recording, written by whichever thread completes a stratagem
+    uint8_t record[GHOST_RECORD_SIZE];
+    uint16_t record_size;
+    uint16_t record_count;
+    uint32_t record_ticks;
+    uint32_t record_score;
+    bool record_full;
+    
+    // Read-ahead ring: head is only written by the filling thread, tail
+    // only by the consumer
+    uint8_t ahead[GHOST_READ_AHEAD];
+    uint32_t ahead_head;
+    uint32_t ahead_tail;
+    bool file_done;
+    void* file;
+    
+    // Header of the best run being played back
+    bool available;
+    uint32_t best_score;
+    uint32_t best_duration;
+    
+    // Playback cursor
+    uint32_t ghost_ticks;
+    uint32_t ghost_score;
+    bool pending;
+    uint32_t pending_ticks;
+    uint32_t pending_score;
+} Ghost;
+
+void ghost_init(Ghost* ghost);
+
+// Pure encoding helpers; return the bytes written or consumed, 0 on failure
+size_t ghost_varint_encode(uint32_t value, uint8_t* out, size_t size);
+size_t ghost_varint_decode(const uint8_t* data, size_t size, uint32_t* value);
+
+void ghost_record_start(Ghost* ghost);
+void ghost_record_completion(Ghost* ghost, uint32_t elapsed_ms, uint8_t length);
+
+// Saves the recording if it beats the stored best. App thread only.
+bool ghost_save_if_best(Ghost* ghost, const char* path, uint32_t duration_ms);
+
+// Playback control, app thread only
+bool ghost_playback_open(Ghost* ghost, const char* path);
+void ghost_playback_fill(Ghost* ghost);
+void ghost_playback_close(Ghost* ghost);
+
+// Score the best run had reached elapsed_ms into the game. Only moves
+// forward, decoding each completion once; safe to call from the draw
+// callback while the app thread refills.
+uint32_t ghost_score_at(Ghost* ghost, uint32_t elapsed_ms);
@@ -0,0 +1,118 @@
+#include "icon_cache.h"
+
+#include <string.h>
+
+#define ICON_WINDOW_BITS 8
+#define ICON_LOOKAHEAD_BITS 4
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t bit;
+} IconBits;
+
+// Bits go most significant first; -1 once the input runs out
+static int32_t icon_bits_read(IconBits* bits, uint8_t count) {
+    if(bits->bit + count > bits->size * 8) return -1;
+    
+    int32_t value = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t byte = bits->data[bits->bit >> 3];
+        value = (value << 1) | ((byte >> (7 - (bits->bit & 7))) & 1);
+        bits->bit++;
+    }
+    return value;
+}
+
+bool icon_decode(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size) {
+    IconBits bits = {.data = in, .size = in_size};
+    size_t fill = 0;
+    
+    // The stream ends in zero padding that reads as an unfinished
+    // back-reference, so running out of bits is the normal way out
+    while(true) {
+        int32_t tag = icon_bits_read(&bits, 1);
+        if(tag < 0) break;
+        
+        if(tag) {
+            int32_t literal = icon_bits_read(&bits, 8);
+            if(literal < 0) break;
+            if(fill >= out_size) return false;
+            out[fill++] = literal;
+        } else {
+            int32_t distance = icon_bits_read(&bits, ICON_WINDOW_BITS);
+            int32_t length = icon_bits_read(&bits, ICON_LOOKAHEAD_BITS);
+            if(distance < 0 || length < 0) break;
+            distance++;
+            length++;
+            if((size_t)distance > fill || fill + length > out_size) return false;
+            for(int32_t i = 0; i < length; i++, fill++) {
+                out[fill] = out[fill - distance];
+            }
+        }
+    }
+    
+    return fill == out_size;
+}
+
+void icon_cache_init(IconCache* cache) {
+    memset(cache, 0, sizeof(IconCache));
+    memset(cache->keys, ICON_CACHE_EMPTY, sizeof(cache->keys));
+}
+
+static int8_t icon_cache_find(IconCache* cache, uint8_t index) {
+    for(uint8_t slot = 0; slot < ICON_CACHE_SLOTS; slot++) {
+        if(cache->keys[slot] == index) return slot;
+    }
+    return -1;
+}
+
+// Decodes into the least recently used slot; -1 if there is nothing to show
+static int8_t icon_cache_load(IconCache* cache, uint8_t index) {
+    uint16_t size;
+    const uint8_t* data = catalog_icon(index, &size);
+    if(!data) return -1;
+    
+    uint8_t victim = 0;
+    for(uint8_t slot = 1; slot < ICON_CACHE_SLOTS; slot++) {
+        if(cache->used[slot] < cache->used[victim]) victim = slot;
+    }
+    
+    uint8_t* bitmap = cache->bitmaps[victim];
+    if(size == CATALOG_ICON_BYTES) {
+        memcpy(bitmap, data, CATALOG_ICON_BYTES);
+    } else if(!icon_decode(data, size, bitmap, CATALOG_ICON_BYTES)) {
+        cache->keys[victim] = ICON_CACHE_EMPTY;
+        cache->used[victim] = 0;
+        return -1;
+    }
+    cache->keys[victim] = index;
+    return victim;
+}
+
+const uint8_t* icon_cache_get(IconCache* cache, uint8_t index) {
+    int8_t slot = icon_cache_find(cache, index);
+    if(slot >= 0) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+        slot = icon_cache_load(cache, index);
+        if(slot < 0) return NULL;
+    }
+    
+    cache->used[slot] = ++cache->clock;
+    return cache->bitmaps[slot];
+}
+
+bool icon_cache_prefetch(IconCache* cache, uint8_t index) {
+    int8_t slot = icon_cache_find(cache, index);
+    bool decoded = false;
+    if(slot < 0) {
+        slot = icon_cache_load(cache, index);
+        if(slot < 0) return false;
+        decoded = true;
+    }
+    
+    cache->used[slot] = ++cache->clock;
+    return decoded;
+}
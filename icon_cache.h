@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "catalog.h"
+
+// Decoded stratagem icons. The catalog keeps every icon compressed in
+// flash; the few in use are decoded into a small LRU cache of XBM bitmaps,
+// and the app prefetches the next stratagem's icon while the current one is
+// being entered so showing it is a hit. Platform-free.
+
+// A display list that still shows the current icon may be replayed after
+// the next one is prefetched, so the cache must hold both plus the one
+// being evicted
+#define ICON_CACHE_SLOTS 4
+#define ICON_CACHE_EMPTY 0xFF
+
+typedef struct {
+    uint8_t bitmaps[ICON_CACHE_SLOTS][CATALOG_ICON_BYTES];
+    uint8_t keys[ICON_CACHE_SLOTS];
+    uint32_t used[ICON_CACHE_SLOTS]; // clock of the last use
+    uint32_t clock;
+    
+    uint32_t hits;
+    uint32_t misses;
+} IconCache;
+
+void icon_cache_init(IconCache* cache);
+
+// The icon of a catalog entry, decoded into the least recently used slot on
+// a miss; NULL if the entry has none or it does not decode
+const uint8_t* icon_cache_get(IconCache* cache, uint8_t index);
+
+// Decodes an icon ahead of its use without counting toward the hit rate.
+// Returns whether it had to decode.
+bool icon_cache_prefetch(IconCache* cache, uint8_t index);
+
+// heatshrink with an 8-bit window and 4-bit lookahead, as the catalog
+// compiler writes it. True if in decodes to exactly out_size bytes.
+bool icon_decode(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size);
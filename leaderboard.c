@@ -0,0 +1,190 @@
+#include "leaderboard.h"
+
+#define LEADERBOARD_HASH_PRIME 16777619U
+
+uint32_t leaderboard_hash(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= LEADERBOARD_HASH_PRIME;
+    }
+    return hash;
+}
+
+static uint8_t leaderboard_crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for(size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t* leaderboard_put(uint8_t* out, uint32_t value, uint8_t size) {
+    for(uint8_t i = 0; i < size; i++) {
+        *out++ = (value >> (8 * i)) & 0xFF;
+    }
+    return out;
+}
+
+static uint32_t leaderboard_get(const uint8_t* data, uint8_t size) {
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < size; i++) {
+        value |= (uint32_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+// Total order, so the board comes out the same whatever order the files
+// are merged in: higher score first, ties go to the lower run hash
+static bool leaderboard_better(const LeaderboardRecord* a, const LeaderboardRecord* b) {
+    if(a->score != b->score) return a->score > b->score;
+    return a->run_hash < b->run_hash;
+}
+
+static void leaderboard_swap(LeaderboardRecord* a, LeaderboardRecord* b) {
+    LeaderboardRecord t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void leaderboard_sift_down(LeaderboardRecord* entries, uint16_t count, uint16_t index) {
+    while(true) {
+        uint16_t worst = index;
+        uint16_t left = 2 * index + 1;
+        uint16_t right = left + 1;
+        if(left < count && leaderboard_better(&entries[worst], &entries[left])) worst = left;
+        if(right < count && leaderboard_better(&entries[worst], &entries[right])) worst = right;
+        if(worst == index) return;
+        leaderboard_swap(&entries[index], &entries[worst]);
+        index = worst;
+    }
+}
+
+void leaderboard_init(Leaderboard* board, LeaderboardRecord* entries, uint16_t capacity) {
+    board->entries = entries;
+    board->capacity = capacity;
+    board->count = 0;
+    board->offered = 0;
+    board->duplicates = 0;
+    board->corrupt = 0;
+}
+
+bool leaderboard_offer(Leaderboard* board, const LeaderboardRecord* record) {
+    board->offered++;
+    if(board->capacity == 0) return false;
+    
+    // Most records of a big merge stop here, against the root
+    bool full = board->count == board->capacity;
+    if(full && !leaderboard_better(record, &board->entries[0])) return false;
+    
+    // Only runs on the board need checking: an evicted copy ranked at or
+    // below the root, so it can never get back past it
+    for(uint16_t i = 0; i < board->count; i++) {
+        if(board->entries[i].run_hash == record->run_hash) {
+            board->duplicates++;
+            return false;
+        }
+    }
+    
+    if(full) {
+        board->entries[0] = *record;
+        leaderboard_sift_down(board->entries, board->count, 0);
+        return true;
+    }
+    
+    uint16_t index = board->count++;
+    board->entries[index] = *record;
+    while(index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if(!leaderboard_better(&board->entries[parent], &board->entries[index])) break;
+        leaderboard_swap(&board->entries[parent], &board->entries[index]);
+        index = parent;
+    }
+    return true;
+}
+
+void leaderboard_sort(Leaderboard* board) {
+    // Heap sort: popping the worst to the back leaves the best in front
+    for(uint16_t end = board->count; end > 1; end--) {
+        leaderboard_swap(&board->entries[0], &board->entries[end - 1]);
+        leaderboard_sift_down(board->entries, end - 1, 0);
+    }
+}
+
+void leaderboard_encode_header(uint32_t device_id, uint8_t* out) {
+    out[0] = LEADERBOARD_MAGIC_0;
+    out[1] = LEADERBOARD_MAGIC_1;
+    out[2] = LEADERBOARD_VERSION;
+    out[3] = LEADERBOARD_RECORD_SIZE;
+    leaderboard_put(&out[4], device_id, 4);
+}
+
+void leaderboard_encode_record(const LeaderboardRecord* record, uint8_t* out) {
+    uint8_t* p = out;
+    p = leaderboard_put(p, record->run_hash, 4);
+    p = leaderboard_put(p, record->device_id, 4);
+    p = leaderboard_put(p, record->score, 4);
+    p = leaderboard_put(p, record->completed, 2);
+    *p++ = record->level;
+    *p = leaderboard_crc8(out, LEADERBOARD_RECORD_SIZE - 1);
+}
+
+void leaderboard_reader_init(LeaderboardReader* reader) {
+    reader->fill = 0;
+    reader->header_done = false;
+    reader->invalid = false;
+    reader->device_id = 0;
+}
+
+static void leaderboard_reader_take(LeaderboardReader* reader, Leaderboard* board) {
+    const uint8_t* data = reader->buffer;
+    
+    if(!reader->header_done) {
+        reader->header_done = true;
+        if(data[0] != LEADERBOARD_MAGIC_0 || data[1] != LEADERBOARD_MAGIC_1 ||
+           data[2] != LEADERBOARD_VERSION || data[3] != LEADERBOARD_RECORD_SIZE) {
+            reader->invalid = true;
+            return;
+        }
+        reader->device_id = leaderboard_get(&data[4], 4);
+        return;
+    }
+    
+    // A torn append or a flipped bit loses that record, not the file
+    if(leaderboard_crc8(data, LEADERBOARD_RECORD_SIZE - 1) != data[LEADERBOARD_RECORD_SIZE - 1]) {
+        board->corrupt++;
+        return;
+    }
+    
+    LeaderboardRecord record = {
+        .run_hash = leaderboard_get(&data[0], 4),
+        .device_id = leaderboard_get(&data[4], 4),
+        .score = leaderboard_get(&data[8], 4),
+        .completed = leaderboard_get(&data[12], 2),
+        .level = data[14],
+    };
+    leaderboard_offer(board, &record);
+}
+
+bool leaderboard_reader_feed(LeaderboardReader* reader, Leaderboard* board, const uint8_t* data, size_t size) {
+    while(size > 0 && !reader->invalid) {
+        uint8_t want = reader->header_done ? LEADERBOARD_RECORD_SIZE : LEADERBOARD_HEADER_SIZE;
+        uint8_t take = want - reader->fill;
+        if(take > size) take = size;
+        
+        for(uint8_t i = 0; i < take; i++) {
+            reader->buffer[reader->fill++] = data[i];
+        }
+        data += take;
+        size -= take;
+        
+        if(reader->fill == want) {
+            reader->fill = 0;
+            leaderboard_reader_take(reader, board);
+        }
+    }
+    return !reader->invalid;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Shared leaderboard for several devices. Every device appends its finished
+// classic runs to its own score file; score files copied over from other
+// devices are merged with it into one top-N board. Records stream through a
+// bounded min-heap, so the merge needs the same memory however many files
+// and records go in, and a run found in more than one file counts once,
+// keyed by its run hash. Platform-free, the host tool uses the same code.
+//
+// File: 'L' 'B' version record-size, le32 id of the device that wrote it,
+// then records until the end. Record: le32 run hash, le32 device id, le32
+// score, le16 stratagems completed, level, crc8 over the first 15 bytes.
+
+#define LEADERBOARD_MAGIC_0 'L'
+#define LEADERBOARD_MAGIC_1 'B'
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_HEADER_SIZE 8
+#define LEADERBOARD_RECORD_SIZE 16
+
+#define LEADERBOARD_HASH_INIT 2166136261U
+
+typedef struct {
+    uint32_t run_hash;
+    uint32_t device_id;
+    uint32_t score;
+    uint16_t completed;
+    uint8_t level;
+} LeaderboardRecord;
+
+// Min-heap over caller-provided entries: the worst kept run sits at the root
+typedef struct {
+    LeaderboardRecord* entries;
+    uint16_t capacity;
+    uint16_t count;
+    
+    uint32_t offered;
+    uint32_t duplicates;
+    uint32_t corrupt; // records failing their crc
+} Leaderboard;
+
+// Streaming parser state for one score file
+typedef struct {
+    uint8_t buffer[LEADERBOARD_RECORD_SIZE];
+    uint8_t fill;
+    bool header_done;
+    bool invalid;
+    uint32_t device_id;
+} LeaderboardReader;
+
+// FNV-1a, chainable from LEADERBOARD_HASH_INIT
+uint32_t leaderboard_hash(uint32_t hash, const void* data, size_t size);
+
+void leaderboard_init(Leaderboard* board, LeaderboardRecord* entries, uint16_t capacity);
+
+// False if the run did not make the board or is already on it
+bool leaderboard_offer(Leaderboard* board, const LeaderboardRecord* record);
+
+// Orders the entries best first; the board is no longer a heap afterwards
+// and has to be re-initialised before the next merge
+void leaderboard_sort(Leaderboard* board);
+
+// out holds LEADERBOARD_HEADER_SIZE and LEADERBOARD_RECORD_SIZE bytes
+void leaderboard_encode_header(uint32_t device_id, uint8_t* out);
+void leaderboard_encode_record(const LeaderboardRecord* record, uint8_t* out);
+
+void leaderboard_reader_init(LeaderboardReader* reader);
+
+// Feeds the next chunk of a score file into the board, in any chunk size.
+// Returns false once the header shows it is not a score file.
+bool leaderboard_reader_feed(LeaderboardReader* reader, Leaderboard* board, const uint8_t* data, size_t size);
@@ -0,0 +1,42 @@
+#include "notify_gate.h"
+
+#include <string.h>
+
+void notify_gate_init(NotifyGate* gate, uint32_t now) {
+    memset(gate, 0, sizeof(NotifyGate));
+    for(uint8_t i = 0; i < NOTIFY_GATE_DEPTH; i++) {
+        gate->ends[i] = now;
+    }
+}
+
+void notify_gate_reset(NotifyGate* gate, uint32_t now) {
+    for(uint8_t i = 0; i < NOTIFY_GATE_DEPTH; i++) {
+        gate->ends[i] = now;
+    }
+}
+
+bool notify_gate_admit(NotifyGate* gate, uint32_t now, uint32_t duration, bool essential) {
+    // Sequences are posted back to back, so the newest one ends last
+    uint8_t queued = 0;
+    uint32_t backlog = 0;
+    for(uint8_t i = 0; i < NOTIFY_GATE_DEPTH; i++) {
+        int32_t left = (int32_t)(gate->ends[i] - now);
+        if(left > 0) {
+            queued++;
+            if((uint32_t)left > backlog) backlog = left;
+        }
+    }
+    
+    if(!essential && (queued >= NOTIFY_GATE_DEPTH || backlog > NOTIFY_GATE_BACKLOG_MS)) {
+        gate->dropped++;
+        return false;
+    }
+    
+    gate->ends[gate->next] = now + backlog + duration;
+    gate->next = (gate->next + 1) % NOTIFY_GATE_DEPTH;
+    gate->posted++;
+    if(backlog + duration > gate->backlog_peak) {
+        gate->backlog_peak = backlog + duration;
+    }
+    return true;
+}
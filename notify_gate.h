@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Keeps feedback from piling up in the notification service. The service
+// plays one sequence at a time from a short queue and notification_message()
+// blocks once that queue is full, so a burst of inputs would stall the
+// caller, game_mutex and all, for as long as the queued sequences take to
+// play. The gate estimates when each posted sequence ends and turns new ones
+// away while the service is too far behind. Platform-free.
+
+// Sequences that may be waiting or playing, and how far behind in ms the
+// service may be, before feedback is dropped
+#define NOTIFY_GATE_DEPTH 4
+#define NOTIFY_GATE_BACKLOG_MS 250
+
+typedef struct {
+    uint32_t ends[NOTIFY_GATE_DEPTH]; // when the last posted sequences finish
+    uint8_t next; // oldest of them, overwritten next
+    
+    uint32_t posted;
+    uint32_t dropped;
+    uint32_t backlog_peak; // ms
+} NotifyGate;
+
+void notify_gate_init(NotifyGate* gate, uint32_t now);
+
+// Whether a sequence playing for duration ms may be posted at now, and
+// accounts it if so. Essential sequences always are.
+bool notify_gate_admit(NotifyGate* gate, uint32_t now, uint32_t duration, bool essential);
+
+// Forgets the sequences still booked, for a caller that has cut off what
+// it posted; the counters stay
+void notify_gate_reset(NotifyGate* gate, uint32_t now);
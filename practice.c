@@ -0,0 +1,175 @@
+#include "practice.h"
+
+#include <string.h>
+
+// Bijective 32-bit mix, for more random bits than the caller handed in
+static uint32_t practice_mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    return x ^ (x >> 16);
+}
+
+static uint16_t practice_weight(const PracticeStats* stats) {
+    // Laplace-smoothed failure rate, so an unseen code starts at one half
+    uint32_t error = (uint32_t)PRACTICE_WEIGHT_ERROR * (stats->failures + 1) / (stats->attempts + 2);
+    
+    uint32_t arrow_ms = stats->arrow_ms;
+    if(stats->attempts == stats->failures) arrow_ms = PRACTICE_SLOW_ARROW_MS / 2;
+    if(arrow_ms > PRACTICE_SLOW_ARROW_MS) arrow_ms = PRACTICE_SLOW_ARROW_MS;
+    uint32_t time = (uint32_t)PRACTICE_WEIGHT_TIME * arrow_ms / PRACTICE_SLOW_ARROW_MS;
+    
+    return PRACTICE_WEIGHT_BASE + error + time;
+}
+
+// Vose's alias method: O(n) to build, after which every sample is one
+// column pick and one biased coin flip.
+static void practice_build_alias(Practice* practice) {
+    uint8_t n = practice->count;
+    uint8_t small_count = 0;
+    uint8_t large_count = 0;
+    
+    memcpy(practice->table_weight, practice->weight, n * sizeof(uint16_t));
+    practice->table_total = practice->total_weight;
+    practice->base_total = practice->total_weight;
+    practice->extra_total = 0;
+    practice->dirty_count = 0;
+    
+    // Work in weight * n so the mean column height is total_weight
+    for(uint8_t i = 0; i < n; i++) {
+        practice->prob[i] = (uint32_t)practice->weight[i] * n;
+        if(practice->prob[i] < practice->total_weight) {
+            practice->small[small_count++] = i;
+        } else {
+            practice->large[large_count++] = i;
+        }
+    }
+    
+    while(small_count && large_count) {
+        uint8_t less = practice->small[--small_count];
+        uint8_t more = practice->large[--large_count];
+        
+        practice->alias[less] = more;
+        practice->prob[more] -= practice->total_weight - practice->prob[less];
+        practice->prob[less] = (uint32_t)(((uint64_t)practice->prob[less] * PRACTICE_PROB_ONE) / practice->total_weight);
+        
+        if(practice->prob[more] < practice->total_weight) {
+            practice->small[small_count++] = more;
+        } else {
+            practice->large[large_count++] = more;
+        }
+    }
+    
+    // Whatever is left is full height, up to rounding
+    while(large_count) {
+        uint8_t i = practice->large[--large_count];
+        practice->prob[i] = PRACTICE_PROB_ONE;
+        practice->alias[i] = i;
+    }
+    while(small_count) {
+        uint8_t i = practice->small[--small_count];
+        practice->prob[i] = PRACTICE_PROB_ONE;
+        practice->alias[i] = i;
+    }
+}
+
+void practice_init(Practice* practice, uint8_t count) {
+    memset(practice, 0, sizeof(Practice));
+    practice->count = count > PRACTICE_MAX_ENTRIES ? PRACTICE_MAX_ENTRIES : count;
+    practice_refresh(practice);
+}
+
+void practice_refresh(Practice* practice) {
+    practice->total_weight = 0;
+    for(uint8_t i = 0; i < practice->count; i++) {
+        practice->weight[i] = practice_weight(&practice->stats[i]);
+        practice->total_weight += practice->weight[i];
+    }
+    practice_build_alias(practice);
+}
+
+void practice_record(Practice* practice, uint8_t index, bool clean, uint8_t length, uint32_t time_ms) {
+    if(index >= practice->count) return;
+    
+    PracticeStats* stats = &practice->stats[index];
+    
+    // Halve old history instead of saturating, so the rate keeps adapting
+    if(stats->attempts == UINT16_MAX) {
+        stats->attempts /= 2;
+        stats->failures /= 2;
+    }
+    stats->attempts++;
+    
+    if(!clean) {
+        stats->failures++;
+    } else if(length) {
+        uint32_t arrow_ms = time_ms / length;
+        if(arrow_ms > UINT16_MAX) arrow_ms = UINT16_MAX;
+        
+        // The first completion seeds the average, later ones move it by 1/4
+        if(stats->attempts - stats->failures == 1) {
+            stats->arrow_ms = arrow_ms;
+        } else {
+            stats->arrow_ms = (uint16_t)(((uint32_t)stats->arrow_ms * 3 + arrow_ms) / 4);
+        }
+    }
+    
+    // Only one weight changed, so the totals are patched rather than summed
+    uint16_t weight = practice_weight(stats);
+    uint16_t table = practice->table_weight[index];
+    uint16_t old = practice->weight[index];
+    practice->base_total -= old < table ? old : table;
+    practice->extra_total -= old > table ? old - table : 0;
+    practice->base_total += weight < table ? weight : table;
+    practice->extra_total += weight > table ? weight - table : 0;
+    practice->total_weight = practice->total_weight - old + weight;
+    practice->weight[index] = weight;
+    
+    bool listed = false;
+    for(uint8_t i = 0; i < practice->dirty_count; i++) {
+        if(practice->dirty[i] == index) listed = true;
+    }
+    if(!listed && practice->dirty_count == PRACTICE_DIRTY_MAX) {
+        practice_build_alias(practice);
+        return;
+    }
+    if(!listed) practice->dirty[practice->dirty_count++] = index;
+    
+    // Past half the table rejected, a sample would average over two draws
+    if(practice->base_total < practice->table_total / 2) {
+        practice_build_alias(practice);
+    }
+}
+
+uint8_t practice_sample(const Practice* practice, uint32_t random) {
+    if(practice->extra_total) {
+        uint32_t total = practice->base_total + practice->extra_total;
+        uint32_t pick = (uint32_t)(((uint64_t)random * total) >> 32);
+        if(pick < practice->extra_total) {
+            for(uint8_t i = 0; i < practice->dirty_count; i++) {
+                uint8_t index = practice->dirty[i];
+                uint16_t weight = practice->weight[index];
+                uint16_t table = practice->table_weight[index];
+                if(weight <= table) continue;
+                if(pick < (uint32_t)(weight - table)) return index;
+                pick -= weight - table;
+            }
+        }
+        random = practice_mix(random);
+    }
+    
+    for(;;) {
+        uint8_t column = (uint8_t)(((random & 0xFFFF) * practice->count) >> 16);
+        uint32_t coin = random >> 16;
+        uint8_t index = coin < practice->prob[column] ? column : practice->alias[column];
+        
+        // An entry below its table weight keeps weight / table_weight of its draws
+        uint16_t weight = practice->weight[index];
+        uint16_t table = practice->table_weight[index];
+        if(weight >= table) return index;
+        random = practice_mix(random);
+        if((uint64_t)(random >> 16) * table < ((uint64_t)weight << 16)) return index;
+        random = practice_mix(random);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Adaptive stratagem picker for practice mode. Per-stratagem stats turn into
+// weights favouring codes the player gets wrong or types slowly, and a Vose
+// alias table over those weights gives O(1) sampling. Platform-free.
+
+#define PRACTICE_MAX_ENTRIES 254
+
+// Entries whose weight may change before the alias table is rebuilt
+#define PRACTICE_DIRTY_MAX 16
+
+// Weight terms, in arbitrary integer units
+#define PRACTICE_WEIGHT_BASE 16
+#define PRACTICE_WEIGHT_ERROR 512
+#define PRACTICE_WEIGHT_TIME 256
+#define PRACTICE_SLOW_ARROW_MS 600
+
+#define PRACTICE_PROB_ONE (1UL << 16)
+
+typedef struct {
+    uint16_t attempts;
+    uint16_t failures;
+    uint16_t arrow_ms; // running average time per arrow of completed attempts
+} PracticeStats;
+
+typedef struct {
+    uint8_t count;
+    PracticeStats stats[PRACTICE_MAX_ENTRIES];
+    
+    uint16_t weight[PRACTICE_MAX_ENTRIES];
+    uint32_t total_weight;
+    
+    // Alias table over table_weight: column i keeps i with probability
+    // prob[i] / 2^16, otherwise yields alias[i]
+    uint16_t table_weight[PRACTICE_MAX_ENTRIES];
+    uint32_t table_total;
+    uint32_t prob[PRACTICE_MAX_ENTRIES];
+    uint8_t alias[PRACTICE_MAX_ENTRIES];
+    uint8_t small[PRACTICE_MAX_ENTRIES];
+    uint8_t large[PRACTICE_MAX_ENTRIES];
+    
+    // Entries whose weight moved off table_weight since the build. What
+    // they gained is drawn from directly, what they lost is taken back by
+    // rejecting that share of their table draws.
+    uint8_t dirty[PRACTICE_DIRTY_MAX];
+    uint8_t dirty_count;
+    uint32_t base_total; // sum of min(weight, table_weight)
+    uint32_t extra_total; // sum of weight above table_weight
+} Practice;
+
+void practice_init(Practice* practice, uint8_t count);
+
+// Recomputes every weight from stats, e.g. after loading them from storage
+void practice_refresh(Practice* practice);
+
+// clean: completed without a mistake. time_ms only counts for clean attempts.
+// Patches the sampler in O(PRACTICE_DIRTY_MAX); the O(n) alias table rebuild
+// only runs once that many entries changed or rejection got too likely.
+void practice_record(Practice* practice, uint8_t index, bool clean, uint8_t length, uint32_t time_ms);
+
+// Any 32 random bits in, a weighted stratagem index out
+uint8_t practice_sample(const Practice* practice, uint32_t random);
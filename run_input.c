@@ -0,0 +1,46 @@
+#include "run_input.h"
+
+#include <string.h>
+
+void run_input_init(RunInput* input, RunInputApply apply, void* context) {
+    memset(input, 0, sizeof(RunInput));
+    input->apply = apply;
+    input->context = context;
+}
+
+void run_input_reset(RunInput* input) {
+    input->head = 0;
+    input->tail = 0;
+}
+
+static void run_input_push(RunInput* input, Direction direction) {
+    uint8_t next = (input->head + 1) % RUN_INPUT_TYPE_AHEAD;
+    if(next == input->tail) return;
+    
+    input->queue[input->head] = direction;
+    input->head = next;
+}
+
+void run_input_key(RunInput* input, Direction direction, RunPhase phase) {
+    phase = run_input_drain(input, phase);
+    if(phase == RunPhasePlay) {
+        input->apply(direction, input->context);
+    } else {
+        run_input_push(input, direction);
+    }
+}
+
+RunPhase run_input_drain(RunInput* input, RunPhase phase) {
+    while(input->tail != input->head && phase == RunPhasePlay) {
+        Direction direction = input->queue[input->tail];
+        input->tail = (input->tail + 1) % RUN_INPUT_TYPE_AHEAD;
+        phase = run_input_next_phase(phase, input->apply(direction, input->context));
+    }
+    return phase;
+}
+
+RunPhase run_input_next_phase(RunPhase phase, uint32_t outcome) {
+    if(outcome & GameOutcomeGameOver) return RunPhaseOver;
+    if(outcome & GameOutcomeCompleted) return RunPhaseLanding;
+    return phase;
+}
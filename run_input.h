@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "game_core.h"
+
+// The arrow keys of a run on their way to the core. Keys typed while the
+// capsule lands belong to the next stratagem: they wait in a short ring and
+// reach the core in order once it is back on PLAY, instead of racing the
+// animation. The app and tools/input_stress.c feed keys through the same
+// code. Platform-free.
+
+#define RUN_INPUT_TYPE_AHEAD 8
+
+// Keys are acted on at the press. Built with STRATAGEM_HERO_INPUT_ON_SHORT
+// they wait for the Short or Long the input service sends once the key is
+// let go or held, as they used to, to compare the latency against.
+#ifdef STRATAGEM_HERO_INPUT_ON_SHORT
+#define RUN_INPUT_ON_PRESS false
+#else
+#define RUN_INPUT_ON_PRESS true
+#endif
+
+typedef enum {
+    RunPhasePlay,
+    RunPhaseLanding, // keys wait for the capsule
+    RunPhaseOver,
+} RunPhase;
+
+// Steps the core with one arrow at the owner's clock and acts on what it
+// did; returns the core's GameOutcome flags
+typedef uint32_t (*RunInputApply)(Direction direction, void* context);
+
+typedef struct {
+    RunInputApply apply;
+    void* context;
+    
+    Direction queue[RUN_INPUT_TYPE_AHEAD];
+    uint8_t head;
+    uint8_t tail;
+} RunInput;
+
+void run_input_init(RunInput* input, RunInputApply apply, void* context);
+
+// Drops the queued keys, for a new run
+void run_input_reset(RunInput* input);
+
+// An arrow pressed while the run is in phase. It goes to the core after the
+// queued ones, or joins them while the core is not taking keys; a key that
+// finds the queue full is lost.
+void run_input_key(RunInput* input, Direction direction, RunPhase phase);
+
+// Feeds queued keys to the core until they run out or one of them moves the
+// run out of PLAY. Returns the phase after the last one.
+RunPhase run_input_drain(RunInput* input, RunPhase phase);
+
+// Where a run in phase goes after outcome: a completion starts the landing
+// unless one is running, game over ends the run
+RunPhase run_input_next_phase(RunPhase phase, uint32_t outcome);
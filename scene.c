@@ -0,0 +1,828 @@
+#include "scene.h"
+#include "catalog.h"
+#include "arrow_row.h"
+#include "achievements.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPLASH_HEIGHT CUSTOM_SPLASH_HEIGHT
+#define SPLASH_WIDTH CUSTOM_SPLASH_WIDTH
+
+#define ARROW_HEAD_SIZE 4
+#define ARROW_TAIL_SIZE 4
+
+// The stratagem's icon, in the bottom left corner of the PLAY screen
+#define ICON_X 4
+#define ICON_Y 42
+
+#define FLAG_WIDTH 24
+#define FLAG_HEIGHT 10
+
+const char* const game_state_names[GAME_STATE_COUNT] = {
+    "MENU",
+    "PLAY",
+    "GAME OVER",
+    "SUCCESS",
+    "DIAG",
+    "BOARD",
+};
+
+// The capsule falls to the pad, kicking up one more pair of debris lines
+// every 50 ms once it lands
+static const AnimKey anim_capsule_keys[] = {
+    {0, ANIM_INT(12), AnimEaseInQuad},
+    {250, ANIM_INT(20), AnimEaseLinear},
+    {SUCCESS_ANIM_MS, ANIM_INT(20), AnimEaseLinear},
+};
+const AnimTrack anim_capsule = ANIM_TRACK(anim_capsule_keys, false);
+
+static const AnimKey anim_debris_keys[] = {
+    {0, 0, AnimEaseStep},
+    {100, ANIM_INT(1), AnimEaseLinear},
+    {200, ANIM_INT(3), AnimEaseLinear},
+    {SUCCESS_ANIM_MS, ANIM_INT(3), AnimEaseLinear},
+};
+static const AnimTrack anim_debris = ANIM_TRACK(anim_debris_keys, false);
+
+// Shake amplitude in pixels
+static const AnimKey anim_shake_keys[] = {
+    {0, ANIM_INT(2), AnimEaseOutQuad},
+    {SHAKE_MS, 0, AnimEaseLinear},
+};
+const AnimTrack anim_shake = ANIM_TRACK(anim_shake_keys, false);
+
+// One wave of the game over flag per loop, as a fraction of a turn
+static const AnimKey anim_flag_keys[] = {
+    {0, 0, AnimEaseLinear},
+    {1600, ANIM_ONE, AnimEaseLinear},
+};
+static const AnimTrack anim_flag = ANIM_TRACK(anim_flag_keys, true);
+
+// Stars dim briefly once per loop
+static const AnimKey anim_twinkle_keys[] = {
+    {0, ANIM_ONE, AnimEaseStep},
+    {1200, 0, AnimEaseStep},
+    {1400, ANIM_ONE, AnimEaseStep},
+    {1600, ANIM_ONE, AnimEaseStep},
+};
+static const AnimTrack anim_twinkle = ANIM_TRACK(anim_twinkle_keys, true);
+
+void scene_init(Scene* scene, uint32_t now) {
+    memset(scene, 0, sizeof(Scene));
+    scene->anim_epoch = now;
+    scene->success_anim.x = 64;
+    scene->success_anim.y = 30;
+    scene->transition_screen = GAME_STATE_MENU;
+}
+
+void scene_init_background(Scene* scene) {
+    for (int i = 0; i < MAX_STARS; i++) {
+        scene->stars[i].x = rand() % 128;
+        scene->stars[i].y = rand() % 64;
+        scene->stars[i].brightness = rand() % 3;
+        scene->stars[i].blink_rate = rand() % 5 + 1;
+    }
+    
+    for (int i = 0; i < MAX_PLANETS; i++) {
+        scene->planets[i].x = 20 + (rand() % 88);
+        scene->planets[i].y = 15 + (rand() % 25);
+        scene->planets[i].size = 4 + (rand() % 5);
+        // Ensure ship coordinates are valid
+        int range = 5;
+        scene->planets[i].ship_x = scene->planets[i].x + (rand() % (2*range + 1)) - range;
+        scene->planets[i].ship_y = scene->planets[i].y + (rand() % (2*range + 1)) - range;
+        
+        // Ensure they're within screen boundaries
+        if (scene->planets[i].ship_x >= 128) scene->planets[i].ship_x = 127;
+        if (scene->planets[i].ship_y >= 64) scene->planets[i].ship_y = 63;
+    }
+    scene->background_ready = true;
+}
+
+// Screens that blend into each other; the others cut
+static int8_t transition_group(GameState state) {
+    switch(state) {
+        case GAME_STATE_MENU:
+            return 0;
+        case GAME_STATE_PLAY:
+        case GAME_STATE_STRATAGEM_SUCCESS:
+            return 1;
+        case GAME_STATE_GAME_OVER:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+void scene_transition_update(Scene* scene, GameState state, uint32_t now) {
+    if(!PROFILE_EFFECTS) return;
+    
+    int8_t from = transition_group(scene->transition_screen);
+    int8_t to = transition_group(state);
+    
+    if(from != to) {
+        scene->transition_kind = TransitionKindNone;
+        if(from >= 0 && to >= 0) {
+            if(scene->transition_screen == GAME_STATE_MENU) {
+                scene->transition_kind = TransitionKindWipeIn;
+            } else if(state == GAME_STATE_MENU) {
+                scene->transition_kind = TransitionKindWipeOut;
+            } else {
+                scene->transition_kind = TransitionKindFade;
+            }
+            scene->transition_start = now;
+        }
+    } else if(scene->transition_kind != TransitionKindNone && now - scene->transition_start > TRANSITION_MS) {
+        scene->transition_kind = TransitionKindNone;
+    }
+    scene->transition_screen = state;
+}
+
+static void draw_star(DisplayList* list, const Star* star, uint32_t elapsed) {
+    if (!list || !star) return;
+    
+    bool should_draw = true;
+    
+    // Slow blinkers stay lit; the rest twinkle at their own rate and phase
+    if (star->blink_rate > 0 && star->blink_rate < 4) {
+        uint32_t time = elapsed / star->blink_rate + star->x * 13;
+        should_draw = anim_eval(&anim_twinkle, time) > 0;
+    }
+    
+    if (should_draw) {
+        // Make sure coordinates are within screen bounds
+        uint8_t x = star->x;
+        uint8_t y = star->y;
+        
+        if (x >= 128 || y >= 64) return;
+        
+        if (star->brightness == 0) {
+            display_list_dot(list, x, y);
+        } else if (star->brightness == 1) {
+            display_list_dot(list, x, y);
+            if (x + 1 < 128) display_list_dot(list, x + 1, y);
+            if (y + 1 < 64) display_list_dot(list, x, y + 1);
+        } else {
+            if (x > 0) display_list_dot(list, x - 1, y);
+            if (x + 1 < 128) display_list_dot(list, x + 1, y);
+            if (y > 0) display_list_dot(list, x, y - 1);
+            if (y + 1 < 64) display_list_dot(list, x, y + 1);
+            display_list_dot(list, x, y);
+        }
+    }
+}
+
+static void draw_planet(DisplayList* list, const Planet* planet) {
+    if (!list || !planet) return;
+    
+    // Ensure coordinates are within bounds
+    uint8_t x = planet->x;
+    uint8_t y = planet->y;
+    
+    if (x >= 128 || y >= 64) return;
+    
+    display_list_circle(list, x, y, planet->size);
+    
+    uint8_t ring_size = planet->size + 2;
+    if (rand() % 3 == 0) {
+        display_list_circle(list, x, y, ring_size);
+    }
+    
+    uint8_t ship_x = planet->ship_x;
+    uint8_t ship_y = planet->ship_y;
+    
+    if (ship_x >= 128 || ship_y >= 64) return;
+    
+    if (ship_x >= 2 && ship_x + 2 < 128) {
+        display_list_line(list,
+                        ship_x - 2, ship_y,
+                        ship_x + 2, ship_y);
+    }
+    
+    if (ship_y >= 1 && ship_y + 1 < 64) {
+        display_list_line(list,
+                        ship_x, ship_y - 1,
+                        ship_x, ship_y + 1);
+    }
+}
+
+static void draw_space_background(DisplayList* list, const Scene* scene, const SceneFrame* frame) {
+    if(!scene->background_ready) return;
+    
+    uint32_t elapsed = frame->now - scene->anim_epoch;
+    uint8_t star_step = frame->quality >= QualityTierFewerStars ? 2 : 1;
+    for (int i = 0; i < MAX_STARS; i += star_step) {
+        draw_star(list, &scene->stars[i], elapsed);
+    }
+    
+    if(frame->quality >= QualityTierNoPlanets) return;
+    for (int i = 0; i < MAX_PLANETS; i++) {
+        draw_planet(list, &scene->planets[i]);
+    }
+}
+
+static void draw_arrow_bitmap(DisplayList* list, Direction dir, uint8_t center_x, uint8_t center_y, bool filled) {
+    switch(dir) {
+        case DIRECTION_UP:
+            display_list_line(list, center_x, center_y - ARROW_HEAD_SIZE, center_x - ARROW_HEAD_SIZE, center_y);
+            display_list_line(list, center_x, center_y - ARROW_HEAD_SIZE, center_x + ARROW_HEAD_SIZE, center_y);
+            
+            if(filled) {
+                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
+                    display_list_line(list, center_x - j, center_y - ARROW_HEAD_SIZE + j, center_x + j, center_y - ARROW_HEAD_SIZE + j);
+                }
+            }
+            
+            display_list_line(list, center_x, center_y, center_x, center_y + ARROW_TAIL_SIZE);
+            break;
+        
+        case DIRECTION_DOWN:
+            display_list_line(list, center_x, center_y + ARROW_HEAD_SIZE, center_x - ARROW_HEAD_SIZE, center_y);
+            display_list_line(list, center_x, center_y + ARROW_HEAD_SIZE, center_x + ARROW_HEAD_SIZE, center_y);
+            
+            if(filled) {
+                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
+                    display_list_line(list, center_x - j, center_y + ARROW_HEAD_SIZE - j, center_x + j, center_y + ARROW_HEAD_SIZE - j);
+                }
+            }
+            
+            display_list_line(list, center_x, center_y, center_x, center_y - ARROW_TAIL_SIZE);
+            break;
+        
+        case DIRECTION_LEFT:
+            display_list_line(list, center_x - ARROW_HEAD_SIZE, center_y, center_x, center_y - ARROW_HEAD_SIZE);
+            display_list_line(list, center_x - ARROW_HEAD_SIZE, center_y, center_x, center_y + ARROW_HEAD_SIZE);
+            
+            if(filled) {
+                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
+                    display_list_line(list, center_x - ARROW_HEAD_SIZE + j, center_y - j, center_x - ARROW_HEAD_SIZE + j, center_y + j);
+                }
+            }
+            
+            display_list_line(list, center_x, center_y, center_x + ARROW_TAIL_SIZE, center_y);
+            break;
+        
+        case DIRECTION_RIGHT:
+            display_list_line(list, center_x + ARROW_HEAD_SIZE, center_y, center_x, center_y - ARROW_HEAD_SIZE);
+            display_list_line(list, center_x + ARROW_HEAD_SIZE, center_y, center_x, center_y + ARROW_HEAD_SIZE);
+            
+            if(filled) {
+                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
+                    display_list_line(list, center_x + ARROW_HEAD_SIZE - j, center_y - j, center_x + ARROW_HEAD_SIZE - j, center_y + j);
+                }
+            }
+            
+            display_list_line(list, center_x, center_y, center_x - ARROW_TAIL_SIZE, center_y);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+static void draw_stratagem_success_animation(DisplayList* list, const Scene* scene, const SceneFrame* frame) {
+    uint8_t x = scene->success_anim.x;
+    uint8_t y = scene->success_anim.y;
+    uint32_t elapsed = frame->now - scene->success_anim.start_tick;
+    uint8_t debris = ANIM_TO_INT(anim_eval(&anim_debris, elapsed));
+    
+    display_list_set_color(list, DisplayListColorBlack);
+    
+    // The ground/platform is part of the cached HUD layer
+    
+    // Only draw capsule and effects during animation
+    if(frame->state == GAME_STATE_STRATAGEM_SUCCESS) {
+        uint8_t capsule_length = 10;
+        uint8_t capsule_width = 5;
+        uint8_t impact_y = y + ANIM_TO_INT(anim_eval(&anim_capsule, elapsed));
+        
+        display_list_circle(list, x, impact_y - capsule_length/2, capsule_width/2);
+        display_list_box(list, x - capsule_width/2, impact_y - capsule_length/2, capsule_width, capsule_length);
+        display_list_circle(list, x, impact_y + capsule_length/2, capsule_width/2);
+        
+        if (debris >= 1) {
+            display_list_line(list, x - 10, y + 20, x - 5, y + 20 + 3);
+            display_list_line(list, x + 10, y + 20, x + 5, y + 20 + 3);
+        }
+        
+        if (debris >= 2) {
+            display_list_line(list, x - 15, y + 20, x - 12, y + 20 + 5);
+            display_list_line(list, x + 15, y + 20, x + 12, y + 20 + 5);
+        }
+        
+        if (debris >= 3) {
+            display_list_line(list, x - 18, y + 20, x - 17, y + 20 + 7);
+            display_list_line(list, x + 18, y + 20, x + 17, y + 20 + 7);
+        }
+    }
+}
+
+// The buffer is in u8g2 page layout: byte [page * 128 + x] holds rows
+// page*8..page*8+7 of column x, LSB on top, so a whole column fits a
+// uint64_t and a vertical shift is a single shift
+void scene_shift(uint8_t* buffer, int8_t dx, int8_t dy) {
+    if(dx == 0 && dy == 0) return;
+    
+    const int16_t width = 128;
+    const uint8_t pages = 64 / 8;
+    
+    // Walk against the shift direction so every source column is read
+    // before it gets overwritten
+    int16_t start = dx > 0 ? width - 1 : 0;
+    int16_t step = dx > 0 ? -1 : 1;
+    
+    for(int16_t x = start; x >= 0 && x < width; x += step) {
+        int16_t src_x = x - dx;
+        uint64_t column = 0;
+        
+        if(src_x >= 0 && src_x < width) {
+            for(uint8_t page = 0; page < pages; page++) {
+                column |= (uint64_t)buffer[page * width + src_x] << (page * 8);
+            }
+            column = dy > 0 ? column << dy : column >> -dy;
+        }
+        
+        for(uint8_t page = 0; page < pages; page++) {
+            buffer[page * width + x] = (column >> (page * 8)) & 0xFF;
+        }
+    }
+}
+
+// Formats only when the value changed since the last frame
+static const char* hud_text_format(HudText* text, const char* format, uint32_t value) {
+    if(!text->valid || text->value != value) {
+        snprintf(text->str, sizeof(text->str), format, (unsigned long)value);
+        text->value = value;
+        text->valid = true;
+    }
+    return text->str;
+}
+
+// The static PLAY layer, wrapped so replay only rasterizes it when one of
+// the values it is drawn from changed. Leaves only the progress bar fill,
+// the arrow row and the capsule for the caller to draw.
+static void draw_play_hud(DisplayList* list, Scene* scene, const SceneFrame* frame) {
+    HudLayer* hud = &scene->hud;
+    const GameCore* game = frame->game;
+    
+    uint16_t race_local = frame->mode == GAME_MODE_VERSUS ? frame->race.local_count : 0;
+    uint16_t race_remote = frame->mode == GAME_MODE_VERSUS ? frame->race.remote_count : 0;
+    bool ghost = frame->mode == GAME_MODE_CLASSIC && frame->ghost;
+    
+    if(!hud->valid || hud->mode != frame->mode ||
+       hud->stratagem_index != game->stratagem || hud->lives != game->lives ||
+       hud->race_local != race_local || hud->race_remote != race_remote || hud->ghost != ghost) {
+        hud->valid = true;
+        hud->generation++;
+        hud->mode = frame->mode;
+        hud->stratagem_index = game->stratagem;
+        hud->lives = game->lives;
+        hud->race_local = race_local;
+        hud->race_remote = race_remote;
+        hud->ghost = ghost;
+    }
+    
+    display_list_layer_begin(list, hud->generation);
+    display_list_clear(list);
+    display_list_set_color(list, DisplayListColorBlack);
+    
+    display_list_set_font(list, DisplayListFontPrimary);
+    display_list_str(list, 2, 12, catalog_name(catalog_get(game->stratagem)));
+    if(frame->icon) {
+        display_list_xbm(list, ICON_X, ICON_Y, CATALOG_ICON_SIZE, CATALOG_ICON_SIZE, frame->icon);
+    }
+    
+    display_list_frame(list, 0, 0, 128, 64);
+    display_list_frame(list, 4, 16, PROGRESS_WIDTH, 6);
+    
+    for(uint8_t i = 0; i < game->lives; i++) {
+        uint8_t heart_x = 104 + (i * 8);
+        uint8_t heart_y = 8;
+        
+        display_list_box(list, heart_x, heart_y, 6, 6);
+        display_list_line(list,
+                       heart_x + 2,
+                       heart_y + 1,
+                       heart_x + 2,
+                       heart_y + 1);
+    }
+    
+    // Ground/platform under the landing capsule
+    uint8_t ground_x = scene->success_anim.x;
+    uint8_t ground_y = scene->success_anim.y + 20;
+    display_list_line(list, ground_x - 20, ground_y, ground_x + 20, ground_y);
+    
+    if(frame->mode == GAME_MODE_VERSUS) {
+        char race_str[32];
+        snprintf(race_str, sizeof(race_str), "YOU %u/%u  FOE %u/%u",
+                 race_local, VERSUS_MATCH_LENGTH, race_remote, VERSUS_MATCH_LENGTH);
+        display_list_set_font(list, DisplayListFontSecondary);
+        display_list_str_aligned(list, 64, 58, DisplayListAlignCenter, DisplayListAlignCenter, race_str);
+    }
+    
+    if(ghost) {
+        display_list_line(list, 4, 61, 124, 61);
+    }
+    display_list_layer_end(list);
+}
+
+static uint8_t ghost_track_x(uint32_t score, uint32_t best_score) {
+    if(score > best_score) score = best_score;
+    return 4 + (120 * score) / best_score;
+}
+
+// Live score as a block and the best run's score at the same moment as a
+// thin tick, both on the track along the bottom edge
+static void draw_ghost_race(DisplayList* list, const SceneFrame* frame) {
+    uint8_t ghost_x = ghost_track_x(frame->ghost_score, frame->ghost_best);
+    display_list_line(list, ghost_x, 57, ghost_x, 60);
+    
+    uint8_t live_x = ghost_track_x(frame->game->score, frame->ghost_best);
+    display_list_box(list, live_x - 1, 58, 3, 3);
+}
+
+// CPU share and wakeup rate per thread for one game state; Left/Right pick
+// the state, OK appends everything to diagnostics.csv, Up toggles frame
+// streaming over USB where the profile has it
+static void draw_diagnostics(DisplayList* list, const SceneFrame* frame) {
+    const DiagnosticsBucket* bucket = frame->diagnostics;
+    char line[32];
+    
+    display_list_set_color(list, DisplayListColorBlack);
+    display_list_set_font(list, DisplayListFontPrimary);
+    snprintf(line, sizeof(line), "< %s >", game_state_names[frame->diagnostics_view]);
+    display_list_str(list, 2, 10, line);
+    
+    display_list_set_font(list, DisplayListFontSecondary);
+    if(frame->diagnostics_status) {
+        display_list_str_aligned(list, 126, 10, DisplayListAlignRight, DisplayListAlignBottom, frame->diagnostics_status);
+    } else if(bucket) {
+        snprintf(line, sizeof(line), "%lus", (unsigned long)(bucket->time_ms / 1000));
+        display_list_str_aligned(list, 126, 10, DisplayListAlignRight, DisplayListAlignBottom, line);
+    }
+    display_list_line(list, 0, 12, 127, 12);
+    
+    if(!bucket || bucket->time_ms == 0) {
+        display_list_str_aligned(list, 64, 38, DisplayListAlignCenter, DisplayListAlignCenter, "NO SAMPLES YET");
+        return;
+    }
+    
+    for(uint8_t i = 0; i < DiagnosticsThreadCount; i++) {
+        uint8_t y = 21 + i * 8;
+        unsigned long cpu = (unsigned long)(bucket->cpu_ms[i] * 100.0f / bucket->time_ms);
+        unsigned long wakeups = bucket->wakeups[i] * 10000ULL / bucket->time_ms;
+        
+        display_list_str(list, 2, y, frame->thread_labels[i]);
+        snprintf(line, sizeof(line), "%lu.%02lu%%", cpu / 100, cpu % 100);
+        display_list_str_aligned(list, 80, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+        snprintf(line, sizeof(line), "%lu.%lu/s", wakeups / 10, wakeups % 10);
+        display_list_str_aligned(list, 126, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+    }
+    
+    // Icon cache: share of stratagem switches that found the icon decoded,
+    // and the slowest decode
+    uint32_t lookups = frame->icon_hits + frame->icon_misses;
+    display_list_str(list, 2, 62, "Icons");
+    if(lookups) {
+        snprintf(line, sizeof(line), "%lu%% hit", (unsigned long)(frame->icon_hits * 100 / lookups));
+        display_list_str_aligned(list, 80, 62, DisplayListAlignRight, DisplayListAlignBottom, line);
+    }
+    snprintf(line, sizeof(line), "%luus", (unsigned long)frame->icon_decode_max_us);
+    display_list_str_aligned(list, 126, 62, DisplayListAlignRight, DisplayListAlignBottom, line);
+}
+
+// Improved flag animation with proper edges
+static void draw_flag(DisplayList* list, const Scene* scene, const SceneFrame* frame, uint8_t pole_end_x, uint8_t pole_end_y) {
+    // The lite profile flies a still flag, and so does a busy frame
+    if(!PROFILE_EFFECTS || frame->quality >= QualityTierStillFlag) {
+        display_list_frame(list, pole_end_x, pole_end_y, FLAG_WIDTH + 1, FLAG_HEIGHT + 1);
+        return;
+    }
+    
+    uint32_t phase = anim_eval(&anim_flag, frame->now - scene->anim_epoch);
+    
+    // Initialize previous points at pole position
+    int8_t prev_top_x = pole_end_x;
+    int8_t prev_top_y = pole_end_y;
+    int8_t prev_bottom_x = pole_end_x;
+    int8_t prev_bottom_y = pole_end_y + FLAG_HEIGHT;
+    
+    // Draw flag body
+    for(uint8_t i = 0; i <= FLAG_WIDTH; i++) {
+        uint32_t pos = i * ANIM_TURN / FLAG_WIDTH; // One full wave
+        
+        // Calculate current points with animation; the bottom edge trails
+        // the top by half a radian
+        int8_t current_x = pole_end_x + i;
+        int8_t current_top_y = pole_end_y + ANIM_TO_INT(anim_sin(pos + phase) * 3);
+        int8_t current_bottom_y = pole_end_y + FLAG_HEIGHT + ANIM_TO_INT(anim_sin(pos + phase + 5215) * 2);
+        
+        // Draw vertical connections at the pole
+        if(i < 3) {
+            display_list_line(list,
+                          current_x,
+                          current_top_y,
+                          current_x,
+                          current_bottom_y);
+        }
+        
+        // Draw top wave
+        if(i > 0) {
+            display_list_line(list,
+                          prev_top_x,
+                          prev_top_y,
+                          current_x,
+                          current_top_y);
+        }
+        
+        // Draw bottom wave
+        if(i > 0) {
+            display_list_line(list,
+                          prev_bottom_x,
+                          prev_bottom_y,
+                          current_x,
+                          current_bottom_y);
+        }
+        
+        // Draw vertical stripes
+        if(i > 2 && i % 4 == 0 && i < FLAG_WIDTH) {
+            display_list_line(list,
+                          current_x,
+                          current_top_y,
+                          current_x,
+                          current_bottom_y);
+        }
+        
+        // Close the flag end
+        if(i == FLAG_WIDTH) {
+            display_list_line(list,
+                          current_x,
+                          current_top_y,
+                          current_x,
+                          current_bottom_y);
+        }
+        
+        prev_top_x = current_x;
+        prev_top_y = current_top_y;
+        prev_bottom_x = current_x;
+        prev_bottom_y = current_bottom_y;
+    }
+}
+
+static void draw_leaderboard(DisplayList* list, const SceneFrame* frame) {
+    char line[32];
+    
+    display_list_set_color(list, DisplayListColorBlack);
+    display_list_set_font(list, DisplayListFontPrimary);
+    display_list_str(list, 2, 10, "LEADERBOARD");
+    
+    display_list_set_font(list, DisplayListFontSecondary);
+    snprintf(line, sizeof(line), "%u FILES", frame->board_files);
+    display_list_str_aligned(list, 126, 10, DisplayListAlignRight, DisplayListAlignBottom, line);
+    display_list_line(list, 0, 12, 127, 12);
+    
+    if(frame->board_count == 0) {
+        display_list_str_aligned(list, 64, 38, DisplayListAlignCenter, DisplayListAlignCenter, "NO RUNS YET");
+        return;
+    }
+    
+    for(uint8_t row = 0; row < LEADERBOARD_ROWS; row++) {
+        uint8_t rank = frame->board_scroll + row;
+        if(rank >= frame->board_count) break;
+        
+        const LeaderboardRecord* record = &frame->board[rank];
+        uint8_t y = 22 + row * 9;
+        
+        snprintf(line, sizeof(line), "%u.", rank + 1);
+        display_list_str_aligned(list, 14, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+        snprintf(line, sizeof(line), "%lu", (unsigned long)record->score);
+        display_list_str_aligned(list, 60, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+        snprintf(line, sizeof(line), "L%u", record->level);
+        display_list_str_aligned(list, 84, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+        
+        // Runs from this device are marked, the others go by a short id
+        snprintf(line, sizeof(line), "%04lX%s", (unsigned long)(record->device_id & 0xFFFF),
+                 record->device_id == frame->device_id ? "*" : " ");
+        display_list_str_aligned(list, 126, y, DisplayListAlignRight, DisplayListAlignBottom, line);
+    }
+}
+
+void scene_build(Scene* scene, const SceneFrame* frame, DisplayList* list) {
+    display_list_reset(list);
+    
+    const GameCore* game = frame->game;
+    bool playing = frame->state == GAME_STATE_PLAY || frame->state == GAME_STATE_STRATAGEM_SUCCESS;
+    
+    // The PLAY screen starts from its cached HUD layer instead of a blank one
+    if(!playing) {
+        display_list_clear(list);
+    }
+    display_list_set_font(list, DisplayListFontPrimary);
+    
+    if(frame->state == GAME_STATE_MENU) {
+        draw_space_background(list, scene, frame);
+        
+        uint8_t centered_x = (128 - SPLASH_WIDTH) / 2;
+        uint8_t centered_y = (64 - SPLASH_HEIGHT) / 2;
+        
+        display_list_set_color(list, DisplayListColorBlack);
+        display_list_box(list,
+                      centered_x - 5,
+                      centered_y - 5,
+                      SPLASH_WIDTH + 10,
+                      SPLASH_HEIGHT + 10);
+        
+        display_list_set_color(list, DisplayListColorWhite);
+        display_list_xbm(list, centered_x, centered_y, SPLASH_WIDTH, SPLASH_HEIGHT, frame->splash);
+        
+        display_list_set_color(list, DisplayListColorBlack);
+        display_list_frame(list,
+                        centered_x - 5,
+                        centered_y - 5,
+                        SPLASH_WIDTH + 10,
+                        SPLASH_HEIGHT + 10);
+        
+        display_list_set_font(list, DisplayListFontSecondary);
+        display_list_str_aligned(list,
+                              64,
+                              centered_y + SPLASH_HEIGHT + 15,
+                              DisplayListAlignCenter,
+                              DisplayListAlignCenter,
+                              "PRESS OK TO DEPLOY");
+        
+        display_list_set_color(list, DisplayListColorWhite);
+        display_list_box(list, 0, 52, 128, 12);
+        display_list_set_color(list, DisplayListColorBlack);
+        
+        display_list_set_font(list, DisplayListFontSecondary);
+        if(frame->mode == GAME_MODE_VERSUS) {
+            const VersusStatus* race = &frame->race;
+            char link_str[32];
+            if(!frame->linked) {
+                snprintf(link_str, sizeof(link_str), "< VERSUS: UART BUSY >");
+            } else if(race->match == VersusMatchCountdown) {
+                uint32_t left = (int32_t)(race->start_time - frame->now) > 0 ? race->start_time - frame->now : 0;
+                snprintf(link_str, sizeof(link_str), "DEPLOYING IN %lu.%lu",
+                         (unsigned long)(left / 1000), (unsigned long)((left % 1000) / 100));
+            } else if(race->connected) {
+                snprintf(link_str, sizeof(link_str), "< VERSUS: RTT %lums >", (unsigned long)race->rtt);
+            } else {
+                snprintf(link_str, sizeof(link_str), "< VERSUS: NO LINK >");
+            }
+            display_list_str_aligned(list, 64, 58, DisplayListAlignCenter, DisplayListAlignCenter, link_str);
+        } else if(frame->mode == GAME_MODE_PRACTICE) {
+            display_list_str_aligned(list, 64, 58, DisplayListAlignCenter, DisplayListAlignCenter, "< PRACTICE >");
+        } else {
+            display_list_str_aligned(list, 64, 58, DisplayListAlignCenter, DisplayListAlignCenter, "< CLASSIC >");
+        }
+        
+        if(frame->high_score > 0) {
+            const char* score_str = hud_text_format(&scene->high_score_text, "HIGH SCORE: %lu", frame->high_score);
+            
+            display_list_set_color(list, DisplayListColorWhite);
+            display_list_box(list, 0, 0, 128, 10);
+            display_list_set_color(list, DisplayListColorBlack);
+            display_list_str_aligned(list, 64, 8, DisplayListAlignCenter, DisplayListAlignCenter, score_str);
+        }
+        
+    } else if(playing) {
+        const CatalogEntry* current = catalog_get(game->stratagem);
+        
+        draw_play_hud(list, scene, frame);
+        display_list_set_color(list, DisplayListColorBlack);
+        
+        // Banked time beyond the limit just shows a full bar
+        uint32_t progress_width = (PROGRESS_WIDTH * frame->time_left) / game->time_limit;
+        if(progress_width > PROGRESS_WIDTH) progress_width = PROGRESS_WIDTH;
+        
+        display_list_box(list, 4, 16, progress_width, 6);
+        
+        draw_stratagem_success_animation(list, scene, frame);
+        
+        if(frame->mode == GAME_MODE_CLASSIC && frame->ghost) {
+            draw_ghost_race(list, frame);
+        }
+        
+        for(uint8_t i = 0; i < current->length; i++) {
+            int16_t x = arrow_row_x(current->length, game->input_index, i);
+            uint8_t y = 32;
+            bool filled = false;
+            
+            if(!arrow_row_visible(x)) continue;
+            
+            if(frame->state == GAME_STATE_PLAY || frame->state == GAME_STATE_STRATAGEM_SUCCESS) {
+                filled = i < game->input_index;
+                if(i == game->input_index) {
+                    display_list_frame(list, x - 10, y - 10, 20, 20);
+                }
+            }
+            
+            draw_arrow_bitmap(list, catalog_direction(current, i), x, y, filled);
+        }
+        
+    } else if(frame->state == GAME_STATE_GAME_OVER) {
+        draw_space_background(list, scene, frame);
+        
+        // Score display
+        display_list_set_color(list, DisplayListColorWhite);
+        display_list_box(list, 0, 0, 128, 32);
+        display_list_set_color(list, DisplayListColorBlack);
+        display_list_frame(list, 0, 0, 128, 32);
+        
+        const char* score_str;
+        const char* high_str;
+        char race_str[32];
+        if(frame->mode == GAME_MODE_VERSUS) {
+            const char* result_str = "WAITING FOR FOE";
+            if(frame->race.result == VersusResultWin) {
+                result_str = "YOU WIN";
+            } else if(frame->race.result == VersusResultLose) {
+                result_str = "YOU LOSE";
+            } else if(frame->race.result == VersusResultDraw) {
+                result_str = "DRAW";
+            }
+            score_str = result_str;
+            snprintf(race_str, sizeof(race_str), "YOU %u/%u  FOE %u/%u",
+                     frame->race.local_count, VERSUS_MATCH_LENGTH,
+                     frame->race.remote_count, VERSUS_MATCH_LENGTH);
+            high_str = race_str;
+        } else {
+            uint32_t display_high_score = frame->high_score;
+            if(game->score > frame->high_score) {
+                display_high_score = game->score;
+            }
+            
+            score_str = hud_text_format(&scene->score_text, "SCORE: %lu", game->score);
+            high_str = hud_text_format(&scene->best_text, "BEST: %lu", display_high_score);
+        }
+        display_list_set_font(list, DisplayListFontPrimary);
+        display_list_str_aligned(list, 64, 10, DisplayListAlignCenter, DisplayListAlignCenter, score_str);
+        
+        display_list_set_font(list, DisplayListFontSecondary);
+        display_list_str_aligned(list, 64, 24, DisplayListAlignCenter, DisplayListAlignCenter, high_str);
+        
+        // Hill drawing
+        uint8_t hill_center_x = 64;
+        uint8_t hill_height = 8;
+        uint8_t hill_base_y = 63;
+        uint8_t hill_width = 100;
+        
+        for(int16_t x = hill_center_x - hill_width/2; x <= hill_center_x + hill_width/2; x++) {
+            float a = (float)hill_height / ((hill_width/2) * (hill_width/2));
+            uint8_t y = hill_base_y - hill_height + (a * (x - hill_center_x) * (x - hill_center_x));
+            
+            if(x >= 0 && x < 128 && y < 64) {
+                display_list_line(list, x, y, x, hill_base_y);
+            }
+        }
+        
+        // Flagpole (leaning left)
+        uint8_t pole_start_x = hill_center_x - 5;
+    uint8_t pole_start_y = hill_base_y - hill_height;
+    uint8_t pole_height = 25;
+    uint8_t pole_end_x = pole_start_x - 3;
+    uint8_t pole_end_y = pole_start_y - pole_height;
+    
+    display_list_line(list,
+                   pole_start_x,
+                   pole_start_y,
+                   pole_end_x,
+                   pole_end_y);
+    
+    draw_flag(list, scene, frame, pole_end_x, pole_end_y);
+} else if(frame->state == GAME_STATE_DIAGNOSTICS) {
+        draw_diagnostics(list, frame);
+    } else if(frame->state == GAME_STATE_LEADERBOARD) {
+        draw_leaderboard(list, frame);
+    }
+    
+    // A fresh unlock shows over the bottom of the screen for a moment
+    if(frame->achievement_toast < AchievementCount &&
+       frame->now - frame->achievement_toast_tick < ACHIEVEMENT_TOAST_MS) {
+        display_list_set_color(list, DisplayListColorWhite);
+        display_list_box(list, 8, 50, 112, 13);
+        display_list_set_color(list, DisplayListColorBlack);
+        display_list_frame(list, 8, 50, 112, 13);
+        display_list_set_font(list, DisplayListFontSecondary);
+        display_list_str_aligned(list, 64, 57, DisplayListAlignCenter, DisplayListAlignCenter,
+                                 achievement_name(frame->achievement_toast));
+    }
+    
+    if(scene->screen_shake.active && frame->quality < QualityTierNoShake) {
+        uint32_t elapsed = frame->now - scene->screen_shake.start_tick;
+        int8_t amplitude = ANIM_TO_INT(anim_eval(&anim_shake, elapsed) + ANIM_ONE / 2);
+        if(amplitude > 0) {
+            display_list_shift(list,
+                               (rand() % (2 * amplitude + 1)) - amplitude,
+                               (rand() % (2 * amplitude + 1)) - amplitude);
+        }
+    }
+    
+    if(scene->transition_kind != TransitionKindNone) {
+        uint32_t elapsed = frame->now - scene->transition_start;
+        if(elapsed > TRANSITION_MS) elapsed = TRANSITION_MS;
+        display_list_transition(list, scene->transition_kind, elapsed * 255 / TRANSITION_MS);
+    }
+}
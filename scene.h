@@ -0,0 +1,209 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "game_core.h"
+#include "display_list.h"
+#include "versus.h"
+#include "leaderboard.h"
+#include "diagnostics.h"
+#include "anim.h"
+
+// Every screen of the game, built into a display list. The effects keep
+// their state in a Scene between frames; everything else a frame is drawn
+// from comes in a SceneFrame, so the app and tools/replay_render.c build
+// the same commands from the same state. Platform-free.
+
+typedef enum {
+    GAME_STATE_MENU,
+    GAME_STATE_PLAY,
+    GAME_STATE_GAME_OVER,
+    GAME_STATE_STRATAGEM_SUCCESS,
+    GAME_STATE_DIAGNOSTICS,
+    GAME_STATE_LEADERBOARD,
+    GAME_STATE_COUNT
+} GameState;
+
+extern const char* const game_state_names[GAME_STATE_COUNT];
+
+// Also the mode byte of Start records and snapshots
+typedef enum {
+    GAME_MODE_CLASSIC,
+    GAME_MODE_VERSUS,
+    GAME_MODE_PRACTICE,
+    GAME_MODE_COUNT
+} GameMode;
+
+// Screen changes between the menu, the game and game over blend over
+// TRANSITION_MS with ordered dither instead of cutting
+typedef enum {
+    TransitionKindNone,
+    TransitionKindFade,
+    TransitionKindWipeIn, // the new screen sweeps in from the left
+    TransitionKindWipeOut, // from the right
+} TransitionKind;
+
+#define TRANSITION_MS 400
+
+// Each tier also leaves out everything the tiers before it do
+typedef enum {
+    QualityTierFull,
+    QualityTierFewerStars, // every other star
+    QualityTierNoPlanets,
+    QualityTierStillFlag,
+    QualityTierNoShake,
+    QualityTierCount,
+} QualityTier;
+
+// What the lite profile leaves out of the screens; see the rest of the
+// profile in stratagem_hero.c
+#ifdef STRATAGEM_HERO_LITE
+#define MAX_STARS 0
+#define MAX_PLANETS 0
+#define PROFILE_EFFECTS false
+#else
+#define MAX_STARS 30
+#define MAX_PLANETS 3
+#define PROFILE_EFFECTS true
+#endif
+
+#define CUSTOM_SPLASH_WIDTH 62
+#define CUSTOM_SPLASH_HEIGHT 25
+
+#define ACHIEVEMENT_TOAST_MS 2000
+#define LEADERBOARD_ROWS 5
+
+// The time bar under the name, full at the core's time_limit
+#define PROGRESS_WIDTH 120
+
+#define SUCCESS_ANIM_MS 1000
+#define SHAKE_MS 500
+
+// The capsule landing and the wrong-key shake; the app times the end of
+// each on its wheel
+extern const AnimTrack anim_capsule;
+extern const AnimTrack anim_shake;
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t brightness;
+    uint8_t blink_rate;
+} Star;
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t size;
+    uint8_t ship_x;
+    uint8_t ship_y;
+} Planet;
+
+typedef struct {
+    bool active;
+    uint32_t start_tick;
+} ScreenShake;
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint32_t start_tick;
+} StratagemSuccess;
+
+// Static part of the PLAY screen. Scene building bumps the generation when
+// one of the values it is drawn from changes; replay rasterizes each
+// generation once and restores it with a memcpy after that.
+typedef struct {
+    bool valid;
+    uint16_t generation;
+    GameMode mode;
+    uint8_t stratagem_index;
+    uint8_t lives;
+    uint16_t race_local;
+    uint16_t race_remote;
+    bool ghost;
+} HudLayer;
+
+typedef struct {
+    char str[24];
+    uint32_t value;
+    bool valid;
+} HudText;
+
+typedef struct {
+    // Stars and planets are generated after the first frame is up
+    Star stars[MAX_STARS];
+    Planet planets[MAX_PLANETS];
+    bool background_ready;
+    uint32_t anim_epoch;
+    
+    ScreenShake screen_shake;
+    StratagemSuccess success_anim;
+    
+    GameState transition_screen;
+    TransitionKind transition_kind;
+    uint32_t transition_start;
+    
+    HudLayer hud;
+    HudText high_score_text;
+    HudText score_text;
+    HudText best_text;
+} Scene;
+
+// What one frame is drawn from besides the Scene. Screens only read the
+// fields they show.
+typedef struct {
+    uint32_t now;
+    GameState state;
+    GameMode mode;
+    QualityTier quality;
+    
+    const GameCore* game;
+    uint32_t time_left; // what the progress bar shows
+    uint32_t high_score;
+    const uint8_t* splash; // CUSTOM_SPLASH_WIDTH x CUSTOM_SPLASH_HEIGHT XBM
+    const uint8_t* icon; // the stratagem's, NULL until decoded
+    
+    // Classic runs race the best run; ghost_best is never 0 when ghost is set
+    bool ghost;
+    uint32_t ghost_best;
+    uint32_t ghost_score;
+    
+    // Versus runs; linked is false while the UART is taken
+    VersusStatus race;
+    bool linked;
+    
+    uint8_t achievement_toast; // AchievementCount when none is showing
+    uint32_t achievement_toast_tick;
+    
+    const DiagnosticsBucket* diagnostics;
+    const char* thread_labels[DiagnosticsThreadCount];
+    uint8_t diagnostics_view;
+    const char* diagnostics_status;
+    uint32_t icon_hits;
+    uint32_t icon_misses;
+    uint32_t icon_decode_max_us;
+    
+    const LeaderboardRecord* board;
+    uint16_t board_count;
+    uint16_t board_files;
+    uint8_t board_scroll;
+    uint32_t device_id;
+} SceneFrame;
+
+void scene_init(Scene* scene, uint32_t now);
+
+// Scatters the stars and planets with rand()
+void scene_init_background(Scene* scene);
+
+// Starts a transition when state is on another screen than at the last
+// call and ends it once it has run
+void scene_transition_update(Scene* scene, GameState state, uint32_t now);
+
+// Everything the frame shows, as of frame->now
+void scene_build(Scene* scene, const SceneFrame* frame, DisplayList* list);
+
+// Moves a finished 128x64 frame in the canvas's page layout by dx, dy in
+// one pass, for DisplayListOpShift
+void scene_shift(uint8_t* buffer, int8_t dx, int8_t dy);
@@ -0,0 +1,97 @@
+#include "snapshot.h"
+
+static uint8_t snapshot_crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for(size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t* snapshot_put(uint8_t* out, uint32_t value, uint8_t size) {
+    for(uint8_t i = 0; i < size; i++) {
+        *out++ = (value >> (8 * i)) & 0xFF;
+    }
+    return out;
+}
+
+static uint32_t snapshot_get(const uint8_t** data, uint8_t size) {
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < size; i++) {
+        value |= (uint32_t)(*data)[i] << (8 * i);
+    }
+    *data += size;
+    return value;
+}
+
+void snapshot_encode(const GameCore* game, const SnapshotRun* run, uint8_t* out) {
+    uint8_t* p = out;
+    
+    *p++ = SNAPSHOT_MAGIC_0;
+    *p++ = SNAPSHOT_MAGIC_1;
+    *p++ = SNAPSHOT_VERSION;
+    p = snapshot_put(p, catalog_id(), 4);
+    
+    *p++ = run->mode;
+    *p++ = run->input_correct;
+    p = snapshot_put(p, run->run_ms, 4);
+    p = snapshot_put(p, run->landing_ms, 2);
+    p = snapshot_put(p, run->shake_ms, 2);
+    
+    p = snapshot_put(p, game->rng_state, 4);
+    *p++ = game->lives;
+    *p++ = game->level;
+    p = snapshot_put(p, game->completed, 2);
+    p = snapshot_put(p, game->score, 4);
+    p = snapshot_put(p, game->time_limit, 4);
+    p = snapshot_put(p, game->time_remaining, 4);
+    *p++ = game->stratagem;
+    *p++ = game->input_index;
+    *p++ = game->mistakes;
+    p = snapshot_put(p, game->stratagem_time, 4);
+    
+    *p = snapshot_crc8(out, p - out);
+}
+
+bool snapshot_decode(const uint8_t* data, size_t size, GameCore* game, SnapshotRun* run) {
+    if(size != SNAPSHOT_SIZE) return false;
+    if(data[0] != SNAPSHOT_MAGIC_0 || data[1] != SNAPSHOT_MAGIC_1 || data[2] != SNAPSHOT_VERSION) return false;
+    if(snapshot_crc8(data, SNAPSHOT_SIZE - 1) != data[SNAPSHOT_SIZE - 1]) return false;
+    
+    const uint8_t* p = &data[3];
+    if(snapshot_get(&p, 4) != catalog_id()) return false;
+    
+    SnapshotRun r;
+    r.mode = snapshot_get(&p, 1);
+    r.input_correct = snapshot_get(&p, 1) != 0;
+    r.run_ms = snapshot_get(&p, 4);
+    r.landing_ms = snapshot_get(&p, 2);
+    r.shake_ms = snapshot_get(&p, 2);
+    
+    GameCore g = *game;
+    g.rng_state = snapshot_get(&p, 4);
+    g.lives = snapshot_get(&p, 1);
+    g.level = snapshot_get(&p, 1);
+    g.completed = snapshot_get(&p, 2);
+    g.score = snapshot_get(&p, 4);
+    g.time_limit = snapshot_get(&p, 4);
+    g.time_remaining = snapshot_get(&p, 4);
+    g.stratagem = snapshot_get(&p, 1);
+    g.input_index = snapshot_get(&p, 1);
+    g.mistakes = snapshot_get(&p, 1);
+    g.stratagem_time = snapshot_get(&p, 4);
+    
+    // A finished run or an index the catalog cannot hold is not resumable
+    if(g.lives == 0 || g.stratagem >= catalog_count() || g.time_limit == 0 ||
+       g.input_index >= catalog_get(g.stratagem)->length) {
+        return false;
+    }
+    g.over = false;
+    
+    *game = g;
+    *run = r;
+    return true;
+}
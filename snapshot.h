@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "game_core.h"
+
+// Suspended run. The core's state plus what the app needs to put the same
+// frame back up: the mode, the arrow colour and how far into the capsule
+// and shake effects the run was. Versioned, tied to the catalog by its id
+// and closed with a crc8, so a stale or damaged file is just ignored.
+// Platform-free.
+
+#define SNAPSHOT_MAGIC_0 'S'
+#define SNAPSHOT_MAGIC_1 'N'
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_SIZE 45
+
+// Effect not running
+#define SNAPSHOT_EFFECT_NONE 0xFFFF
+
+typedef struct {
+    uint8_t mode;
+    bool input_correct;
+    uint32_t run_ms; // since the run started, for the ghost
+    uint16_t landing_ms; // into the capsule landing
+    uint16_t shake_ms; // into the wrong-key shake
+} SnapshotRun;
+
+// out holds SNAPSHOT_SIZE bytes
+void snapshot_encode(const GameCore* game, const SnapshotRun* run, uint8_t* out);
+
+// Fills in the state fields of an initialised core; false leaves both alone
+bool snapshot_decode(const uint8_t* data, size_t size, GameCore* game, SnapshotRun* run);
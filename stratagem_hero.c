@@ -7,206 +7,250 @@
 #include <string.h>
 #include <notification/notification.h>
 #include <notification/notification_messages.h>
-#include <math.h>
+#include <furi_hal_serial.h>
+#include <furi_hal_serial_control.h>
+#include <furi_hal_cortex.h>
+#include <furi_hal_version.h>
+#include <storage/storage.h>
 
-#define CUSTOM_SPLASH_WIDTH 62
-#define CUSTOM_SPLASH_HEIGHT 25
-#define SPLASH_HEIGHT CUSTOM_SPLASH_HEIGHT
-#define SPLASH_WIDTH CUSTOM_SPLASH_WIDTH
+#include "catalog.h"
+#include "versus.h"
+#include "telemetry.h"
+#include "practice.h"
+#include "game_core.h"
+#include "diagnostics.h"
+#include "ghost.h"
+#include "anim.h"
+#include "timer_wheel.h"
+#include "frame_stream.h"
+#include "snapshot.h"
+#include "display_list.h"
+#include "leaderboard.h"
+#include "arena.h"
+#include "achievements.h"
+#include "dither.h"
+#include "icon_cache.h"
+#include "frame_budget.h"
+#include "notify_gate.h"
+#include "scene.h"
+#include "run_input.h"
 
-#define M_PI 3.14159265358979323846
+#define TAG "StratagemHero"
 
-typedef enum {
-    DIRECTION_UP,
-    DIRECTION_DOWN,
-    DIRECTION_LEFT,
-    DIRECTION_RIGHT,
-    DIRECTION_NONE
-} Direction;
+#define LEADERBOARD_TOP 10
 
-typedef struct {
-    char* name;
-    Direction sequence[10];
-    uint8_t length;
-} Stratagem;
+#define VERSUS_BAUD_RATE 115200
+#define VERSUS_RX_BUFFER_SIZE 128
+
+#define STARTUP_PHASE_MAX 12
+#define STARTUP_FLAG_FIRST_FRAME (1 << 0)
+#define STARTUP_FIRST_FRAME_TIMEOUT_MS 200
+
+// What wakes the main loop; it sleeps until one of them is set
+#define MAIN_FLAG_REDRAW (1 << 1)
+#define MAIN_FLAG_SERIAL (1 << 2)
+#define MAIN_FLAG_SAMPLE (1 << 3)
 
+// Redraw cadence while the screen moves on its own: animations, the
+// twinkling menu. Still screens are only redrawn when something changes.
+#define FRAME_INTERVAL_MS 50
+#define FRAME_INTERVAL_MENU_MS 100
+
+// How often an open versus link is ticked for heartbeats and the countdown
+#define VERSUS_POLL_MS 50
+
+// One-shot deadlines on the app's timer wheel
 typedef enum {
-    GAME_STATE_MENU,
-    GAME_STATE_PLAY,
-    GAME_STATE_GAME_OVER,
-    GAME_STATE_STRATAGEM_SUCCESS
-} GameState;
+    WheelEntryFrame, // next redraw
+    WheelEntryExpiry, // the current stratagem runs out of time
+    WheelEntryLanding, // the capsule has landed, back to PLAY
+    WheelEntryShake, // the wrong-key shake is over
+    WheelEntryWelcome, // the next phrase of the welcome tune
+    WheelEntrySample, // the next diagnostics sample
+    WheelEntryLink, // the next versus tick while the link is open
+    WheelEntryCount,
+} WheelEntry;
 
-#define ARROW_HEAD_SIZE 4
-#define ARROW_TAIL_SIZE 4
+// Build profile, picked by the App() target in application.fam. The lite
+// profile has no star field, no music, fewer effects and no frame stream;
+// the code stays in place and the compiler drops what the constants leave
+// unused. What it leaves out of the screens is set in scene.h, the smaller
+// telemetry rings in telemetry.h.
+#ifdef STRATAGEM_HERO_LITE
+#define PROFILE_MUSIC false
+#define PROFILE_FRAME_STREAM false
+#define TRANSITION_FRAME_SIZE 0
+#else
+#define PROFILE_MUSIC true
+#define PROFILE_FRAME_STREAM true
+#define TRANSITION_FRAME_SIZE (128 * 64 / 8)
+#endif
 
-#define MAX_STARS 30
-#define MAX_PLANETS 3
+// What the GUI thread may spend on a frame, build and replay together,
+// before the frame-budget watchdog starts trading looks for input response
+#define FRAME_BUDGET_US 5000
 
-typedef struct {
-    uint8_t x;
-    uint8_t y;
-    uint8_t brightness;
-    uint8_t blink_rate;
-} Star;
+static const char* const quality_tier_names[QualityTierCount] = {
+    "full",
+    "fewer stars",
+    "no planets",
+    "still flag",
+    "no shake",
+};
 
-typedef struct {
-    uint8_t x;
-    uint8_t y;
-    uint8_t size;
-    uint8_t ship_x;
-    uint8_t ship_y;
-} Planet;
+#define HUD_LAYER_SIZE (128 * 64 / 8)
 
+// Replay side of the HUD layer of scene.h: the raster of the last generation drawn
 typedef struct {
-    int16_t shake_offset_x;
-    int16_t shake_offset_y;
-    uint8_t shake_duration;
-} ScreenShake;
+    uint8_t raster[HUD_LAYER_SIZE];
+    uint16_t generation;
+    bool valid;
+} LayerCache;
 
+// Cycle stamps of each startup phase, reported once the app is fully up
 typedef struct {
-    uint8_t x;
-    uint8_t y;
-    uint8_t depth;
-    uint8_t animation_stage;
-    uint8_t duration;
-} StratagemSuccess;
+    uint32_t start;
+    uint32_t first_frame;
+    const char* names[STARTUP_PHASE_MAX];
+    uint32_t cycles[STARTUP_PHASE_MAX];
+    uint8_t count;
+} StartupTrace;
 
 typedef struct {
     Gui* gui;
     ViewPort* view_port;
     
     NotificationApp* notifications;
+    // Under game_mutex; app_notify may be called from any thread
+    NotifyGate notify_gate;
+    uint8_t welcome_phrase; // the next one to post
     
     bool exit_requested;
     
+    // Everything below and every subsystem buffer; sealed before input and
+    // the timer start
+    Arena arena;
+    
+    // Set by the main thread once the work deferred past the first frame
+    // is done; input and the background wait for it
+    bool ready;
+    FuriThreadId main_thread;
+    StartupTrace startup;
+    
     GameState state;
+    GameMode mode;
     
-    Stratagem* stratagems;
-    uint8_t stratagem_count;
-    uint8_t current_stratagem_index;
-    uint8_t current_input_index;
-    uint8_t lives;
-    uint32_t score;
+    GameCore game;
+    uint32_t game_tick;
     uint32_t high_score;
     
-    FuriTimer* timer;
-    uint32_t time_remaining;
-    
-    uint8_t animation_frame;
-    FuriTimer* animation_timer;
+    // Guards the core and the wheel; taken by input, wheel callbacks and
+    // the main loop, always before versus_mutex
+    FuriMutex* game_mutex;
+    TimerWheel wheel;
+    FuriTimer* wheel_timer;
+    bool wheel_armed;
+    bool wheel_firing;
+    uint32_t wheel_armed_at;
     
     bool last_input_success;
     
     bool current_input_correct;
-    uint32_t feedback_timer;
     
-    int8_t scroll_offset;
-    
-    Star stars[MAX_STARS];
-    Planet planets[MAX_PLANETS];
-    
-    ScreenShake screen_shake;
-    StratagemSuccess success_anim;
+    RunInput run_input;
+    TelemetryProducer key_producer; // the thread feeding run_input
+    
+    uint32_t key_down_tick[InputKeyMAX];
+    uint32_t input_press_tick;
+    uint32_t input_latency_max;
+    
+    Telemetry* telemetry;
+    Practice practice;
+    
+    Diagnostics* diagnostics;
+    uint32_t telemetry_wakeups;
+    uint8_t diagnostics_view;
+    bool diagnostics_export_requested;
+    const char* diagnostics_status;
+    
+    Ghost ghost;
+    uint32_t ghost_start_tick;
+    uint32_t ghost_duration;
+    bool ghost_open_requested;
+    bool ghost_save_requested;
+    
+    Achievements achievements;
+    bool achievements_save_requested;
+    uint8_t achievement_toast; // AchievementCount when none is showing
+    uint32_t achievement_toast_tick;
+    
+    // Finished classic runs go to this device's score file; the board screen
+    // merges it with the score files dropped into the import folder
+    uint32_t device_id;
+    LeaderboardRecord score_record;
+    bool score_save_requested;
+    LeaderboardRecord board_merge[LEADERBOARD_TOP];
+    LeaderboardRecord board[LEADERBOARD_TOP];
+    uint16_t board_count;
+    uint16_t board_files;
+    uint8_t board_scroll;
+    bool board_merge_requested;
+    
+    FrameStream* frame_stream;
+    bool frame_stream_toggle_requested;
+    
+    // A run suspended with a long Back, written out on the way out
+    uint8_t snapshot[SNAPSHOT_SIZE];
+    bool snapshot_pending;
+    bool resumed;
+    
+    // Effect state and the HUD layer's generation, read by scene_build
+    Scene scene;
+    LayerCache hud_cache;
+    
+    // Decoded on the game thread ahead of use; icon is the bitmap of
+    // icon_index, the stratagem on screen
+    IconCache icons;
+    const uint8_t* icon;
+    uint8_t icon_index;
+    uint32_t icon_decode_last;
+    uint32_t icon_decode_max;
+    
+    // Built by the main thread under game_mutex into the back list, swapped
+    // in under display_mutex, replayed by the draw callback
+    DisplayList display_lists[2];
+    uint8_t display_front;
+    bool display_valid;
+    FuriMutex* display_mutex;
+    uint32_t scene_build_max;
+    uint32_t scene_replay_max;
+    // Cycles each list took to build, charged to the first frame that
+    // replays it and zeroed then
+    uint32_t display_build_cycles[2];
+    
+    // Fed by the draw callback; the tier is read by scene_build
+    FrameBudget frame_budget;
+    
+    // The last frame the previous screen showed, kept by the draw callback
+    // and blended into the first frames of the next screen
+    uint32_t transition_from[TRANSITION_FRAME_SIZE / 4];
+    bool transition_from_valid;
     
     uint8_t custom_splash[((CUSTOM_SPLASH_WIDTH + 7) / 8) * CUSTOM_SPLASH_HEIGHT];
-} StratagemHeroApp;
-
-const Stratagem STRATAGEMS[] = {
-    // Основные стратагемы
-    {
-        "Resupply", 
-        {DIRECTION_DOWN, DIRECTION_DOWN, DIRECTION_UP, DIRECTION_RIGHT}, 
-        4
-    },
-    {
-        "Reinforce", 
-        {DIRECTION_UP, DIRECTION_DOWN, DIRECTION_RIGHT, DIRECTION_LEFT, DIRECTION_UP}, 
-        5
-    },
-    {
-        "SOS Beacon", 
-        {DIRECTION_UP, DIRECTION_DOWN, DIRECTION_RIGHT, DIRECTION_LEFT}, 
-        4
-    },
-    
-    // Орбитальные удары
-    {
-        "Orbital Strike", 
-        {DIRECTION_RIGHT, DIRECTION_RIGHT, DIRECTION_RIGHT}, 
-        3
-    },
-    {
-        "Orbital Precision Strike", 
-        {DIRECTION_RIGHT, DIRECTION_RIGHT, DIRECTION_UP, DIRECTION_DOWN, DIRECTION_RIGHT}, 
-        5
-    },
-    {
-        "Orbital Gatling Barrage", 
-        {DIRECTION_RIGHT, DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_UP, DIRECTION_RIGHT}, 
-        5
-    },
-    
-    // Оружие поддержки
-    {
-        "Machine Gun", 
-        {DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_RIGHT, DIRECTION_UP}, 
-        4
-    },
-    {
-        "Anti-Materiel Rifle", 
-        {DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_RIGHT, DIRECTION_UP, DIRECTION_DOWN}, 
-        5
-    },
-    {
-        "Stalwart", 
-        {DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_DOWN, DIRECTION_UP, DIRECTION_RIGHT}, 
-        5
-    },
-    
-    // Оборона
-    {
-        "Shield Generator", 
-        {DIRECTION_DOWN, DIRECTION_UP, DIRECTION_LEFT, DIRECTION_RIGHT, DIRECTION_LEFT}, 
-        5
-    },
-    {
-        "Tesla Tower", 
-        {DIRECTION_DOWN, DIRECTION_UP, DIRECTION_RIGHT, DIRECTION_DOWN, DIRECTION_LEFT}, 
-        5
-    },
     
-    // Специальные
-    {
-        "Jump Pack", 
-        {DIRECTION_DOWN, DIRECTION_UP, DIRECTION_UP, DIRECTION_DOWN}, 
-        4
-    },
-    {
-        "HMG Emplacement", 
-        {DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_UP, DIRECTION_RIGHT, DIRECTION_DOWN}, 
-        5
-    },
-    {
-        "Eagle Strafing Run", 
-        {DIRECTION_UP, DIRECTION_RIGHT, DIRECTION_UP}, 
-        3
-    },
-    {
-        "Eagle Airstrike", 
-        {DIRECTION_UP, DIRECTION_RIGHT, DIRECTION_DOWN, DIRECTION_RIGHT}, 
-        4
-    }
-};
+    Versus versus;
+    FuriHalSerialHandle* serial;
+    FuriStreamBuffer* serial_rx;
+    FuriMutex* versus_mutex;
+} StratagemHeroApp;
 
-#define STRATAGEM_COUNT (sizeof(STRATAGEMS) / sizeof(STRATAGEMS[0]))
+#define APP_ARENA_SIZE                                                               \
+    (ARENA_SLOT(sizeof(StratagemHeroApp)) + ARENA_SLOT(TELEMETRY_ARENA_SIZE) +       \
+     ARENA_SLOT(DIAGNOSTICS_ARENA_SIZE))
 
-#define INITIAL_TIME 10000
-#define TIME_DECREASE 2000
-#define MIN_TIME 3000
-#define TIME_BONUS 2000
-#define INITIAL_LIVES 3
-#define MAX_LEVEL 50
+// The arena is not a symbol; tools/size_report.py reads its size from here.
+// volatile keeps the load, and with it the symbol, in the link.
+const volatile uint32_t stratagem_hero_arena_size = APP_ARENA_SIZE;
 
 static const uint8_t custom_splash[] = {
     0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC,
@@ -287,263 +331,282 @@ static const NotificationSequence sequence_navigate = {
     NULL,
 };
 
-static const NotificationSequence sequence_welcome_midi = {
-    // Паттерн 2-5
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5 
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    // Паттерн 2-4
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_g5,  // Нота 4
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    &message_note_g5,  // Нота 4
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_g5,  // Нота 4
-    &message_delay_50,
-    
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_g5,  // Нота 4
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    // Возврат к паттерну 2-5
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_a5,  // Нота 5
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    // Паттерн 2-7
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_b5,  // Нота 7
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    &message_note_b5,  // Нота 7
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_b5,  // Нота 7
-    &message_delay_50,
-    
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_b5,  // Нота 7
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    // Паттерн 2-9
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_d6,  // Нота 9
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    &message_note_d6,  // Нота 9
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_d6,  // Нота 9
-    &message_delay_50,
-    
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    &message_note_d6,  // Нота 9
-    &message_delay_50,
-    &message_note_d5,  // Нота 2
-    &message_delay_50,
-    
-    // Переход к более высоким нотам (A-J-M)
-    &message_note_e6,  // Нота A (14)
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    
-    // Финальная часть MIDI
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    
-    &message_note_e6,  // Нота @
-    &message_delay_50,
-    &message_note_e6,  // Нота @
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    &message_note_e6,  // Нота A
-    &message_delay_50,
-    
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_f6,  // Нота C
-    &message_delay_50,
-    
-    &message_note_f6,  // Нота C
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    &message_note_c6,  // Нота >
-    &message_delay_50,
-    
-    // Завершающие ноты (J-M-J-L-J-M...)
-    &message_note_f6, // Нота J (вместо f#6)
-    &message_delay_50,
-    &message_note_g6,  // Нота M
-    &message_delay_50,
-    &message_note_f6, // Нота J (вместо f#6)
-    &message_delay_50,
-    
-    &message_note_g6,  // Нота L
-    &message_delay_50,
-    &message_note_f6, // Нота J (вместо f#6)
-    &message_delay_50,
-    &message_note_g6,  // Нота M
-    &message_delay_50,
-    
-    &message_note_f6, // Нота J (вместо f#6)
-    &message_delay_50,
-    &message_note_g6,  // Нота Q
-    &message_delay_50,
-    &message_note_f6,  // Нота F
-    &message_delay_50,
-    
-    // Продолжительные ноты из конца MIDI
-    &message_sound_off, // Выключаем предыдущий звук чтобы избежать наложения
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    
-    // A#5 (ближайшая доступная - a5 или b5)
-    &message_note_b5, // Используем b5 как ближайшую к A#5
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    
-    // F5
-    &message_note_f5,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_10,
-    
-    // E5
-    &message_note_e5,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_10,
-    
-    // D5
-    &message_note_d5,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_10,
-    
-    // A4
-    &message_note_a4,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_100,
-    &message_delay_100,
-    
-    // C5
-    &message_note_c5,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_sound_off,
-    &message_delay_10,
-    
-    // D5 (финальная нота)
-    &message_note_d5,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100,
-    &message_delay_100, // Увеличиваем длительность финальной ноты
-    
-    &message_sound_off, // Важно выключить звук в конце последовательности
-    NULL,
+// A phrase per sequence: the notification service plays a sequence to its
+// end, so a run can only cut the tune off between phrases
+#define WELCOME_PHRASE_LENGTH 32
+static const NotificationMessage* const sequence_welcome_midi[][WELCOME_PHRASE_LENGTH] = {
+    {
+        // Паттерн 2-5
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5 
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+    
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    },
+    {
+        // Паттерн 2-4
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_g5,  // Нота 4
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    
+        &message_note_g5,  // Нота 4
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_g5,  // Нота 4
+        &message_delay_50,
+    
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_g5,  // Нота 4
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    },
+    {
+        // Возврат к паттерну 2-5
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+    
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_a5,  // Нота 5
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    },
+    {
+        // Паттерн 2-7
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_b5,  // Нота 7
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    
+        &message_note_b5,  // Нота 7
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_b5,  // Нота 7
+        &message_delay_50,
+    
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_b5,  // Нота 7
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    },
+    {
+        // Паттерн 2-9
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_d6,  // Нота 9
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    
+        &message_note_d6,  // Нота 9
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_d6,  // Нота 9
+        &message_delay_50,
+    
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+        &message_note_d6,  // Нота 9
+        &message_delay_50,
+        &message_note_d5,  // Нота 2
+        &message_delay_50,
+    },
+    {
+        // Переход к более высоким нотам (A-J-M)
+        &message_note_e6,  // Нота A (14)
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+    
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+    
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+    },
+    {
+        // Финальная часть MIDI
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+    
+        &message_note_e6,  // Нота @
+        &message_delay_50,
+        &message_note_e6,  // Нота @
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+    
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+        &message_note_e6,  // Нота A
+        &message_delay_50,
+    
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_f6,  // Нота C
+        &message_delay_50,
+    
+        &message_note_f6,  // Нота C
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+        &message_note_c6,  // Нота >
+        &message_delay_50,
+    },
+    {
+        // Завершающие ноты (J-M-J-L-J-M...)
+        &message_note_f6, // Нота J (вместо f#6)
+        &message_delay_50,
+        &message_note_g6,  // Нота M
+        &message_delay_50,
+        &message_note_f6, // Нота J (вместо f#6)
+        &message_delay_50,
+    
+        &message_note_g6,  // Нота L
+        &message_delay_50,
+        &message_note_f6, // Нота J (вместо f#6)
+        &message_delay_50,
+        &message_note_g6,  // Нота M
+        &message_delay_50,
+    
+        &message_note_f6, // Нота J (вместо f#6)
+        &message_delay_50,
+        &message_note_g6,  // Нота Q
+        &message_delay_50,
+        &message_note_f6,  // Нота F
+        &message_delay_50,
+    },
+    {
+        // Продолжительные ноты из конца MIDI
+        &message_sound_off, // Выключаем предыдущий звук чтобы избежать наложения
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+    },
+    {
+        // A#5 (ближайшая доступная - a5 или b5)
+        &message_note_b5, // Используем b5 как ближайшую к A#5
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+    },
+    {
+        // F5
+        &message_note_f5,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_10,
+    },
+    {
+        // E5
+        &message_note_e5,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_10,
+    },
+    {
+        // D5
+        &message_note_d5,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_10,
+    },
+    {
+        // A4
+        &message_note_a4,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_100,
+        &message_delay_100,
+    },
+    {
+        // C5
+        &message_note_c5,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_sound_off,
+        &message_delay_10,
+    },
+    {
+        // D5 (финальная нота)
+        &message_note_d5,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100,
+        &message_delay_100, // Увеличиваем длительность финальной ноты
+    
+        &message_sound_off, // Важно выключить звук в конце последовательности
+    },
 };
 
 static const NotificationSequence sequence_level_complete = {
@@ -558,537 +621,1134 @@ static const NotificationSequence sequence_level_complete = {
     NULL,
 };
 
-static void init_stars(StratagemHeroApp* app) {
-    if (!app) return;
-    
-    for (int i = 0; i < MAX_STARS; i++) {
-        app->stars[i].x = rand() % 128;
-        app->stars[i].y = rand() % 64;
-        app->stars[i].brightness = rand() % 3;
-        app->stars[i].blink_rate = rand() % 5 + 1;
+// How long the notification service is busy playing a sequence
+static uint32_t notify_duration(const NotificationSequence* sequence) {
+    uint32_t duration = 0;
+    for(const NotificationMessage* const* message = *sequence; *message; message++) {
+        if((*message)->type == NotificationMessageTypeDelay) {
+            duration += (*message)->data.delay.length;
+        }
     }
+    return duration;
 }
 
-static void init_planets(StratagemHeroApp* app) {
-    if (!app) return;
-    
-    for (int i = 0; i < MAX_PLANETS; i++) {
-        app->planets[i].x = 20 + (rand() % 88);
-        app->planets[i].y = 15 + (rand() % 25);
-        app->planets[i].size = 4 + (rand() % 5);
-        // Ensure ship coordinates are valid
-        int range = 5;
-        app->planets[i].ship_x = app->planets[i].x + (rand() % (2*range + 1)) - range;
-        app->planets[i].ship_y = app->planets[i].y + (rand() % (2*range + 1)) - range;
-        
-        // Ensure they're within screen boundaries
-        if (app->planets[i].ship_x >= 128) app->planets[i].ship_x = 127;
-        if (app->planets[i].ship_y >= 64) app->planets[i].ship_y = 63;
+// Every message wakes the notification service, so count it there. During
+// an input burst feedback the service could not keep up with is dropped
+// rather than queued; game over always plays.
+static void app_notify(StratagemHeroApp* app, const NotificationSequence* sequence) {
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    bool admitted = notify_gate_admit(&app->notify_gate, furi_get_tick(), notify_duration(sequence),
+                                      sequence == &sequence_game_over);
+    furi_mutex_release(app->game_mutex);
+    if(!admitted) return;
+    
+    diagnostics_wakeup(app->diagnostics, DiagnosticsThreadNotification);
+    notification_message(app->notifications, sequence);
+}
+
+static void startup_mark(StratagemHeroApp* app, const char* name) {
+    StartupTrace* trace = &app->startup;
+    if(trace->count < STARTUP_PHASE_MAX) {
+        trace->names[trace->count] = name;
+        trace->cycles[trace->count] = DWT->CYCCNT;
+        trace->count++;
     }
 }
 
-static void timer_callback(void* context) {
-    StratagemHeroApp* app = (StratagemHeroApp*)context;
-    
-    if(app->state != GAME_STATE_PLAY && app->state != GAME_STATE_STRATAGEM_SUCCESS) {
-        return;
+static void startup_report(StratagemHeroApp* app) {
+    StartupTrace* trace = &app->startup;
+    uint32_t cycles_per_us = furi_hal_cortex_instructions_per_microsecond();
+    uint32_t last = trace->start;
+    
+    for(uint8_t i = 0; i < trace->count; i++) {
+        FURI_LOG_I(TAG, "startup %-10s +%5luus  at %6luus", trace->names[i],
+                   (trace->cycles[i] - last) / cycles_per_us,
+                   (trace->cycles[i] - trace->start) / cycles_per_us);
+        last = trace->cycles[i];
     }
-    
-    if(app->time_remaining <= 100) {
-        app->lives--;
-        notification_message(app->notifications, &sequence_wrong);
-        
-        if(app->lives <= 0) {
-            app->state = GAME_STATE_GAME_OVER;
-            notification_message(app->notifications, &sequence_game_over);
+    if(trace->first_frame) {
+        FURI_LOG_I(TAG, "startup first frame at %luus",
+                   (trace->first_frame - trace->start) / cycles_per_us);
+    }
+}
+
+static uint8_t practice_pick(uint32_t random, void* context) {
+    StratagemHeroApp* app = context;
+    return practice_sample(&app->practice, random);
+}
+
+// Feeds the stratagem the core just moved past into the practice weights
+static void practice_result(StratagemHeroApp* app, bool completed) {
+    if(app->mode != GAME_MODE_PRACTICE) return;
+    
+    const CatalogEntry* finished = catalog_get(app->game.last_stratagem);
+    practice_record(&app->practice, app->game.last_stratagem,
+                    completed && app->game.last_mistakes == 0, finished->length,
+                    app->game.last_time);
+}
+
+static void practice_load(StratagemHeroApp* app) {
+    practice_init(&app->practice, catalog_count());
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("practice.bin"), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        // Stats are only meaningful for the catalog they were recorded with
+        uint32_t id = 0;
+        size_t size = app->practice.count * sizeof(PracticeStats);
+        if(storage_file_read(file, &id, sizeof(id)) == sizeof(id) && id == catalog_id() &&
+           storage_file_read(file, app->practice.stats, size) == size) {
+            practice_refresh(&app->practice);
         } else {
-            app->current_input_index = 0;
-            app->current_stratagem_index = rand() % STRATAGEM_COUNT;
-            app->time_remaining = INITIAL_TIME;
-            app->current_input_correct = true;
+            practice_init(&app->practice, catalog_count());
         }
-    } else {
-        app->time_remaining -= 100;
     }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
 }
 
-static void animation_timer_callback(void* context) {
-    StratagemHeroApp* app = (StratagemHeroApp*)context;
-    app->animation_frame = (app->animation_frame + 1) % 4;
-    
-    if(app->state == GAME_STATE_MENU) {
-        app->scroll_offset = (app->scroll_offset + 1) % 16;
+static void practice_save(StratagemHeroApp* app) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("practice.bin"), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        uint32_t id = catalog_id();
+        storage_file_write(file, &id, sizeof(id));
+        storage_file_write(file, app->practice.stats, app->practice.count * sizeof(PracticeStats));
     }
-    
-    if(app->feedback_timer > 0) {
-        app->feedback_timer -= 50;
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+static void achievements_load(StratagemHeroApp* app) {
+    uint8_t data[ACHIEVEMENTS_FILE_SIZE];
+    size_t size = 0;
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("achievements.bin"), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        size = storage_file_read(file, data, sizeof(data));
     }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
     
-    if(app->screen_shake.shake_duration > 0) {
-        app->screen_shake.shake_duration--;
-        app->screen_shake.shake_offset_x = (rand() % 5) - 2;
-        app->screen_shake.shake_offset_y = (rand() % 5) - 2;
-    } else {
-        app->screen_shake.shake_offset_x = 0;
-        app->screen_shake.shake_offset_y = 0;
+    achievements_init(&app->achievements, achievements_decode(data, size));
+    app->achievement_toast = AchievementCount;
+}
+
+static void achievements_save(StratagemHeroApp* app) {
+    uint8_t data[ACHIEVEMENTS_FILE_SIZE];
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    achievements_encode(app->achievements.unlocked, data);
+    furi_mutex_release(app->game_mutex);
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("achievements.bin"), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        storage_file_write(file, data, sizeof(data));
     }
-    
-    if(app->state == GAME_STATE_STRATAGEM_SUCCESS) {
-        if(app->success_anim.duration > 0) {
-            app->success_anim.duration--;
-            if(app->success_anim.animation_stage < 5) {
-                app->success_anim.animation_stage++;
-            }
-        } else {
-            app->state = GAME_STATE_PLAY;
-            app->success_anim.animation_stage = 0;
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Callers hold game_mutex; the file is written by the main loop
+static void achievements_emit(StratagemHeroApp* app, AchievementEventType type, uint32_t value) {
+    AchievementEvent event = {
+        .type = type,
+        .stratagem = app->game.last_stratagem,
+        .mistakes = app->game.last_mistakes,
+        .time_ms = app->game.last_time,
+        .value = value,
+    };
+    uint32_t unlocked = achievements_dispatch(&app->achievements, &event);
+    if(!unlocked) return;
+    
+    app->achievement_toast = __builtin_ctz(unlocked);
+    app->achievement_toast_tick = furi_get_tick();
+    app->achievements_save_requested = true;
+}
+
+// The run hash only has to tell runs apart, so whatever makes this run
+// unique goes in: the device, where the generator ended up and the result
+static void score_record_run(StratagemHeroApp* app) {
+    uint32_t fields[] = {
+        app->device_id,
+        app->game.rng_state,
+        app->game.score,
+        app->game.completed,
+        app->ghost_duration,
+    };
+    app->score_record.run_hash = leaderboard_hash(LEADERBOARD_HASH_INIT, fields, sizeof(fields));
+    app->score_record.device_id = app->device_id;
+    app->score_record.score = app->game.score;
+    app->score_record.completed = app->game.completed;
+    app->score_record.level = app->game.level;
+    app->score_save_requested = true;
+}
+
+static void score_save(StratagemHeroApp* app) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("scores.bin"), FSAM_WRITE, FSOM_OPEN_APPEND)) {
+        uint8_t data[LEADERBOARD_RECORD_SIZE];
+        if(storage_file_size(file) == 0) {
+            leaderboard_encode_header(app->device_id, data);
+            storage_file_write(file, data, LEADERBOARD_HEADER_SIZE);
+        }
+        leaderboard_encode_record(&app->score_record, data);
+        storage_file_write(file, data, LEADERBOARD_RECORD_SIZE);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Points the one-shot timer at the earliest wheel deadline. Callers hold
+// game_mutex.
+static void wheel_arm(StratagemHeroApp* app) {
+    uint32_t expires;
+    if(!timer_wheel_next(&app->wheel, &expires)) {
+        // A stale shot just finds nothing due; the timer task cannot stop
+        // its own timer
+        if(app->wheel_armed && !app->wheel_firing) {
+            furi_timer_stop(app->wheel_timer);
+            app->wheel_armed = false;
         }
+        return;
     }
+    if(app->wheel_armed && app->wheel_armed_at == expires) return;
+    
+    uint32_t now = furi_get_tick();
+    uint32_t delay = (int32_t)(expires - now) > 0 ? expires - now : 1;
+    furi_timer_start(app->wheel_timer, delay);
+    app->wheel_armed = true;
+    app->wheel_armed_at = expires;
+}
+
+static void wheel_schedule(StratagemHeroApp* app, WheelEntry entry, uint32_t delay) {
+    timer_wheel_schedule(&app->wheel, entry, furi_get_tick() + delay);
+    wheel_arm(app);
+}
+
+static void wheel_cancel(StratagemHeroApp* app, WheelEntry entry) {
+    timer_wheel_cancel(&app->wheel, entry);
+    wheel_arm(app);
 }
 
-static void draw_star(Canvas* canvas, Star* star, uint8_t anim_frame, int8_t offset_x, int8_t offset_y) {
-    if (!canvas || !star) return;
+// Posts the next phrase of the welcome tune as the last one ends
+static void wheel_welcome_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
     
-    bool should_draw = true;
+    if(app->welcome_phrase >= COUNT_OF(sequence_welcome_midi)) return;
+    const NotificationSequence* phrase = &sequence_welcome_midi[app->welcome_phrase++];
+    app_notify(app, phrase);
+    wheel_schedule(app, WheelEntryWelcome, notify_duration(phrase));
+}
+
+static void app_play_welcome(StratagemHeroApp* app) {
+    if(PROFILE_MUSIC) {
+        furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+        app->welcome_phrase = 0;
+        wheel_welcome_callback(app);
+        furi_mutex_release(app->game_mutex);
+    }
+}
+
+// The core only counts time down when it is stepped, so the deadline is
+// rescheduled after every step
+static void game_schedule_expiry(StratagemHeroApp* app) {
+    if(app->game.over) {
+        wheel_cancel(app, WheelEntryExpiry);
+    } else {
+        timer_wheel_schedule(&app->wheel, WheelEntryExpiry, app->game_tick + app->game.time_remaining);
+        wheel_arm(app);
+    }
+}
+
+// What the progress bar shows between steps. A resumed run's clock only
+// starts once the app is ready.
+static uint32_t game_time_left(StratagemHeroApp* app) {
+    if(!app->ready) return app->game.time_remaining;
     
-    if (star->blink_rate > 0) {
-        should_draw = ((anim_frame / star->blink_rate) % 2 == 0);
+    uint32_t elapsed = furi_get_tick() - app->game_tick;
+    return elapsed < app->game.time_remaining ? app->game.time_remaining - elapsed : 0;
+}
+
+static void start_game(StratagemHeroApp* app, uint32_t seed, TelemetryProducer producer) {
+    game_init(&app->game, app->mode == GAME_MODE_PRACTICE ? practice_pick : NULL, app);
+    
+    GameEvent event = {.type = GameEventStart, .seed = seed};
+    game_step(&app->game, &event, 0);
+    app->game_tick = furi_get_tick();
+    telemetry_log(app->telemetry, producer, TelemetryRecordStart, app->mode, 0, seed, 0);
+    
+    // Classic runs race the stored best and may become the new one; the
+    // app thread opens or closes the file
+    if(app->mode == GAME_MODE_CLASSIC) {
+        ghost_record_start(&app->ghost);
     }
+    app->ghost_start_tick = app->game_tick;
+    app->ghost_open_requested = true;
     
-    if (should_draw) {
-        // Make sure coordinates are within screen bounds
-        uint8_t x = star->x + offset_x;
-        uint8_t y = star->y + offset_y;
-        
-        if (x >= 128 || y >= 64) return;
+    achievements_emit(app, AchievementEventStart, 0);
+    
+    app->current_input_correct = true;
+    run_input_reset(&app->run_input);
+    
+    // The run's cues must not queue behind the menu tune. Only the phrase
+    // already posted still plays, so the gate forgets the rest it booked.
+    wheel_cancel(app, WheelEntryWelcome);
+    notify_gate_reset(&app->notify_gate, furi_get_tick());
+    
+    app->state = GAME_STATE_PLAY;
+    game_schedule_expiry(app);
+}
+
+// Called from inside versus_* calls, which all run under versus_mutex
+static void versus_serial_send(const uint8_t* data, size_t size, void* context) {
+    StratagemHeroApp* app = context;
+    furi_hal_serial_tx(app->serial, data, size);
+}
+
+static void versus_serial_rx_callback(FuriHalSerialHandle* handle, FuriHalSerialRxEvent event, void* context) {
+    StratagemHeroApp* app = context;
+    
+    if(event & FuriHalSerialRxEventData) {
+        uint8_t data = furi_hal_serial_async_rx(handle);
+        furi_stream_buffer_send(app->serial_rx, &data, 1, 0);
+        furi_thread_flags_set(app->main_thread, MAIN_FLAG_SERIAL);
+    }
+}
+
+static void versus_link_open(StratagemHeroApp* app) {
+    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+    if(!app->serial) {
+        app->serial = furi_hal_serial_control_acquire(FuriHalSerialIdUsart);
+        if(app->serial) {
+            versus_init(&app->versus, versus_serial_send, app);
+            furi_hal_serial_init(app->serial, VERSUS_BAUD_RATE);
+            furi_hal_serial_async_rx_start(app->serial, versus_serial_rx_callback, app, false);
+        }
+    }
+    furi_mutex_release(app->versus_mutex);
+    
+    // Stops by itself once the link is closed
+    if(app->serial && !timer_wheel_pending(&app->wheel, WheelEntryLink)) {
+        wheel_schedule(app, WheelEntryLink, VERSUS_POLL_MS);
+    }
+}
+
+static void versus_link_close(StratagemHeroApp* app) {
+    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+    if(app->serial) {
+        furi_hal_serial_async_rx_stop(app->serial);
+        furi_hal_serial_deinit(app->serial);
+        furi_hal_serial_control_release(app->serial);
+        app->serial = NULL;
+    }
+    furi_mutex_release(app->versus_mutex);
+}
+
+static void versus_link_poll(StratagemHeroApp* app) {
+    uint8_t data[VERSUS_FRAME_SIZE * 2];
+    size_t size = furi_stream_buffer_receive(app->serial_rx, data, sizeof(data), 0);
+    
+    bool racing = false;
+    uint32_t seed = 0;
+    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+    if(app->serial) {
+        uint32_t now = furi_get_tick();
+        versus_feed(&app->versus, data, size, now);
+        versus_tick(&app->versus, now);
         
-        if (star->brightness == 0) {
-            canvas_draw_dot(canvas, x, y);
-        } else if (star->brightness == 1) {
-            canvas_draw_dot(canvas, x, y);
-            if (x + 1 < 128) canvas_draw_dot(canvas, x + 1, y);
-            if (y + 1 < 64) canvas_draw_dot(canvas, x, y + 1);
+        racing = app->versus.match == VersusMatchRacing;
+        seed = app->versus.seed;
+    }
+    furi_mutex_release(app->versus_mutex);
+    
+    // game_mutex comes first, so the race starts outside versus_mutex
+    if(racing) {
+        furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+        if(app->state == GAME_STATE_MENU) {
+            start_game(app, seed, TelemetryProducerMain);
+        }
+        furi_mutex_release(app->game_mutex);
+    }
+}
+
+// Returns whether the local side has finished its part of the match
+static bool versus_report(StratagemHeroApp* app, bool completed) {
+    bool done = false;
+    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+    if(app->serial) {
+        if(completed) {
+            versus_report_completion(&app->versus, furi_get_tick());
         } else {
-            if (x > 0) canvas_draw_dot(canvas, x - 1, y);
-            if (x + 1 < 128) canvas_draw_dot(canvas, x + 1, y);
-            if (y > 0) canvas_draw_dot(canvas, x, y - 1);
-            if (y + 1 < 64) canvas_draw_dot(canvas, x, y + 1);
-            canvas_draw_dot(canvas, x, y);
+            versus_report_forfeit(&app->versus, furi_get_tick());
         }
+        done = app->versus.local_done;
     }
+    furi_mutex_release(app->versus_mutex);
+    return done;
 }
 
-static void draw_planet(Canvas* canvas, Planet* planet, int8_t offset_x, int8_t offset_y) {
-    if (!canvas || !planet) return;
+// The match as the screens show it. Returns false while the UART is taken.
+static bool versus_status(StratagemHeroApp* app, VersusStatus* status) {
+    bool linked = false;
+    memset(status, 0, sizeof(*status));
+    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+    if(app->serial) {
+        versus_get_status(&app->versus, furi_get_tick(), status);
+        linked = true;
+    }
+    furi_mutex_release(app->versus_mutex);
+    return linked;
+}
+
+// Steps the core with the real time elapsed since its previous step
+static uint32_t game_dispatch(StratagemHeroApp* app, const GameEvent* event) {
+    uint32_t now = furi_get_tick();
+    uint32_t dt = now - app->game_tick;
+    app->game_tick = now;
+    uint32_t outcome = game_step(&app->game, event, dt);
+    game_schedule_expiry(app);
+    return outcome;
+}
+
+// Sounds, telemetry, animation and versus reporting for what the core did.
+// The producer tells telemetry which thread we are on.
+static void game_feedback(StratagemHeroApp* app, uint32_t outcome, TelemetryProducer producer) {
+    if(outcome & GameOutcomeWrong) {
+        app->current_input_correct = false;
+        app_notify(app, &sequence_wrong);
+        achievements_emit(app, AchievementEventWrong, 0);
+        if(PROFILE_EFFECTS) {
+            app->scene.screen_shake.active = true;
+            app->scene.screen_shake.start_tick = furi_get_tick();
+            wheel_schedule(app, WheelEntryShake, anim_duration(&anim_shake));
+        }
+    } else if(outcome & GameOutcomeCorrect) {
+        app->current_input_correct = true;
+        app_notify(app, &sequence_correct);
+    }
     
-    // Ensure coordinates are within bounds
-    uint8_t x = planet->x + offset_x;
-    uint8_t y = planet->y + offset_y;
+    if(outcome & GameOutcomeCompleted) {
+        const CatalogEntry* finished = catalog_get(app->game.last_stratagem);
+        app->last_input_success = true;
+        
+        app_notify(app, &sequence_level_complete);
+        telemetry_log(app->telemetry, producer, TelemetryRecordCompletion,
+                      app->game.last_stratagem, finished->length,
+                      app->game.last_time, app->game.score);
+        practice_result(app, true);
+        achievements_emit(app, AchievementEventCompletion, app->game.score);
+        if(app->mode == GAME_MODE_CLASSIC) {
+            ghost_record_completion(&app->ghost, furi_get_tick() - app->ghost_start_tick, finished->length);
+        }
+        
+        if(app->state != GAME_STATE_STRATAGEM_SUCCESS) {
+            app->state = GAME_STATE_STRATAGEM_SUCCESS;
+            app->scene.success_anim.start_tick = furi_get_tick();
+            wheel_schedule(app, WheelEntryLanding, anim_duration(&anim_capsule));
+        }
+        
+        if(app->mode == GAME_MODE_VERSUS) {
+            if(versus_report(app, true)) {
+                app->state = GAME_STATE_GAME_OVER;
+            }
+        }
+    }
     
-    if (x >= 128 || y >= 64) return;
+    if(outcome & GameOutcomeTimeout) {
+        app->current_input_correct = true;
+        app_notify(app, &sequence_wrong);
+        telemetry_log(app->telemetry, producer, TelemetryRecordTimeout,
+                      app->game.last_stratagem, app->game.lives, 0, app->game.score);
+        practice_result(app, false);
+        achievements_emit(app, AchievementEventTimeout, 0);
+        achievements_emit(app, AchievementEventLifeLost, app->game.lives);
+    }
     
-    canvas_draw_circle(canvas, x, y, planet->size);
+    if(outcome & GameOutcomeGameOver) {
+        if(app->mode == GAME_MODE_VERSUS) {
+            versus_report(app, false);
+        } else if(app->mode == GAME_MODE_CLASSIC) {
+            app->ghost_duration = furi_get_tick() - app->ghost_start_tick;
+            app->ghost_save_requested = true;
+            score_record_run(app);
+        }
+        app->state = GAME_STATE_GAME_OVER;
+        app_notify(app, &sequence_game_over);
+        telemetry_log(app->telemetry, producer, TelemetryRecordGameOver,
+                      app->mode, app->game.level, app->game.score, 0);
+    }
+}
+
+static void wheel_expiry_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
     
-    uint8_t ring_size = planet->size + 2;
-    if (rand() % 3 == 0) {
-        canvas_draw_circle(canvas, x, y, ring_size);
+    if(app->state != GAME_STATE_PLAY && app->state != GAME_STATE_STRATAGEM_SUCCESS) {
+        return;
     }
     
-    uint8_t ship_x = planet->ship_x + offset_x;
-    uint8_t ship_y = planet->ship_y + offset_y;
+    GameEvent event = {.type = GameEventTick};
+    game_feedback(app, game_dispatch(app, &event), TelemetryProducerTimer);
+}
+
+static uint32_t apply_direction(StratagemHeroApp* app, Direction input_dir, TelemetryProducer producer) {
+    uint8_t position = app->game.input_index;
+    uint32_t elapsed = app->game.stratagem_time;
     
-    if (ship_x >= 128 || ship_y >= 64) return;
+    GameEvent event = {.type = GameEventKey, .direction = input_dir};
+    uint32_t outcome = game_dispatch(app, &event);
     
-    if (ship_x >= 2 && ship_x + 2 < 128) {
-        canvas_draw_line(canvas, 
-                        ship_x - 2, ship_y, 
-                        ship_x + 2, ship_y);
+    if(outcome & (GameOutcomeCorrect | GameOutcomeWrong)) {
+        telemetry_log(app->telemetry, producer, TelemetryRecordKey,
+                      input_dir, (outcome & GameOutcomeCorrect) != 0, position,
+                      elapsed);
+    }
+    if(outcome & GameOutcomeWrong) {
+        telemetry_log(app->telemetry, producer, TelemetryRecordMistake,
+                      app->game.stratagem, position,
+                      app->game.time_remaining, app->game.score);
+    }
+    game_feedback(app, outcome, producer);
+    return outcome;
+}
+
+static uint32_t app_key_apply(Direction direction, void* context) {
+    StratagemHeroApp* app = context;
+    return apply_direction(app, direction, app->key_producer);
+}
+
+static void icon_decode_done(StratagemHeroApp* app, uint32_t start) {
+    app->icon_decode_last = DWT->CYCCNT - start;
+    if(app->icon_decode_last > app->icon_decode_max) app->icon_decode_max = app->icon_decode_last;
+}
+
+// Looks the icon up once per stratagem and keeps the next one decoded while
+// the current one is entered. Touching the current icon every frame keeps
+// it and the next one the two most recent in the cache, so a prefetch never
+// evicts a bitmap a display list still points at. Callers hold game_mutex.
+static void icon_update(StratagemHeroApp* app) {
+    if(app->state != GAME_STATE_PLAY && app->state != GAME_STATE_STRATAGEM_SUCCESS) return;
+    
+    uint32_t start = DWT->CYCCNT;
+    if(app->icon_index != app->game.stratagem) {
+        uint32_t misses = app->icons.misses;
+        app->icon = icon_cache_get(&app->icons, app->game.stratagem);
+        app->icon_index = app->game.stratagem;
+        if(app->icons.misses != misses) icon_decode_done(app, start);
+    } else {
+        icon_cache_prefetch(&app->icons, app->game.stratagem);
     }
     
-    if (ship_y >= 1 && ship_y + 1 < 64) {
-        canvas_draw_line(canvas, 
-                        ship_x, ship_y - 1, 
-                        ship_x, ship_y + 1);
+    start = DWT->CYCCNT;
+    if(icon_cache_prefetch(&app->icons, game_peek_next(&app->game))) {
+        icon_decode_done(app, start);
     }
 }
 
-static void draw_space_background(Canvas* canvas, StratagemHeroApp* app) {
-    int8_t offset_x = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_x : 0;
-    int8_t offset_y = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_y : 0;
+// What scene_build draws from, as of now. Callers hold game_mutex.
+static void app_scene_frame(StratagemHeroApp* app, SceneFrame* frame) {
+    memset(frame, 0, sizeof(*frame));
+    frame->now = furi_get_tick();
+    frame->state = app->state;
+    frame->mode = app->mode;
+    frame->quality = __atomic_load_n(&app->frame_budget.tier, __ATOMIC_RELAXED);
+    
+    frame->game = &app->game;
+    frame->time_left = game_time_left(app);
+    frame->high_score = app->high_score;
+    frame->splash = app->custom_splash;
+    frame->icon = app->icon;
+    
+    bool playing = app->state == GAME_STATE_PLAY || app->state == GAME_STATE_STRATAGEM_SUCCESS;
+    if(app->mode == GAME_MODE_CLASSIC && app->ghost.available) {
+        frame->ghost = true;
+        frame->ghost_best = app->ghost.best_score;
+        if(playing) {
+            frame->ghost_score = ghost_score_at(&app->ghost, frame->now - app->ghost_start_tick);
+        }
+    }
     
-    for (int i = 0; i < MAX_STARS; i++) {
-        draw_star(canvas, &app->stars[i], app->animation_frame, offset_x, offset_y);
+    // A copy, so versus_mutex is not held while drawing
+    if(app->mode == GAME_MODE_VERSUS) {
+        frame->linked = versus_status(app, &frame->race);
     }
     
-    for (int i = 0; i < MAX_PLANETS; i++) {
-        draw_planet(canvas, &app->planets[i], offset_x, offset_y);
+    frame->achievement_toast = app->achievement_toast;
+    frame->achievement_toast_tick = app->achievement_toast_tick;
+    
+    if(app->state == GAME_STATE_DIAGNOSTICS) {
+        frame->diagnostics = diagnostics_get(app->diagnostics, app->diagnostics_view);
+        for(uint8_t i = 0; i < DiagnosticsThreadCount; i++) {
+            frame->thread_labels[i] = diagnostics_thread_label(i);
+        }
+        frame->diagnostics_view = app->diagnostics_view;
+        frame->diagnostics_status = app->diagnostics_status;
+        frame->icon_hits = app->icons.hits;
+        frame->icon_misses = app->icons.misses;
+        frame->icon_decode_max_us = app->icon_decode_max / furi_hal_cortex_instructions_per_microsecond();
     }
+    
+    frame->board = app->board;
+    frame->board_count = app->board_count;
+    frame->board_files = app->board_files;
+    frame->board_scroll = app->board_scroll;
+    frame->device_id = app->device_id;
 }
 
-static void draw_arrow_bitmap(Canvas* canvas, Direction dir, uint8_t x, uint8_t y, bool filled, int8_t offset_x, int8_t offset_y) {
-    uint8_t center_x = x + offset_x;
-    uint8_t center_y = y + offset_y;
-    
-    switch(dir) {
-        case DIRECTION_UP:
-            canvas_draw_line(canvas, center_x, center_y - ARROW_HEAD_SIZE, center_x - ARROW_HEAD_SIZE, center_y);
-            canvas_draw_line(canvas, center_x, center_y - ARROW_HEAD_SIZE, center_x + ARROW_HEAD_SIZE, center_y);
-            
-            if(filled) {
-                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
-                    canvas_draw_line(canvas, center_x - j, center_y - ARROW_HEAD_SIZE + j, center_x + j, center_y - ARROW_HEAD_SIZE + j);
-                }
-            }
-            
-            canvas_draw_line(canvas, center_x, center_y, center_x, center_y + ARROW_TAIL_SIZE);
-            break;
-            
-        case DIRECTION_DOWN:
-            canvas_draw_line(canvas, center_x, center_y + ARROW_HEAD_SIZE, center_x - ARROW_HEAD_SIZE, center_y);
-            canvas_draw_line(canvas, center_x, center_y + ARROW_HEAD_SIZE, center_x + ARROW_HEAD_SIZE, center_y);
-            
-            if(filled) {
-                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
-                    canvas_draw_line(canvas, center_x - j, center_y + ARROW_HEAD_SIZE - j, center_x + j, center_y + ARROW_HEAD_SIZE - j);
+// Builds the scene into the back list and swaps it in, then asks the GUI
+// for a frame. Only the main thread builds; callers hold game_mutex.
+static void app_build(StratagemHeroApp* app) {
+    uint32_t start = DWT->CYCCNT;
+    DisplayList* back = &app->display_lists[app->display_front ^ 1];
+    scene_transition_update(&app->scene, app->state, furi_get_tick());
+    icon_update(app);
+    SceneFrame frame;
+    app_scene_frame(app, &frame);
+    scene_build(&app->scene, &frame, back);
+    uint32_t cycles = DWT->CYCCNT - start;
+    if(cycles > app->scene_build_max) app->scene_build_max = cycles;
+    
+    furi_mutex_acquire(app->display_mutex, FuriWaitForever);
+    app->display_build_cycles[app->display_front ^ 1] = cycles;
+    app->display_front ^= 1;
+    app->display_valid = true;
+    furi_mutex_release(app->display_mutex);
+    
+    view_port_update(app->view_port);
+}
+
+// Asks the main thread for a frame. Input and the wheel only change state;
+// the frame shows the state as of when the main thread gets to it.
+static void app_redraw(StratagemHeroApp* app) {
+    furi_thread_flags_set(app->main_thread, MAIN_FLAG_REDRAW);
+}
+
+_Static_assert((int)DisplayListColorBlack == ColorBlack && (int)DisplayListColorWhite == ColorWhite,
+               "Display list colours are the canvas values");
+_Static_assert((int)DisplayListFontPrimary == FontPrimary && (int)DisplayListFontSecondary == FontSecondary,
+               "Display list fonts are the canvas values");
+_Static_assert((int)DisplayListAlignLeft == AlignLeft && (int)DisplayListAlignRight == AlignRight &&
+               (int)DisplayListAlignTop == AlignTop && (int)DisplayListAlignBottom == AlignBottom &&
+               (int)DisplayListAlignCenter == AlignCenter,
+               "Display list alignments are the canvas values");
+
+// Returns whether the frame was blended with the previous screen
+static bool scene_replay(StratagemHeroApp* app, Canvas* canvas, const DisplayList* list) {
+    LayerCache* cache = &app->hud_cache;
+    uint8_t* buffer = canvas_get_buffer(canvas);
+    size_t size = canvas_get_buffer_size(canvas);
+    if(size > sizeof(cache->raster)) size = sizeof(cache->raster);
+    
+    bool capturing = false;
+    bool blended = false;
+    
+    for(uint16_t i = 0; i < list->count; i++) {
+        const DisplayListCommand* command = &list->commands[i];
+        
+        switch(command->op) {
+            case DisplayListOpClear:
+                canvas_clear(canvas);
+                break;
+            case DisplayListOpColor:
+                canvas_set_color(canvas, command->arg);
+                break;
+            case DisplayListOpFont:
+                canvas_set_font(canvas, command->arg);
+                break;
+            case DisplayListOpDot:
+                canvas_draw_dot(canvas, command->x, command->y);
+                break;
+            case DisplayListOpLine:
+                canvas_draw_line(canvas, command->x, command->y, (int8_t)command->w, (int8_t)command->h);
+                break;
+            case DisplayListOpBox:
+                canvas_draw_box(canvas, command->x, command->y, command->w, command->h);
+                break;
+            case DisplayListOpFrame:
+                canvas_draw_frame(canvas, command->x, command->y, command->w, command->h);
+                break;
+            case DisplayListOpCircle:
+                canvas_draw_circle(canvas, command->x, command->y, command->w);
+                break;
+            case DisplayListOpStr:
+                canvas_draw_str(canvas, command->x, command->y, display_list_text(list, command));
+                break;
+            case DisplayListOpStrAligned:
+                canvas_draw_str_aligned(canvas, command->x, command->y, command->arg & 0x0F, command->arg >> 4,
+                                        display_list_text(list, command));
+                break;
+            case DisplayListOpXbm:
+                canvas_draw_xbm(canvas, command->x, command->y, command->w, command->h,
+                                display_list_bitmap(list, command));
+                break;
+            case DisplayListOpShift:
+                scene_shift(buffer, command->x, command->y);
+                break;
+            case DisplayListOpLayerBegin:
+                if(cache->valid && cache->generation == display_list_generation(command)) {
+                    memcpy(buffer, cache->raster, size);
+                    while(i + 1 < list->count && list->commands[i + 1].op != DisplayListOpLayerEnd) {
+                        i++;
+                    }
+                } else {
+                    cache->generation = display_list_generation(command);
+                    capturing = true;
                 }
-            }
-            
-            canvas_draw_line(canvas, center_x, center_y, center_x, center_y - ARROW_TAIL_SIZE);
-            break;
-            
-        case DIRECTION_LEFT:
-            canvas_draw_line(canvas, center_x - ARROW_HEAD_SIZE, center_y, center_x, center_y - ARROW_HEAD_SIZE);
-            canvas_draw_line(canvas, center_x - ARROW_HEAD_SIZE, center_y, center_x, center_y + ARROW_HEAD_SIZE);
-            
-            if(filled) {
-                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
-                    canvas_draw_line(canvas, center_x - ARROW_HEAD_SIZE + j, center_y - j, center_x - ARROW_HEAD_SIZE + j, center_y + j);
+                break;
+            case DisplayListOpLayerEnd:
+                if(capturing) {
+                    memcpy(cache->raster, buffer, size);
+                    cache->valid = true;
+                    capturing = false;
                 }
-            }
-            
-            canvas_draw_line(canvas, center_x, center_y, center_x + ARROW_TAIL_SIZE, center_y);
-            break;
-            
-        case DIRECTION_RIGHT:
-            canvas_draw_line(canvas, center_x + ARROW_HEAD_SIZE, center_y, center_x, center_y - ARROW_HEAD_SIZE);
-            canvas_draw_line(canvas, center_x + ARROW_HEAD_SIZE, center_y, center_x, center_y + ARROW_HEAD_SIZE);
-            
-            if(filled) {
-                for(int j = 1; j < ARROW_HEAD_SIZE; j++) {
-                    canvas_draw_line(canvas, center_x + ARROW_HEAD_SIZE - j, center_y - j, center_x + ARROW_HEAD_SIZE - j, center_y + j);
+                break;
+            case DisplayListOpTransition:
+                if(app->transition_from_valid && size <= sizeof(app->transition_from)) {
+                    const uint8_t* from = (const uint8_t*)app->transition_from;
+                    if(command->arg == TransitionKindFade) {
+                        dither_fade(buffer, from, command->w * DITHER_LEVELS / 255, size);
+                    } else {
+                        dither_wipe(buffer, from, command->w * (DITHER_FRAME_WIDTH + DITHER_WIPE_BAND) / 255,
+                                    command->arg == TransitionKindWipeOut, size);
+                    }
+                    blended = true;
                 }
-            }
-            
-            canvas_draw_line(canvas, center_x, center_y, center_x - ARROW_TAIL_SIZE, center_y);
-            break;
-            
-        default:
-            break;
+                break;
+            default:
+                break;
+        }
     }
+    
+    return blended;
 }
 
-static void draw_stratagem_success_animation(Canvas* canvas, StratagemHeroApp* app) {
-    int8_t offset_x = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_x : 0;
-    int8_t offset_y = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_y : 0;
+static void app_draw_callback(Canvas* canvas, void* ctx) {
+    StratagemHeroApp* app = (StratagemHeroApp*)ctx;
+    diagnostics_wakeup(app->diagnostics, DiagnosticsThreadGui);
     
-    uint8_t x = app->success_anim.x + offset_x;
-    uint8_t y = app->success_anim.y + offset_y;
-    uint8_t stage = app->success_anim.animation_stage;
+    if(!app->startup.first_frame) {
+        app->startup.first_frame = DWT->CYCCNT;
+        furi_thread_flags_set(app->main_thread, STARTUP_FLAG_FIRST_FRAME);
+    }
     
-    canvas_set_color(canvas, ColorBlack);
+    // Press-to-frame latency of the last arrow, visible with `log debug`
+    if(app->input_press_tick) {
+        uint32_t latency = furi_get_tick() - app->input_press_tick;
+        app->input_press_tick = 0;
+        if(latency > app->input_latency_max) app->input_latency_max = latency;
+        FURI_LOG_D(TAG, "input latency %lums, max %lums", latency, app->input_latency_max);
+        telemetry_log(app->telemetry, TelemetryProducerInput, TelemetryRecordLatency,
+                      app->state, 0, latency, app->input_latency_max);
+    }
     
-    // Always draw ground/platform
-    canvas_draw_line(canvas, x - 20, y + 20, x + 20, y + 20);
+    // Nothing but the replay; the list cannot be swapped out underneath it
+    uint32_t start = DWT->CYCCNT;
+    bool blended = false;
+    uint32_t build_cycles = 0;
+    furi_mutex_acquire(app->display_mutex, FuriWaitForever);
+    if(app->display_valid) {
+        blended = scene_replay(app, canvas, &app->display_lists[app->display_front]);
+        build_cycles = app->display_build_cycles[app->display_front];
+        app->display_build_cycles[app->display_front] = 0;
+    }
+    furi_mutex_release(app->display_mutex);
+    uint32_t cycles = DWT->CYCCNT - start;
+    if(cycles > app->scene_replay_max) app->scene_replay_max = cycles;
+    
+    FrameBudget* budget = &app->frame_budget;
+    FrameBudgetChange change = frame_budget_record(budget, build_cycles + cycles);
+    uint32_t cycles_per_us = furi_hal_cortex_instructions_per_microsecond();
+    if(change == FrameBudgetChangeDegraded) {
+        FURI_LOG_I(TAG, "quality %s -> %s: %u of the last %u frames over %luus, worst %luus",
+                   quality_tier_names[budget->tier - 1], quality_tier_names[budget->tier],
+                   budget->change_over, FRAME_BUDGET_WINDOW, budget->budget / cycles_per_us,
+                   budget->change_peak / cycles_per_us);
+    } else if(change == FrameBudgetChangeRestored) {
+        FURI_LOG_I(TAG, "quality %s -> %s: %u frames in a row under %luus",
+                   quality_tier_names[budget->tier + 1], quality_tier_names[budget->tier],
+                   FRAME_BUDGET_HEADROOM_FRAMES, budget->budget / 2 / cycles_per_us);
+    }
+    
+    // Keep the frame for the next transition, but not one that is already
+    // half of the last transition
+    size_t size = canvas_get_buffer_size(canvas);
+    if(PROFILE_EFFECTS && !blended && size <= sizeof(app->transition_from)) {
+        memcpy(app->transition_from, canvas_get_buffer(canvas), size);
+        app->transition_from_valid = true;
+    }
+    
+    // Last, so the stream sees exactly what goes to the display
+    if(PROFILE_FRAME_STREAM) {
+        furi_mutex_acquire(app->display_mutex, FuriWaitForever);
+        frame_stream_capture(app->frame_stream, canvas_get_buffer(canvas), canvas_get_buffer_size(canvas));
+        furi_mutex_release(app->display_mutex);
+    }
+}
+
+static void wheel_landing_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
     
-    // Only draw capsule and effects during animation
     if(app->state == GAME_STATE_STRATAGEM_SUCCESS) {
-        if (stage >= 1) {
-            uint8_t capsule_length = 10;
-            uint8_t capsule_width = 5;
-            uint8_t impact_y = y + 10 + stage * 2;
-            
-            canvas_draw_circle(canvas, x, impact_y - capsule_length/2, capsule_width/2);
-            canvas_draw_box(canvas, x - capsule_width/2, impact_y - capsule_length/2, capsule_width, capsule_length);
-            canvas_draw_circle(canvas, x, impact_y + capsule_length/2, capsule_width/2);
-        }
+        app->state = GAME_STATE_PLAY;
+        app->key_producer = TelemetryProducerTimer;
         
-        if (stage >= 2) {
-            canvas_draw_line(canvas, x - 10, y + 20, x - 5, y + 20 + 3);
-            canvas_draw_line(canvas, x + 10, y + 20, x + 5, y + 20 + 3);
-        }
-        
-        if (stage >= 3) {
-            canvas_draw_line(canvas, x - 15, y + 20, x - 12, y + 20 + 5);
-            canvas_draw_line(canvas, x + 15, y + 20, x + 12, y + 20 + 5);
-        }
-        
-        if (stage >= 4) {
-            canvas_draw_line(canvas, x - 18, y + 20, x - 17, y + 20 + 7);
-            canvas_draw_line(canvas, x + 18, y + 20, x + 17, y + 20 + 7);
+        // The next stratagem's time counts from here, before any typed-ahead key
+        GameEvent event = {.type = GameEventReveal};
+        game_feedback(app, game_dispatch(app, &event), TelemetryProducerTimer);
+        if(app->state == GAME_STATE_PLAY) {
+            run_input_drain(&app->run_input, RunPhasePlay);
         }
+        app_redraw(app);
     }
 }
 
-static void app_draw_callback(Canvas* canvas, void* ctx) {
-    StratagemHeroApp* app = (StratagemHeroApp*)ctx;
+static void wheel_shake_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
+    app->scene.screen_shake.active = false;
+    app_redraw(app);
+}
+
+// The next frame is asked for once this one is built, see app_frame_schedule()
+static void wheel_frame_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
+    app_redraw(app);
+}
+
+static void wheel_sample_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
+    furi_thread_flags_set(app->main_thread, MAIN_FLAG_SAMPLE);
+    timer_wheel_schedule(&app->wheel, WheelEntrySample, furi_get_tick() + DIAGNOSTICS_SAMPLE_INTERVAL_MS);
+}
+
+static void wheel_link_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
+    if(!app->serial) return;
+    furi_thread_flags_set(app->main_thread, MAIN_FLAG_SERIAL);
+    timer_wheel_schedule(&app->wheel, WheelEntryLink, furi_get_tick() + VERSUS_POLL_MS);
+}
+
+// How soon the screen changes with no event behind it, 0 when it does not:
+// the diagnostics and leaderboard, and the lite build's menu and game over
+static uint32_t app_frame_interval(const StratagemHeroApp* app, uint32_t now) {
+    bool toast = app->achievement_toast < AchievementCount &&
+                 now - app->achievement_toast_tick < ACHIEVEMENT_TOAST_MS;
+    if(app->scene.transition_kind != TransitionKindNone || app->scene.screen_shake.active || toast) {
+        return FRAME_INTERVAL_MS;
+    }
+    
+    switch(app->state) {
+        case GAME_STATE_PLAY:
+        case GAME_STATE_STRATAGEM_SUCCESS:
+            // The time bar, the landing and the ghost
+            return FRAME_INTERVAL_MS;
+        case GAME_STATE_MENU:
+            // The stars, or the link readout and the countdown
+            return MAX_STARS > 0 || app->mode == GAME_MODE_VERSUS ? FRAME_INTERVAL_MENU_MS : 0;
+        case GAME_STATE_GAME_OVER:
+            // The stars and the flag, or a versus result still to come
+            return PROFILE_EFFECTS || app->mode == GAME_MODE_VERSUS ? FRAME_INTERVAL_MS : 0;
+        default:
+            return 0;
+    }
+}
+
+// Asks for the next frame after one is built, while the screen moves.
+// Callers hold game_mutex.
+static void app_frame_schedule(StratagemHeroApp* app) {
+    if(timer_wheel_pending(&app->wheel, WheelEntryFrame)) return;
+    uint32_t interval = app_frame_interval(app, furi_get_tick());
+    if(interval) wheel_schedule(app, WheelEntryFrame, interval);
+}
+
+// The only timer the app runs: one shot at the earliest wheel deadline
+static void wheel_timer_callback(void* context) {
+    StratagemHeroApp* app = (StratagemHeroApp*)context;
+    diagnostics_wakeup(app->diagnostics, DiagnosticsThreadTimer);
+    
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    app->wheel_armed = false;
+    app->wheel_firing = true;
+    timer_wheel_advance(&app->wheel, furi_get_tick());
+    app->wheel_firing = false;
+    wheel_arm(app);
+    furi_mutex_release(app->game_mutex);
+}
+
+static void run_abandon(StratagemHeroApp* app) {
+    if(app->mode == GAME_MODE_VERSUS) {
+        versus_report(app, false);
+        furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+        versus_reset_match(&app->versus);
+        furi_mutex_release(app->versus_mutex);
+    }
+    app->state = GAME_STATE_MENU;
+    wheel_cancel(app, WheelEntryExpiry);
+    app_notify(app, &sequence_navigate);
     
-    canvas_clear(canvas);
-    canvas_set_font(canvas, FontPrimary);
+    app_play_welcome(app);
+}
+
+static uint16_t run_effect_ms(bool running, uint32_t start_tick) {
+    if(!running) return SNAPSHOT_EFFECT_NONE;
+    uint32_t elapsed = furi_get_tick() - start_tick;
+    return elapsed < SNAPSHOT_EFFECT_NONE ? elapsed : SNAPSHOT_EFFECT_NONE - 1;
+}
+
+// Freezes the run into app->snapshot and leaves; the app thread writes it
+static void run_suspend(StratagemHeroApp* app) {
+    uint32_t now = furi_get_tick();
+    
+    GameCore game = app->game;
+    game.time_remaining = game_time_left(app);
+    game.stratagem_time += now - app->game_tick;
+    
+    SnapshotRun run = {
+        .mode = app->mode,
+        .input_correct = app->current_input_correct,
+        .run_ms = now - app->ghost_start_tick,
+        .landing_ms = run_effect_ms(app->state == GAME_STATE_STRATAGEM_SUCCESS, app->scene.success_anim.start_tick),
+        .shake_ms = run_effect_ms(app->scene.screen_shake.active, app->scene.screen_shake.start_tick),
+    };
+    snapshot_encode(&game, &run, app->snapshot);
+    
+    wheel_cancel(app, WheelEntryExpiry);
+    app->snapshot_pending = true;
+    app->exit_requested = true;
+}
+
+static void snapshot_save(StratagemHeroApp* app) {
+    if(!app->snapshot_pending) return;
     
-    if(app->state == GAME_STATE_MENU) {
-        draw_space_background(canvas, app);
-        
-        int8_t offset_x = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_x : 0;
-        int8_t offset_y = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_y : 0;
-        
-        uint8_t centered_x = (128 - SPLASH_WIDTH) / 2;
-        uint8_t centered_y = (64 - SPLASH_HEIGHT) / 2;
-        
-        canvas_set_color(canvas, ColorBlack);
-        canvas_draw_box(canvas, 
-                      centered_x - 5 + offset_x, 
-                      centered_y - 5 + offset_y, 
-                      SPLASH_WIDTH + 10, 
-                      SPLASH_HEIGHT + 10);
-        
-        canvas_set_color(canvas, ColorWhite);
-        for(uint16_t y = 0; y < SPLASH_HEIGHT; y++) {
-            for(uint16_t x = 0; x < SPLASH_WIDTH; x++) {
-                uint16_t byte_index = (y * ((SPLASH_WIDTH + 7) / 8)) + (x / 8);
-                uint8_t bit_position = 7 - (x % 8);
-                
-                if(app->custom_splash[byte_index] & (1 << bit_position)) {
-                    canvas_draw_dot(canvas, centered_x + x + offset_x, centered_y + y + offset_y);
-                }
-            }
-        }
-        
-        canvas_set_color(canvas, ColorBlack);
-        canvas_draw_frame(canvas, 
-                        centered_x - 5 + offset_x, 
-                        centered_y - 5 + offset_y, 
-                        SPLASH_WIDTH + 10, 
-                        SPLASH_HEIGHT + 10);
-        
-        canvas_set_font(canvas, FontSecondary);
-        canvas_draw_str_aligned(canvas, 
-                              64 + offset_x, 
-                              centered_y + SPLASH_HEIGHT + 15 + offset_y, 
-                              AlignCenter, 
-                              AlignCenter, 
-                              "PRESS OK TO DEPLOY");
-        
-        canvas_set_color(canvas, ColorWhite);
-        canvas_draw_box(canvas, 0, 52, 128, 12);
-        canvas_set_color(canvas, ColorBlack);
-        
-        if(app->high_score > 0) {
-            char score_str[32];
-            snprintf(score_str, sizeof(score_str), "HIGH SCORE: %lu", app->high_score);
-            
-            canvas_set_color(canvas, ColorWhite);
-            canvas_draw_box(canvas, 0, 0, 128, 10);
-            canvas_set_color(canvas, ColorBlack);
-            canvas_draw_str_aligned(canvas, 64, 8, AlignCenter, AlignCenter, score_str);
-        }
-        
-    } else if(app->state == GAME_STATE_PLAY || app->state == GAME_STATE_STRATAGEM_SUCCESS) {
-        int8_t offset_x = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_x : 0;
-        int8_t offset_y = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_y : 0;
-        
-        Stratagem current = STRATAGEMS[app->current_stratagem_index];
-        
-        canvas_set_font(canvas, FontPrimary);
-        canvas_draw_str(canvas, 2 + offset_x, 12 + offset_y, current.name);
-        
-        canvas_draw_frame(canvas, 0 + offset_x, 0 + offset_y, 128, 64);
-        
-        uint8_t progress_width = (120 * app->time_remaining) / INITIAL_TIME;
-        if(progress_width > 120) progress_width = 120;
-        
-        canvas_draw_frame(canvas, 4 + offset_x, 16 + offset_y, 120, 6);
-        canvas_draw_box(canvas, 4 + offset_x, 16 + offset_y, progress_width, 6);
-        
-        for(uint8_t i = 0; i < app->lives; i++) {
-            uint8_t heart_x = 104 + (i * 8);
-            uint8_t heart_y = 8;
-            
-            canvas_draw_box(canvas, heart_x + offset_x, heart_y + offset_y, 6, 6);
-            canvas_draw_line(canvas, 
-                           heart_x + 2 + offset_x, 
-                           heart_y + 1 + offset_y, 
-                           heart_x + 2 + offset_x, 
-                           heart_y + 1 + offset_y);
-        }
-        
-        draw_stratagem_success_animation(canvas, app);
-        
-        uint8_t direction_size = 16;
-        uint8_t total_width = current.length * (direction_size + 2);
-        uint8_t start_x = (128 - total_width) / 2;
-        
-        for(uint8_t i = 0; i < current.length; i++) {
-            uint8_t x = start_x + i * (direction_size + 2) + direction_size/2;
-            uint8_t y = 24 + direction_size/2;
-            bool filled = false;
-            
-            if(app->state == GAME_STATE_PLAY || app->state == GAME_STATE_STRATAGEM_SUCCESS) {
-                filled = i < app->current_input_index;
-                if(i == app->current_input_index) {
-                    canvas_draw_frame(canvas, x - 10 + offset_x, y - 10 + offset_y, 20, 20);
-                }
-            }
-            
-            draw_arrow_bitmap(canvas, current.sequence[i], x, y, filled, offset_x, offset_y);
-        }
-        
-    } else if(app->state == GAME_STATE_GAME_OVER) {
-        int8_t offset_x = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_x : 0;
-        int8_t offset_y = app->screen_shake.shake_duration > 0 ? app->screen_shake.shake_offset_y : 0;
-        
-        draw_space_background(canvas, app);
-        
-        // Score display
-        canvas_set_color(canvas, ColorWhite);
-        canvas_draw_box(canvas, 0 + offset_x, 0 + offset_y, 128, 32);
-        canvas_set_color(canvas, ColorBlack);
-        canvas_draw_frame(canvas, 0 + offset_x, 0 + offset_y, 128, 32);
-        
-        char score_str[32];
-        snprintf(score_str, sizeof(score_str), "SCORE: %lu", app->score);
-        canvas_set_font(canvas, FontPrimary);
-        canvas_draw_str_aligned(canvas, 64 + offset_x, 10 + offset_y, AlignCenter, AlignCenter, score_str);
-        
-        uint32_t display_high_score = app->high_score;
-        if(app->score > app->high_score) {
-            display_high_score = app->score;
-        }
-        
-        char high_str[32];
-        snprintf(high_str, sizeof(high_str), "BEST: %lu", display_high_score);
-        canvas_set_font(canvas, FontSecondary);
-        canvas_draw_str_aligned(canvas, 64 + offset_x, 24 + offset_y, AlignCenter, AlignCenter, high_str);
-        
-        // Hill drawing
-        uint8_t hill_center_x = 64;
-        uint8_t hill_height = 8;
-        uint8_t hill_base_y = 63;
-        uint8_t hill_width = 100;
-        
-        for(int16_t x = hill_center_x - hill_width/2; x <= hill_center_x + hill_width/2; x++) {
-            float a = (float)hill_height / ((hill_width/2) * (hill_width/2));
-            uint8_t y = hill_base_y - hill_height + (a * (x - hill_center_x) * (x - hill_center_x));
-            
-            if(x >= 0 && x < 128 && y < 64) {
-                canvas_draw_line(canvas, x + offset_x, y + offset_y, x + offset_x, hill_base_y + offset_y);
-            }
-        }
-        
-        // Flagpole (leaning left)
-        uint8_t pole_start_x = hill_center_x - 5;
-    uint8_t pole_start_y = hill_base_y - hill_height;
-    uint8_t pole_height = 25;
-    uint8_t pole_end_x = pole_start_x - 3;
-    uint8_t pole_end_y = pole_start_y - pole_height;
-    
-    canvas_draw_line(canvas, 
-                   pole_start_x + offset_x, 
-                   pole_start_y + offset_y, 
-                   pole_end_x + offset_x, 
-                   pole_end_y + offset_y);
-
-    // Improved flag animation with proper edges
-    uint8_t flag_width = 24;
-    uint8_t flag_height = 10;
-    
-    // Animation control - make sure app->animation_frame increments elsewhere
-    float phase = (float)(app->animation_frame % 64) / 64.0f * 2 * M_PI;
-    
-    // Initialize previous points at pole position
-    int8_t prev_top_x = pole_end_x;
-    int8_t prev_top_y = pole_end_y;
-    int8_t prev_bottom_x = pole_end_x;
-    int8_t prev_bottom_y = pole_end_y + flag_height;
-    
-    // Draw flag body
-    for(uint8_t i = 0; i <= flag_width; i++) {
-        float pos = (float)i / (float)flag_width * 2 * M_PI; // Two full waves
-        
-        // Calculate current points with animation
-        int8_t current_x = pole_end_x + i;
-        int8_t current_top_y = pole_end_y + sin(pos + phase) * 3;
-        int8_t current_bottom_y = pole_end_y + flag_height + sin(pos + phase + 0.5f) * 2;
-        
-        // Draw vertical connections at the pole
-        if(i < 3) {
-            canvas_draw_line(canvas,
-                          current_x + offset_x,
-                          current_top_y + offset_y,
-                          current_x + offset_x,
-                          current_bottom_y + offset_y);
-        }
-        
-        // Draw top wave
-        if(i > 0) {
-            canvas_draw_line(canvas,
-                          prev_top_x + offset_x,
-                          prev_top_y + offset_y,
-                          current_x + offset_x,
-                          current_top_y + offset_y);
-        }
-        
-        // Draw bottom wave
-        if(i > 0) {
-            canvas_draw_line(canvas,
-                          prev_bottom_x + offset_x,
-                          prev_bottom_y + offset_y,
-                          current_x + offset_x,
-                          current_bottom_y + offset_y);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("snapshot.bin"), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        storage_file_write(file, app->snapshot, SNAPSHOT_SIZE);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+// Puts a suspended run back before the first frame. Its clock and effect
+// deadlines start in snapshot_resume_timers() once the wheel is up.
+static bool snapshot_restore(StratagemHeroApp* app) {
+    uint8_t data[SNAPSHOT_SIZE];
+    size_t size = 0;
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("snapshot.bin"), FSAM_READ, FSOM_OPEN_EXISTING)) {
+        size = storage_file_read(file, data, sizeof(data));
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    // One resume per suspend, so a snapshot that takes the app down is not retried
+    if(size) {
+        storage_simply_remove(storage, APP_DATA_PATH("snapshot.bin"));
+    }
+    furi_record_close(RECORD_STORAGE);
+    
+    GameCore game;
+    SnapshotRun run;
+    game_init(&game, NULL, app);
+    if(!snapshot_decode(data, size, &game, &run)) return false;
+    if(run.mode >= GAME_MODE_COUNT || run.mode == GAME_MODE_VERSUS) return false;
+    if(run.mode == GAME_MODE_PRACTICE) {
+        game.pick = practice_pick;
+    }
+    
+    uint32_t now = furi_get_tick();
+    app->game = game;
+    app->mode = run.mode;
+    app->current_input_correct = run.input_correct;
+    app->ghost_start_tick = now - run.run_ms;
+    
+    app->state = GAME_STATE_PLAY;
+    if(run.landing_ms != SNAPSHOT_EFFECT_NONE) {
+        app->state = GAME_STATE_STRATAGEM_SUCCESS;
+        app->scene.success_anim.start_tick = now - run.landing_ms;
+    }
+    if(run.shake_ms != SNAPSHOT_EFFECT_NONE) {
+        app->scene.screen_shake.active = true;
+        app->scene.screen_shake.start_tick = now - run.shake_ms;
+    }
+    
+    // The first part of the recording is gone, so this run cannot become
+    // the ghost, but it still races it
+    if(app->mode == GAME_MODE_CLASSIC) {
+        app->ghost.record_full = true;
+        app->ghost_open_requested = true;
+    }
+    return true;
+}
+
+static void snapshot_resume_timers(StratagemHeroApp* app) {
+    uint32_t now = furi_get_tick();
+    app->game_tick = now;
+    game_schedule_expiry(app);
+    
+    if(app->state == GAME_STATE_STRATAGEM_SUCCESS) {
+        uint32_t elapsed = now - app->scene.success_anim.start_tick;
+        uint32_t duration = anim_duration(&anim_capsule);
+        wheel_schedule(app, WheelEntryLanding, elapsed < duration ? duration - elapsed : 0);
+    }
+    if(app->scene.screen_shake.active) {
+        uint32_t elapsed = now - app->scene.screen_shake.start_tick;
+        uint32_t duration = anim_duration(&anim_shake);
+        wheel_schedule(app, WheelEntryShake, elapsed < duration ? duration - elapsed : 0);
+    }
+}
+
+static bool board_merge_file(Storage* storage, const char* path, Leaderboard* board) {
+    File* file = storage_file_alloc(storage);
+    bool valid = false;
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        LeaderboardReader reader;
+        leaderboard_reader_init(&reader);
+        uint8_t chunk[64];
+        size_t size;
+        valid = true;
+        while(valid && (size = storage_file_read(file, chunk, sizeof(chunk))) > 0) {
+            valid = leaderboard_reader_feed(&reader, board, chunk, size);
         }
-        
-        // Draw vertical stripes
-        if(i > 2 && i % 4 == 0 && i < flag_width) {
-            canvas_draw_line(canvas,
-                          current_x + offset_x,
-                          current_top_y + offset_y,
-                          current_x + offset_x,
-                          current_bottom_y + offset_y);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return valid;
+}
+
+// Streams this device's runs, the last merged board and every file in the
+// import folder through one top-N heap, then writes the board back out. The
+// board file is a score file too, so it can be copied to the other devices.
+static void board_merge(StratagemHeroApp* app) {
+    Leaderboard board;
+    leaderboard_init(&board, app->board_merge, LEADERBOARD_TOP);
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    uint16_t files = 0;
+    files += board_merge_file(storage, APP_DATA_PATH("scores.bin"), &board);
+    board_merge_file(storage, APP_DATA_PATH("leaderboard.bin"), &board);
+    
+    storage_simply_mkdir(storage, APP_DATA_PATH("import"));
+    File* dir = storage_file_alloc(storage);
+    if(storage_dir_open(dir, APP_DATA_PATH("import"))) {
+        FileInfo info;
+        char name[64];
+        char path[128];
+        while(storage_dir_read(dir, &info, name, sizeof(name))) {
+            if(file_info_is_dir(&info)) continue;
+            snprintf(path, sizeof(path), "%s/%s", APP_DATA_PATH("import"), name);
+            files += board_merge_file(storage, path, &board);
         }
-        
-        // Close the flag end
-        if(i == flag_width) {
-            canvas_draw_line(canvas,
-                          current_x + offset_x,
-                          current_top_y + offset_y,
-                          current_x + offset_x,
-                          current_bottom_y + offset_y);
+    }
+    storage_dir_close(dir);
+    storage_file_free(dir);
+    
+    leaderboard_sort(&board);
+    
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, APP_DATA_PATH("leaderboard.bin"), FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        uint8_t data[LEADERBOARD_RECORD_SIZE];
+        leaderboard_encode_header(app->device_id, data);
+        storage_file_write(file, data, LEADERBOARD_HEADER_SIZE);
+        for(uint16_t i = 0; i < board.count; i++) {
+            leaderboard_encode_record(&board.entries[i], data);
+            storage_file_write(file, data, LEADERBOARD_RECORD_SIZE);
         }
-        
-        prev_top_x = current_x;
-        prev_top_y = current_top_y;
-        prev_bottom_x = current_x;
-        prev_bottom_y = current_bottom_y;
     }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    
+    FURI_LOG_I(TAG, "board: %u files, %lu records, %lu duplicates, %lu corrupt",
+               files, board.offered, board.duplicates, board.corrupt);
+    
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    memcpy(app->board, board.entries, board.count * sizeof(LeaderboardRecord));
+    app->board_count = board.count;
+    app->board_files = files;
+    app->board_scroll = 0;
+    app_redraw(app);
+    furi_mutex_release(app->game_mutex);
 }
+
+// The event a key is acted on at, see RUN_INPUT_ON_PRESS
+static bool app_input_acts(InputType type) {
+    if(RUN_INPUT_ON_PRESS) return type == InputTypePress;
+    return type == InputTypeShort || type == InputTypeLong;
 }
 
-static void app_input_callback(InputEvent* input_event, void* ctx) {
-    furi_assert(ctx);
-    StratagemHeroApp* app = ctx;
+static void app_input_handle(StratagemHeroApp* app, InputEvent* input_event) {
+    // Latency is counted from the press whichever event the key acts at
+    if(input_event->type == InputTypePress && input_event->key < InputKeyMAX) {
+        app->key_down_tick[input_event->key] = furi_get_tick();
+    }
     
-    if(input_event->type == InputTypeShort || input_event->type == InputTypeLong) {
+    // In a run Back waits for the release: a short press abandons the run,
+    // holding it suspends the run and leaves the app. Versus runs cannot be
+    // suspended, the other device would be left racing alone.
+    bool in_run = app->state == GAME_STATE_PLAY || app->state == GAME_STATE_STRATAGEM_SUCCESS;
+    if(in_run && input_event->key == InputKeyBack) {
+        if(input_event->type == InputTypeLong && app->mode != GAME_MODE_VERSUS) {
+            run_suspend(app);
+            app_redraw(app);
+        } else if(input_event->type == InputTypeShort || input_event->type == InputTypeLong) {
+            run_abandon(app);
+            app_redraw(app);
+        }
+        return;
+    }
+    
+    // Act on the press itself; the Short/Long/Release that follow would only
+    // add the hold time to every keystroke.
+    if(app_input_acts(input_event->type)) {
         if(app->state == GAME_STATE_MENU) {
             if(input_event->key == InputKeyOk) {
-                app->state = GAME_STATE_PLAY;
-                app->lives = INITIAL_LIVES;
-                app->score = 0;
-                app->current_input_index = 0;
-                app->current_stratagem_index = rand() % STRATAGEM_COUNT;
-                app->time_remaining = INITIAL_TIME;
-                app->current_input_correct = true;
+                if(app->mode == GAME_MODE_VERSUS) {
+                    uint32_t now = furi_get_tick();
+                    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+                    if(app->serial && versus_is_connected(&app->versus, now) &&
+                       app->versus.match == VersusMatchIdle) {
+                        versus_start(&app->versus, now ^ (uint32_t)rand(), now);
+                    }
+                    furi_mutex_release(app->versus_mutex);
+                    app_notify(app, &sequence_navigate);
+                } else {
+                    start_game(app, furi_get_tick() ^ (uint32_t)rand(), TelemetryProducerInput);
+                }
                 
-                app->success_anim.x = 64;
-                app->success_anim.y = 30;
+            } else if(input_event->key == InputKeyLeft || input_event->key == InputKeyRight) {
+                if(app->mode == GAME_MODE_VERSUS) {
+                    versus_link_close(app);
+                }
+                if(input_event->key == InputKeyRight) {
+                    app->mode = (app->mode + 1) % GAME_MODE_COUNT;
+                } else {
+                    app->mode = (app->mode + GAME_MODE_COUNT - 1) % GAME_MODE_COUNT;
+                }
+                if(app->mode == GAME_MODE_VERSUS) {
+                    versus_link_open(app);
+                }
+                app_notify(app, &sequence_navigate);
+                
+            } else if(input_event->key == InputKeyDown) {
+                app->diagnostics_view = GAME_STATE_MENU;
+                app->diagnostics_status = NULL;
+                app->state = GAME_STATE_DIAGNOSTICS;
+                app_notify(app, &sequence_navigate);
+                
+            } else if(input_event->key == InputKeyUp) {
+                // The merge reads the SD card, so it runs on the main loop
+                app->board_merge_requested = true;
+                app->state = GAME_STATE_LEADERBOARD;
+                app_notify(app, &sequence_navigate);
                 
             } else if(input_event->key == InputKeyBack) {
                 app->exit_requested = true;
@@ -1104,154 +1764,326 @@ static void app_input_callback(InputEvent* input_event, void* ctx) {
                 input_dir = DIRECTION_LEFT;
             } else if(input_event->key == InputKeyRight) {
                 input_dir = DIRECTION_RIGHT;
-            } else if(input_event->key == InputKeyBack) {
-                app->state = GAME_STATE_MENU;
-                notification_message(app->notifications, &sequence_navigate);
-                
-                notification_message(app->notifications, &sequence_welcome_midi);
-                return;
             }
             
             if(input_dir != DIRECTION_NONE) {
-                Stratagem current = STRATAGEMS[app->current_stratagem_index];
-                
-                if(app->current_input_index < current.length) {
-                    if(input_dir == current.sequence[app->current_input_index]) {
-                        app->current_input_index++;
-                        app->current_input_correct = true;
-                        notification_message(app->notifications, &sequence_correct);
-                        
-                        if(app->current_input_index >= current.length) {
-                            app->score += current.length * 100;
-                            app->time_remaining += TIME_BONUS;
-                            app->last_input_success = true;
-                            
-                            notification_message(app->notifications, &sequence_level_complete);
-                            
-                            if(app->state != GAME_STATE_STRATAGEM_SUCCESS) {
-                                app->state = GAME_STATE_STRATAGEM_SUCCESS;
-                                app->success_anim.x = 64;
-                                app->success_anim.y = 30;
-                                app->success_anim.depth = 0;
-                                app->success_anim.animation_stage = 0;
-                                app->success_anim.duration = 20;
-                            }
-                            
-                            app->current_input_index = 0;
-                            app->current_stratagem_index = rand() % STRATAGEM_COUNT;
-                        }
-                    } else {
-                        app->current_input_correct = false;
-                        notification_message(app->notifications, &sequence_wrong);
-                        
-                        if(app->time_remaining > 2000) {
-                            app->time_remaining -= 2000;
-                        } else {
-                            app->time_remaining = 100;
-                        }
-                        
-                        app->screen_shake.shake_duration = 10;
-                        
-                        app->current_input_index = 0;
-                    }
-                }
+                app->input_press_tick = app->key_down_tick[input_event->key];
+                app->key_producer = TelemetryProducerInput;
+                run_input_key(&app->run_input, input_dir,
+                              app->state == GAME_STATE_STRATAGEM_SUCCESS ? RunPhaseLanding : RunPhasePlay);
             }
         } else if(app->state == GAME_STATE_GAME_OVER) {
             if(input_event->key == InputKeyOk || input_event->key == InputKeyBack) {
-                if(app->score > app->high_score) {
-                    app->high_score = app->score;
+                if(app->game.score > app->high_score) {
+                    app->high_score = app->game.score;
+                }
+                
+                if(app->mode == GAME_MODE_VERSUS) {
+                    furi_mutex_acquire(app->versus_mutex, FuriWaitForever);
+                    versus_reset_match(&app->versus);
+                    furi_mutex_release(app->versus_mutex);
                 }
                 
                 app->state = GAME_STATE_MENU;
-                notification_message(app->notifications, &sequence_navigate);
+                app_notify(app, &sequence_navigate);
                 
-                notification_message(app->notifications, &sequence_welcome_midi);
+                app_play_welcome(app);
+            }
+        } else if(app->state == GAME_STATE_DIAGNOSTICS) {
+            if(input_event->key == InputKeyRight) {
+                app->diagnostics_view = (app->diagnostics_view + 1) % GAME_STATE_COUNT;
+            } else if(input_event->key == InputKeyLeft) {
+                app->diagnostics_view = (app->diagnostics_view + GAME_STATE_COUNT - 1) % GAME_STATE_COUNT;
+            } else if(input_event->key == InputKeyOk) {
+                // File I/O is left to the main loop
+                app->diagnostics_status = "SAVING";
+                app->diagnostics_export_requested = true;
+            } else if(PROFILE_FRAME_STREAM && input_event->key == InputKeyUp) {
+                // So is the USB mode switch
+                app->frame_stream_toggle_requested = true;
+            } else if(input_event->key == InputKeyBack) {
+                app->state = GAME_STATE_MENU;
+            }
+            app_notify(app, &sequence_navigate);
+        } else if(app->state == GAME_STATE_LEADERBOARD) {
+            if(input_event->key == InputKeyDown) {
+                if(app->board_scroll + LEADERBOARD_ROWS < app->board_count) app->board_scroll++;
+            } else if(input_event->key == InputKeyUp) {
+                if(app->board_scroll > 0) app->board_scroll--;
+            } else if(input_event->key == InputKeyOk) {
+                // Picks up files copied into the import folder since
+                app->board_merge_requested = true;
+            } else if(input_event->key == InputKeyBack) {
+                app->state = GAME_STATE_MENU;
             }
+            app_notify(app, &sequence_navigate);
         }
+        
+        app_redraw(app);
     }
 }
 
+static void app_input_callback(InputEvent* input_event, void* ctx) {
+    furi_assert(ctx);
+    StratagemHeroApp* app = ctx;
+    diagnostics_wakeup(app->diagnostics, DiagnosticsThreadGui);
+    
+    // Timers and stats are not up during the first frame or two
+    if(!app->ready) return;
+    
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    app_input_handle(app, input_event);
+    furi_mutex_release(app->game_mutex);
+}
+
 int32_t stratagem_hero_app(void* p) {
     UNUSED(p);
     
-    StratagemHeroApp* app = malloc(sizeof(StratagemHeroApp));
-    if (!app) return -1;
+    uint32_t startup_start = DWT->CYCCNT;
     
-    memset(app, 0, sizeof(StratagemHeroApp));
+    // The only heap block the app takes for itself
+    uint32_t arena_size = stratagem_hero_arena_size;
+    uint8_t* memory = malloc(arena_size);
+    if (!memory) return -1;
     
+    Arena arena;
+    arena_init(&arena, memory, arena_size);
+    StratagemHeroApp* app = arena_alloc(&arena, sizeof(StratagemHeroApp));
+    furi_check(app);
+    app->arena = arena;
+    app->startup.start = startup_start;
+    startup_mark(app, "alloc");
+    
+    // Only what the menu frame needs happens before the view port goes up
     app->exit_requested = false;
     app->state = GAME_STATE_MENU;
-    app->score = 0;
     app->high_score = 0;
-    app->animation_frame = 0;
-    app->feedback_timer = 0;
-    app->scroll_offset = 0;
+    scene_init(&app->scene, furi_get_tick());
+    app->main_thread = furi_thread_get_current_id();
+    app->device_id = leaderboard_hash(LEADERBOARD_HASH_INIT, furi_hal_version_uid(), furi_hal_version_uid_size());
+    icon_cache_init(&app->icons);
+    app->icon_index = ICON_CACHE_EMPTY;
+    frame_budget_init(&app->frame_budget, FRAME_BUDGET_US * furi_hal_cortex_instructions_per_microsecond(),
+                      QualityTierCount - 1);
+    notify_gate_init(&app->notify_gate, furi_get_tick());
+    run_input_init(&app->run_input, app_key_apply, app);
+    
+    // canvas_draw_xbm wants the leftmost pixel in the low bit
+    for(size_t i = 0; i < sizeof(custom_splash); i++) {
+        uint8_t byte = custom_splash[i];
+        uint8_t reversed = 0;
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            reversed |= ((byte >> bit) & 1) << (7 - bit);
+        }
+        app->custom_splash[i] = reversed;
+    }
+    startup_mark(app, "state");
     
-    memcpy(app->custom_splash, custom_splash, sizeof(custom_splash));
+    app->resumed = snapshot_restore(app);
+    startup_mark(app, "snapshot");
     
     app->gui = furi_record_open(RECORD_GUI);
     if (!app->gui) {
-        free(app);
+        free(memory);
         return -2;
     }
-        
+    
     app->view_port = view_port_alloc();
     if (!app->view_port) {
         furi_record_close(RECORD_GUI);
-        free(app);
+        free(memory);
         return -4;
     }
     
+    app->notifications = furi_record_open(RECORD_NOTIFICATION);
+    app->serial_rx = furi_stream_buffer_alloc(VERSUS_RX_BUFFER_SIZE, 1);
+    app->versus_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    app->game_mutex = furi_mutex_alloc(FuriMutexTypeRecursive);
+    app->display_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    
     view_port_draw_callback_set(app->view_port, app_draw_callback, app);
     view_port_input_callback_set(app->view_port, app_input_callback, app);
+    
+    // The first frame replays a list like every other one
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    app_build(app);
+    furi_mutex_release(app->game_mutex);
     gui_add_view_port(app->gui, app->view_port, GuiLayerFullscreen);
+    startup_mark(app, "view port");
     
-    app->notifications = furi_record_open(RECORD_NOTIFICATION);
+    // Let the GUI thread put the menu up before doing anything it does not need
+    furi_thread_flags_wait(STARTUP_FLAG_FIRST_FRAME, FuriFlagWaitAny, STARTUP_FIRST_FRAME_TIMEOUT_MS);
+    startup_mark(app, "frame wait");
     
-    app->timer = furi_timer_alloc(timer_callback, FuriTimerTypePeriodic, app);
-    if (!app->timer) {
+    app->wheel_timer = furi_timer_alloc(wheel_timer_callback, FuriTimerTypeOnce, app);
+    if (!app->wheel_timer) {
         gui_remove_view_port(app->gui, app->view_port);
         view_port_free(app->view_port);
         furi_record_close(RECORD_GUI);
         furi_record_close(RECORD_NOTIFICATION);
-        free(app);
+        furi_stream_buffer_free(app->serial_rx);
+        furi_mutex_free(app->versus_mutex);
+        furi_mutex_free(app->game_mutex);
+        furi_mutex_free(app->display_mutex);
+        free(memory);
         return -5;
     }
+    timer_wheel_init(&app->wheel, furi_get_tick());
+    timer_wheel_set_callback(&app->wheel, WheelEntryFrame, wheel_frame_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntryExpiry, wheel_expiry_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntryLanding, wheel_landing_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntryShake, wheel_shake_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntryWelcome, wheel_welcome_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntrySample, wheel_sample_callback, app);
+    timer_wheel_set_callback(&app->wheel, WheelEntryLink, wheel_link_callback, app);
+    startup_mark(app, "timers");
+    
+    app->telemetry = telemetry_alloc(&app->arena, APP_DATA_PATH("telemetry.bin"));
+    app->diagnostics = diagnostics_alloc(&app->arena);
+    startup_mark(app, "telemetry");
     
-    app->animation_timer = furi_timer_alloc(animation_timer_callback, FuriTimerTypePeriodic, app);
-    if (!app->animation_timer) {
-        furi_timer_free(app->timer);
-        gui_remove_view_port(app->gui, app->view_port);
-        view_port_free(app->view_port);
-        furi_record_close(RECORD_GUI);
-        furi_record_close(RECORD_NOTIFICATION);
-        free(app);
-        return -6;
-    }
+    srand(furi_get_tick() ^ (uint32_t)app);
     
-    furi_timer_start(app->timer, 100);
-    furi_timer_start(app->animation_timer, 50);
+    scene_init_background(&app->scene);
+    startup_mark(app, "background");
     
-    srand(furi_get_tick() ^ (uint32_t)app);
+    practice_load(app);
+    achievements_load(app);
+    startup_mark(app, "practice");
     
-    init_stars(app);
-    init_planets(app);
+    // Nothing is carved once the app is live
+    arena_seal(&app->arena);
+    FURI_LOG_I(TAG, "arena: %u of %u bytes", app->arena.used, app->arena.size);
     
-    notification_message(app->notifications, &sequence_welcome_midi);
+    furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+    app->ready = true;
+    app_frame_schedule(app);
+    wheel_schedule(app, WheelEntrySample, DIAGNOSTICS_SAMPLE_INTERVAL_MS);
+    if(app->resumed) {
+        snapshot_resume_timers(app);
+    }
+    furi_mutex_release(app->game_mutex);
     
-    while(!app->exit_requested) {
-        furi_delay_ms(50);
+    // A resumed run goes straight on without the menu tune
+    if(!app->resumed) {
+        app_play_welcome(app);
     }
+    startup_mark(app, "music");
+    
+    startup_report(app);
     
-    if(app->score > app->high_score) {
-        app->high_score = app->score;
+    while(!app->exit_requested) {
+        uint32_t flags = furi_thread_flags_wait(MAIN_FLAG_REDRAW | MAIN_FLAG_SERIAL | MAIN_FLAG_SAMPLE,
+                                                FuriFlagWaitAny, FuriWaitForever);
+        diagnostics_wakeup(app->diagnostics, DiagnosticsThreadMain);
+        if(flags & FuriFlagError) flags = 0;
+        
+        if(app->serial && (flags & MAIN_FLAG_SERIAL)) {
+            versus_link_poll(app);
+        }
+        
+        if(flags & MAIN_FLAG_SAMPLE) {
+            uint32_t telemetry_wakeups = telemetry_get_wakeups(app->telemetry);
+            diagnostics_add_wakeups(app->diagnostics, DiagnosticsThreadTelemetry,
+                                    telemetry_wakeups - app->telemetry_wakeups);
+            app->telemetry_wakeups = telemetry_wakeups;
+            
+            diagnostics_sample(app->diagnostics, app->state);
+            
+            uint32_t cycles_per_us = furi_hal_cortex_instructions_per_microsecond();
+            FURI_LOG_D(TAG, "scene build max %luus, replay max %luus, icon %lu hits %lu misses, decode %luus",
+                       app->scene_build_max / cycles_per_us, app->scene_replay_max / cycles_per_us,
+                       app->icons.hits, app->icons.misses, app->icon_decode_last / cycles_per_us);
+            FURI_LOG_D(TAG, "notifications %lu posted %lu dropped, backlog peak %lums",
+                       app->notify_gate.posted, app->notify_gate.dropped, app->notify_gate.backlog_peak);
+            app->scene_build_max = 0;
+            app->scene_replay_max = 0;
+            
+            // Nothing else redraws the diagnostics screen
+            furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+            if(app->state == GAME_STATE_DIAGNOSTICS) flags |= MAIN_FLAG_REDRAW;
+            furi_mutex_release(app->game_mutex);
+        }
+        
+        if(flags & MAIN_FLAG_REDRAW) {
+            furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+            app_build(app);
+            app_frame_schedule(app);
+            furi_mutex_release(app->game_mutex);
+        }
+        
+        if(app->diagnostics_export_requested) {
+            app->diagnostics_export_requested = false;
+            bool saved = diagnostics_export(app->diagnostics, APP_DATA_PATH("diagnostics.csv"),
+                                            __DATE__ " " __TIME__, game_state_names);
+            furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+            app->diagnostics_status = saved ? "SAVED" : "SD ERROR";
+            app_redraw(app);
+            furi_mutex_release(app->game_mutex);
+        }
+        
+        if(PROFILE_FRAME_STREAM && app->frame_stream_toggle_requested) {
+            app->frame_stream_toggle_requested = false;
+            // The draw callback reaches the stream under display_mutex
+            FrameStream* stream = app->frame_stream;
+            const char* status;
+            if(stream) {
+                furi_mutex_acquire(app->display_mutex, FuriWaitForever);
+                app->frame_stream = NULL;
+                furi_mutex_release(app->display_mutex);
+                frame_stream_stop(stream);
+                status = "STREAM OFF";
+            } else {
+                stream = frame_stream_start();
+                furi_mutex_acquire(app->display_mutex, FuriWaitForever);
+                app->frame_stream = stream;
+                furi_mutex_release(app->display_mutex);
+                status = stream ? "STREAM ON" : "NO MEMORY";
+            }
+            furi_mutex_acquire(app->game_mutex, FuriWaitForever);
+            app->diagnostics_status = status;
+            app_redraw(app);
+            furi_mutex_release(app->game_mutex);
+        }
+        
+        if(app->ghost_save_requested) {
+            app->ghost_save_requested = false;
+            ghost_playback_close(&app->ghost);
+            ghost_save_if_best(&app->ghost, APP_DATA_PATH("ghost.bin"), app->ghost_duration);
+        }
+        if(app->ghost_open_requested) {
+            app->ghost_open_requested = false;
+            if(app->mode == GAME_MODE_CLASSIC) {
+                ghost_playback_open(&app->ghost, APP_DATA_PATH("ghost.bin"));
+            } else {
+                ghost_playback_close(&app->ghost);
+            }
+        }
+        ghost_playback_fill(&app->ghost);
+        
+        if(app->achievements_save_requested) {
+            app->achievements_save_requested = false;
+            achievements_save(app);
+        }
+        if(app->score_save_requested) {
+            app->score_save_requested = false;
+            score_save(app);
+        }
+        if(app->board_merge_requested) {
+            app->board_merge_requested = false;
+            board_merge(app);
+        }
     }
     
-    furi_timer_stop(app->timer);
-    furi_timer_free(app->timer);
+    versus_link_close(app);
+    ghost_playback_close(&app->ghost);
     
-    furi_timer_stop(app->animation_timer);
-    furi_timer_free(app->animation_timer);
+    if(app->game.score > app->high_score) {
+        app->high_score = app->game.score;
+    }
+    
+    furi_timer_stop(app->wheel_timer);
+    furi_timer_free(app->wheel_timer);
     
     gui_remove_view_port(app->gui, app->view_port);
     view_port_free(app->view_port);
@@ -1259,7 +2091,19 @@ int32_t stratagem_hero_app(void* p) {
     
     furi_record_close(RECORD_NOTIFICATION);
     
-    free(app);
+    if(PROFILE_FRAME_STREAM) {
+        frame_stream_stop(app->frame_stream);
+    }
+    snapshot_save(app);
+    practice_save(app);
+    telemetry_free(app->telemetry);
+    diagnostics_free(app->diagnostics);
+    furi_stream_buffer_free(app->serial_rx);
+    furi_mutex_free(app->versus_mutex);
+    furi_mutex_free(app->game_mutex);
+    furi_mutex_free(app->display_mutex);
+    
+    free(memory);
     
     return 0;
 }
\ No newline at end of file
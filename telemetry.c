@@ -0,0 +1,187 @@
+#include "telemetry.h"
+
+#include <furi.h>
+#include <storage/storage.h>
+#include <string.h>
+
+#define TELEMETRY_FLAG_DATA (1 << 0)
+#define TELEMETRY_FLAG_STOP (1 << 1)
+
+#define TELEMETRY_RECORDS_PER_BLOCK (TELEMETRY_BLOCK_SIZE / sizeof(TelemetryRecord))
+#define TELEMETRY_THREAD_STACK_SIZE 2048
+
+_Static_assert(sizeof(TelemetryRecord) == 16, "TelemetryRecord must pack into 512-byte blocks");
+_Static_assert((TELEMETRY_RING_SIZE & (TELEMETRY_RING_SIZE - 1)) == 0, "Ring size must be a power of two");
+
+typedef struct {
+    TelemetryRecord records[TELEMETRY_RING_SIZE];
+    uint32_t head; // only written by the producer
+    uint32_t tail; // only written by the writer thread
+    uint32_t dropped;
+} TelemetryRing;
+
+struct Telemetry {
+    TelemetryRing rings[TelemetryProducerCount];
+    
+    TelemetryRecord block[TELEMETRY_RECORDS_PER_BLOCK];
+    uint8_t block_fill;
+    uint32_t last_flush;
+    uint32_t dropped_reported;
+    uint32_t wakeups;
+    
+    const char* path;
+    FuriThread* thread;
+};
+
+_Static_assert(sizeof(struct Telemetry) <= TELEMETRY_ARENA_SIZE, "Telemetry outgrew its arena share");
+
+void telemetry_log(
+    Telemetry* telemetry,
+    TelemetryProducer producer,
+    TelemetryRecordType type,
+    uint8_t a,
+    uint16_t b,
+    uint32_t value,
+    uint32_t extra) {
+    if(!telemetry) return;
+    
+    TelemetryRing* ring = &telemetry->rings[producer];
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    
+    if(head - tail >= TELEMETRY_RING_SIZE) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    TelemetryRecord* record = &ring->records[head & (TELEMETRY_RING_SIZE - 1)];
+    record->tick = furi_get_tick();
+    record->type = type;
+    record->a = a;
+    record->b = b;
+    record->value = value;
+    record->extra = extra;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    
+    // Wake the writer once per half ring rather than once per record
+    if(head - tail + 1 == TELEMETRY_RING_SIZE / 2) {
+        furi_thread_flags_set(furi_thread_get_id(telemetry->thread), TELEMETRY_FLAG_DATA);
+    }
+}
+
+uint32_t telemetry_get_dropped(Telemetry* telemetry) {
+    uint32_t dropped = 0;
+    for(uint8_t i = 0; i < TelemetryProducerCount; i++) {
+        dropped += __atomic_load_n(&telemetry->rings[i].dropped, __ATOMIC_RELAXED);
+    }
+    return dropped;
+}
+
+uint32_t telemetry_get_wakeups(Telemetry* telemetry) {
+    if(!telemetry) return 0;
+    return __atomic_load_n(&telemetry->wakeups, __ATOMIC_RELAXED);
+}
+
+// Writes the current block, padding a partial one with empty records so
+// every write stays a whole, aligned 512-byte block.
+static void telemetry_flush_block(Telemetry* telemetry, File* file) {
+    if(telemetry->block_fill == 0) return;
+    
+    memset(
+        &telemetry->block[telemetry->block_fill],
+        0,
+        (TELEMETRY_RECORDS_PER_BLOCK - telemetry->block_fill) * sizeof(TelemetryRecord));
+    if(file) {
+        storage_file_write(file, telemetry->block, TELEMETRY_BLOCK_SIZE);
+    }
+    telemetry->block_fill = 0;
+    telemetry->last_flush = furi_get_tick();
+}
+
+static void telemetry_append(Telemetry* telemetry, File* file, const TelemetryRecord* record) {
+    telemetry->block[telemetry->block_fill++] = *record;
+    if(telemetry->block_fill == TELEMETRY_RECORDS_PER_BLOCK) {
+        telemetry_flush_block(telemetry, file);
+    }
+}
+
+static void telemetry_drain(Telemetry* telemetry, File* file) {
+    for(uint8_t i = 0; i < TelemetryProducerCount; i++) {
+        TelemetryRing* ring = &telemetry->rings[i];
+        uint32_t tail = ring->tail;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        
+        while(tail != head) {
+            telemetry_append(telemetry, file, &ring->records[tail & (TELEMETRY_RING_SIZE - 1)]);
+            tail++;
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        }
+    }
+    
+    uint32_t dropped = telemetry_get_dropped(telemetry);
+    if(dropped != telemetry->dropped_reported) {
+        TelemetryRecord record = {
+            .tick = furi_get_tick(),
+            .type = TelemetryRecordDrops,
+            .value = dropped,
+        };
+        telemetry_append(telemetry, file, &record);
+        telemetry->dropped_reported = dropped;
+    }
+}
+
+static int32_t telemetry_writer_thread(void* context) {
+    Telemetry* telemetry = context;
+    
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    File* target = file;
+    if(!storage_file_open(file, telemetry->path, FSAM_WRITE, FSOM_OPEN_APPEND)) {
+        // Keep draining so producers never see a full ring, just discard
+        target = NULL;
+    }
+    
+    telemetry->last_flush = furi_get_tick();
+    bool running = true;
+    while(running) {
+        uint32_t flags = furi_thread_flags_wait(
+            TELEMETRY_FLAG_DATA | TELEMETRY_FLAG_STOP, FuriFlagWaitAny, TELEMETRY_FLUSH_INTERVAL_MS);
+        __atomic_store_n(&telemetry->wakeups, telemetry->wakeups + 1, __ATOMIC_RELAXED);
+        if(!(flags & FuriFlagError) && (flags & TELEMETRY_FLAG_STOP)) {
+            running = false;
+        }
+        
+        telemetry_drain(telemetry, target);
+        
+        if(!running || furi_get_tick() - telemetry->last_flush >= TELEMETRY_FLUSH_INTERVAL_MS) {
+            telemetry_flush_block(telemetry, target);
+        }
+    }
+    
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    
+    return 0;
+}
+
+Telemetry* telemetry_alloc(Arena* arena, const char* path) {
+    Telemetry* telemetry = arena_alloc(arena, sizeof(Telemetry));
+    furi_check(telemetry);
+    telemetry->path = path;
+    
+    telemetry->thread = furi_thread_alloc_ex(
+        "StratagemHeroTelemetry", TELEMETRY_THREAD_STACK_SIZE, telemetry_writer_thread, telemetry);
+    furi_thread_set_priority(telemetry->thread, FuriThreadPriorityLow);
+    furi_thread_start(telemetry->thread);
+    
+    return telemetry;
+}
+
+void telemetry_free(Telemetry* telemetry) {
+    if(!telemetry) return;
+    
+    furi_thread_flags_set(furi_thread_get_id(telemetry->thread), TELEMETRY_FLAG_STOP);
+    furi_thread_join(telemetry->thread);
+    furi_thread_free(telemetry->thread);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arena.h"
+
+// Non-blocking gameplay telemetry. Each producer thread owns one
+// single-producer/single-consumer ring, so logging never takes a lock; a
+// low-priority writer thread drains the rings into 512-byte blocks on SD.
+
+#define TELEMETRY_BLOCK_SIZE 512
+#define TELEMETRY_FLUSH_INTERVAL_MS 2000
+
+// Records each producer can have in flight, and what telemetry_alloc
+// carves from the arena. The lite profile keeps half as many.
+#ifdef STRATAGEM_HERO_LITE
+#define TELEMETRY_RING_SIZE 32
+#define TELEMETRY_ARENA_SIZE 2120
+#else
+#define TELEMETRY_RING_SIZE 64
+#define TELEMETRY_ARENA_SIZE 3656
+#endif
+
+typedef enum {
+    TelemetryProducerInput, // GUI thread: input and draw callbacks
+    TelemetryProducerTimer, // timer service callbacks
+    TelemetryProducerMain, // the app thread: versus match starts
+    TelemetryProducerCount,
+} TelemetryProducer;
+
+typedef enum {
+    TelemetryRecordNone, // padding at the end of a time-flushed block
+    TelemetryRecordKey,
+    TelemetryRecordCompletion,
+    TelemetryRecordMistake,
+    TelemetryRecordTimeout,
+    TelemetryRecordLatency,
+    TelemetryRecordGameOver,
+    TelemetryRecordDrops,
+    TelemetryRecordStart, // a: mode, value: seed; with the keys, enough to replay the run
+} TelemetryRecordType;
+
+typedef struct {
+    uint32_t tick;
+    uint8_t type;
+    uint8_t a;
+    uint16_t b;
+    uint32_t value;
+    uint32_t extra;
+} TelemetryRecord;
+
+typedef struct Telemetry Telemetry;
+
+Telemetry* telemetry_alloc(Arena* arena, const char* path);
+
+// Stops the writer; the memory goes back with the arena
+void telemetry_free(Telemetry* telemetry);
+
+void telemetry_log(
+    Telemetry* telemetry,
+    TelemetryProducer producer,
+    TelemetryRecordType type,
+    uint8_t a,
+    uint16_t b,
+    uint32_t value,
+    uint32_t extra);
+
+uint32_t telemetry_get_dropped(Telemetry* telemetry);
+
+// Number of times the writer thread has woken up so far
+uint32_t telemetry_get_wakeups(Telemetry* telemetry);
@@ -0,0 +1,155 @@
+#include "timer_wheel.h"
+
+#include <string.h>
+
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static uint32_t timer_wheel_shift(uint8_t level) {
+    return level * TIMER_WHEEL_SLOT_BITS;
+}
+
+static void timer_wheel_unlink(TimerWheel* wheel, uint8_t id) {
+    TimerWheelEntry* entry = &wheel->entries[id];
+    uint8_t* head = &wheel->heads[entry->level][entry->slot];
+    
+    if(entry->prev != TIMER_WHEEL_NONE) {
+        wheel->entries[entry->prev].next = entry->next;
+    } else {
+        *head = entry->next;
+    }
+    if(entry->next != TIMER_WHEEL_NONE) {
+        wheel->entries[entry->next].prev = entry->prev;
+    }
+    if(*head == TIMER_WHEEL_NONE) {
+        wheel->occupied[entry->level] &= ~(1ULL << entry->slot);
+    }
+    entry->pending = false;
+}
+
+// An entry goes on the lowest level whose current block also holds its
+// deadline, so its slot is always ahead of that level's cursor and it is
+// cascaded down exactly when the cursor enters its block.
+static void timer_wheel_link(TimerWheel* wheel, uint8_t id) {
+    TimerWheelEntry* entry = &wheel->entries[id];
+    
+    uint8_t level = 0;
+    while(level < TIMER_WHEEL_LEVELS - 1 &&
+          (entry->expires >> timer_wheel_shift(level + 1)) != (wheel->now >> timer_wheel_shift(level + 1))) {
+        level++;
+    }
+    
+    entry->level = level;
+    entry->slot = (entry->expires >> timer_wheel_shift(level)) & TIMER_WHEEL_SLOT_MASK;
+    entry->prev = TIMER_WHEEL_NONE;
+    entry->next = wheel->heads[level][entry->slot];
+    if(entry->next != TIMER_WHEEL_NONE) {
+        wheel->entries[entry->next].prev = id;
+    }
+    wheel->heads[level][entry->slot] = id;
+    wheel->occupied[level] |= 1ULL << entry->slot;
+    entry->pending = true;
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint32_t now) {
+    memset(wheel, 0, sizeof(TimerWheel));
+    memset(wheel->heads, TIMER_WHEEL_NONE, sizeof(wheel->heads));
+    wheel->now = now;
+}
+
+void timer_wheel_set_callback(TimerWheel* wheel, uint8_t id, TimerWheelCallback callback, void* context) {
+    wheel->entries[id].callback = callback;
+    wheel->entries[id].context = context;
+}
+
+void timer_wheel_schedule(TimerWheel* wheel, uint8_t id, uint32_t expires) {
+    if(wheel->entries[id].pending) {
+        timer_wheel_unlink(wheel, id);
+    }
+    if((int32_t)(expires - wheel->now) <= 0) {
+        expires = wheel->now + 1;
+    }
+    wheel->entries[id].expires = expires;
+    timer_wheel_link(wheel, id);
+}
+
+void timer_wheel_cancel(TimerWheel* wheel, uint8_t id) {
+    if(wheel->entries[id].pending) {
+        timer_wheel_unlink(wheel, id);
+    }
+}
+
+bool timer_wheel_pending(const TimerWheel* wheel, uint8_t id) {
+    return wheel->entries[id].pending;
+}
+
+static void timer_wheel_cascade(TimerWheel* wheel, uint8_t level, uint8_t slot) {
+    uint8_t id = wheel->heads[level][slot];
+    wheel->heads[level][slot] = TIMER_WHEEL_NONE;
+    wheel->occupied[level] &= ~(1ULL << slot);
+    
+    while(id != TIMER_WHEEL_NONE) {
+        uint8_t next = wheel->entries[id].next;
+        timer_wheel_link(wheel, id);
+        id = next;
+    }
+}
+
+void timer_wheel_advance(TimerWheel* wheel, uint32_t now) {
+    while((int32_t)(now - wheel->now) > 0) {
+        uint32_t tick = wheel->now + 1;
+        
+        // Jump straight to the next occupied level 0 slot or block boundary
+        if((tick & TIMER_WHEEL_SLOT_MASK) != 0) {
+            uint64_t ahead = wheel->occupied[0] >> (tick & TIMER_WHEEL_SLOT_MASK);
+            uint32_t target = ahead ? tick + __builtin_ctzll(ahead) :
+                                      (tick | TIMER_WHEEL_SLOT_MASK) + 1;
+            if((int32_t)(target - now) > 0) {
+                wheel->now = now;
+                break;
+            }
+            tick = target;
+        }
+        wheel->now = tick;
+        
+        // Entering a new block at some level: pull its slot down, top first
+        for(uint8_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            if((tick & ((1UL << timer_wheel_shift(level)) - 1)) == 0) {
+                timer_wheel_cascade(wheel, level, (tick >> timer_wheel_shift(level)) & TIMER_WHEEL_SLOT_MASK);
+            }
+        }
+        
+        // Pop one at a time, callbacks may cancel entries in the same slot
+        uint8_t slot = tick & TIMER_WHEEL_SLOT_MASK;
+        while(wheel->heads[0][slot] != TIMER_WHEEL_NONE) {
+            uint8_t id = wheel->heads[0][slot];
+            timer_wheel_unlink(wheel, id);
+            if(wheel->entries[id].callback) {
+                wheel->entries[id].callback(wheel->entries[id].context);
+            }
+        }
+    }
+}
+
+bool timer_wheel_next(const TimerWheel* wheel, uint32_t* expires) {
+    // Lower levels only hold earlier deadlines, so the first non-empty
+    // level has the answer
+    for(uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t occupied = wheel->occupied[level];
+        if(!occupied) continue;
+        
+        uint8_t cursor = (wheel->now >> timer_wheel_shift(level)) & TIMER_WHEEL_SLOT_MASK;
+        uint64_t ahead = occupied >> cursor;
+        uint8_t slot = ahead ? cursor + __builtin_ctzll(ahead) : __builtin_ctzll(occupied);
+        
+        uint8_t id = wheel->heads[level][slot];
+        uint32_t earliest = wheel->entries[id].expires;
+        for(id = wheel->entries[id].next; id != TIMER_WHEEL_NONE; id = wheel->entries[id].next) {
+            if((int32_t)(wheel->entries[id].expires - earliest) < 0) {
+                earliest = wheel->entries[id].expires;
+            }
+        }
+        *expires = earliest;
+        return true;
+    }
+    return false;
+}
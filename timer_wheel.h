@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hierarchical timer wheel with millisecond ticks. Four levels of 64 slots
+// cover about 4.6 hours. Entries are a fixed pool addressed by id, and
+// each one is a one-shot deadline that can be rescheduled or cancelled in
+// O(1). The owner arms a single hardware or OS timer for
+// timer_wheel_next() and calls timer_wheel_advance() when it fires.
+// Platform-free.
+
+#define TIMER_WHEEL_MAX_ENTRIES 8
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_NONE 0xFF
+
+typedef void (*TimerWheelCallback)(void* context);
+
+typedef struct {
+    TimerWheelCallback callback;
+    void* context;
+    uint32_t expires;
+    uint8_t next;
+    uint8_t prev;
+    uint8_t level;
+    uint8_t slot;
+    bool pending;
+} TimerWheelEntry;
+
+typedef struct {
+    uint32_t now; // last tick processed
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+    uint8_t heads[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    TimerWheelEntry entries[TIMER_WHEEL_MAX_ENTRIES];
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel* wheel, uint32_t now);
+void timer_wheel_set_callback(TimerWheel* wheel, uint8_t id, TimerWheelCallback callback, void* context);
+
+// Deadlines at or before the last processed tick fire on the next advance
+void timer_wheel_schedule(TimerWheel* wheel, uint8_t id, uint32_t expires);
+void timer_wheel_cancel(TimerWheel* wheel, uint8_t id);
+bool timer_wheel_pending(const TimerWheel* wheel, uint8_t id);
+
+// Fires every entry due at or before now, in deadline order. Callbacks may
+// schedule and cancel entries.
+void timer_wheel_advance(TimerWheel* wheel, uint32_t now);
+
+// Earliest tick at which the wheel has work to do, false when idle
+bool timer_wheel_next(const TimerWheel* wheel, uint32_t* expires);
@@ -0,0 +1,72 @@
+// Heap guard for the host tools, linked in with --wrap.
+//
+// The app carves its buffers from one arena and seals it before it goes
+// live; from then until the block is freed at exit nothing should reach the
+// heap. Linked into a tool that does the same, this makes that checkable on
+// the host: between arena_seal() and the free() of the block arena_init()
+// was given, any malloc, calloc, realloc or free made from the tool or the
+// app's sources it is built with aborts, naming the call and its caller.
+// The C library's own allocations, in stdio or pthread_create(), are not
+// wrapped and pass.
+//
+// build: add to the cc line of input_stress or replay_render
+//   tools/alloc_guard.c -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free,--wrap=arena_init,--wrap=arena_seal
+
+#include "arena.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* memory, size_t size);
+void __real_free(void* memory);
+void __real_arena_init(Arena* arena, void* memory, size_t size);
+void __real_arena_seal(Arena* arena);
+
+// Written by the thread that sets the arena up, read by every thread
+static void* guard_block;
+static bool guard_sealed;
+
+static void guard_check(const char* call, void* caller) {
+    if(!__atomic_load_n(&guard_sealed, __ATOMIC_ACQUIRE)) return;
+    fprintf(stderr, "alloc_guard: %s from %p after arena_seal\n", call, caller);
+    abort();
+}
+
+void* __wrap_malloc(size_t size) {
+    guard_check("malloc", __builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    guard_check("calloc", __builtin_return_address(0));
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* memory, size_t size) {
+    guard_check("realloc", __builtin_return_address(0));
+    return __real_realloc(memory, size);
+}
+
+void __wrap_free(void* memory) {
+    // The block going back ends the sealed stretch, as the app's exit does
+    if(memory && memory == guard_block) {
+        guard_block = NULL;
+        __atomic_store_n(&guard_sealed, false, __ATOMIC_RELEASE);
+    } else {
+        guard_check("free", __builtin_return_address(0));
+    }
+    __real_free(memory);
+}
+
+void __wrap_arena_init(Arena* arena, void* memory, size_t size) {
+    guard_block = memory;
+    __real_arena_init(arena, memory, size);
+}
+
+void __wrap_arena_seal(Arena* arena) {
+    __real_arena_seal(arena);
+    __atomic_store_n(&guard_sealed, true, __ATOMIC_RELEASE);
+}
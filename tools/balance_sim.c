@@ -0,0 +1,531 @@
+// Monte Carlo balancing simulator for the rules in game_core.c.
+//
+// Plays millions of games per player profile on a pool of worker threads
+// and prints score, level and game length distributions, so the difficulty
+// constants in game_core.h can be tuned against data. Every game also feeds
+// the achievement engine the events the app would, which gives unlock rates
+// per profile, and a last pass times the engine on its own. The check mode
+// plays one scripted run through a landing, with arrows typed ahead, and
+// checks that the Gatling sprint is timed from the end of the landing.
+//
+// build (from the app directory):
+//   python3 tools/catalog_compiler.py stratagems.txt stratagem_catalog.h
+//   cc -O2 -pthread -I. tools/balance_sim.c game_core.c catalog.c achievements.c run_input.c -lm -o balance_sim
+//
+// usage: balance_sim [games per profile] [threads] [seed]
+//        balance_sim --check
+
+#include "game_core.h"
+#include "achievements.h"
+#include "run_input.h"
+#include "scene.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_DEFAULT_GAMES 1000000
+#define SIM_CHUNK 1024
+#define SIM_MAX_THREADS 256
+
+// Games that are still alive after this much play time are cut off and
+// counted separately; a strong enough player never runs out of lives
+#define SIM_MAX_GAME_MS (20 * 60 * 1000)
+
+// The last score bucket also takes every score above it
+#define SIM_SCORE_BUCKET 1000
+#define SIM_SCORE_BUCKETS 1024
+#define SIM_LENGTH_BUCKET_MS 10000
+#define SIM_LENGTH_BUCKETS (SIM_MAX_GAME_MS / SIM_LENGTH_BUCKET_MS + 1)
+
+#define SIM_DISPATCH_EVENTS 50000000
+
+#define SIM_CHECK_SLOW_KEY_MS 250
+#define SIM_CHECK_FAST_KEY_MS 150
+#define SIM_CHECK_TYPED_AHEAD 2
+
+// One modelled player. Each key takes a log-normally distributed time;
+// the first key of every stratagem adds time to read the name and recall
+// the code. Every key is wrong with a fixed probability.
+typedef struct {
+    const char* name;
+    double key_ms; // median time per key
+    double key_sigma; // log-normal shape, 0 = always the median
+    double read_ms; // median extra time before the first key
+    double error_rate;
+} SimProfile;
+
+static const SimProfile profiles[] = {
+    {"novice", 450.0, 0.45, 1200.0, 0.12},
+    {"casual", 320.0, 0.40, 800.0, 0.07},
+    {"regular", 230.0, 0.35, 550.0, 0.04},
+    {"veteran", 170.0, 0.30, 350.0, 0.02},
+    {"speedrunner", 120.0, 0.25, 200.0, 0.01},
+};
+
+#define SIM_PROFILE_COUNT (sizeof(profiles) / sizeof(profiles[0]))
+
+typedef struct {
+    uint64_t games;
+    uint64_t capped;
+    uint64_t score_sum;
+    uint64_t completed_sum;
+    uint64_t level_sum;
+    uint64_t length_ms_sum;
+    uint64_t keys;
+    uint64_t mistakes;
+    uint64_t timeouts;
+    uint64_t events;
+    uint64_t unlocks[AchievementCount]; // games that unlocked each one
+    uint64_t score_hist[SIM_SCORE_BUCKETS];
+    uint64_t level_hist[MAX_LEVEL + 1];
+    uint64_t length_hist[SIM_LENGTH_BUCKETS];
+} SimStats;
+
+// Every profile's games are split into chunks of SIM_CHUNK, numbered
+// profile by profile; the pool threads claim chunk numbers until none are
+// left, so one pool runs the whole sweep with no per-profile barrier.
+typedef struct {
+    uint64_t games;
+    uint64_t seed;
+    uint64_t chunks_per_profile;
+    uint64_t next_chunk; // claimed with __atomic
+    pthread_mutex_t merge_lock;
+    SimStats totals[];
+} SimJob;
+
+// splitmix64, one stream per game
+static uint64_t sim_next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double sim_uniform(uint64_t* state) {
+    return ((sim_next(state) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static double sim_lognormal(uint64_t* state, double median, double sigma) {
+    if(sigma <= 0.0) return median;
+    // Box-Muller; the second value is thrown away to keep the stream simple
+    double u1 = sim_uniform(state);
+    double u2 = sim_uniform(state);
+    double normal = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    return median * exp(sigma * normal);
+}
+
+// The same events, in the same order, as the app's game_feedback
+static uint32_t sim_achievements(Achievements* achievements, const GameCore* game, uint32_t outcome) {
+    AchievementEvent event = {
+        .stratagem = game->last_stratagem,
+        .mistakes = game->last_mistakes,
+        .time_ms = game->last_time,
+    };
+    uint32_t unlocked = 0;
+    if(outcome & GameOutcomeWrong) {
+        event.type = AchievementEventWrong;
+        unlocked |= achievements_dispatch(achievements, &event);
+    }
+    if(outcome & GameOutcomeCompleted) {
+        event.type = AchievementEventCompletion;
+        event.value = game->score;
+        unlocked |= achievements_dispatch(achievements, &event);
+    }
+    if(outcome & GameOutcomeTimeout) {
+        event.type = AchievementEventTimeout;
+        unlocked |= achievements_dispatch(achievements, &event);
+        event.type = AchievementEventLifeLost;
+        event.value = game->lives;
+        unlocked |= achievements_dispatch(achievements, &event);
+    }
+    return unlocked;
+}
+
+// A run with the app's key path: arrows go through run_input, which holds
+// them while a capsule lands, and the end of the landing reveals the next
+// stratagem to the core
+typedef struct {
+    GameCore game;
+    Achievements achievements;
+    RunInput input;
+    RunPhase phase;
+    uint32_t landing_left; // ms until the capsule is down
+    uint32_t dt; // not yet charged to the core
+    uint32_t unlocked;
+    
+    uint64_t keys;
+    uint64_t mistakes;
+    uint64_t timeouts;
+} SimRun;
+
+static void sim_run_outcome(SimRun* run, uint32_t outcome) {
+    if(outcome & (GameOutcomeCorrect | GameOutcomeWrong)) run->keys++;
+    if(outcome & GameOutcomeWrong) run->mistakes++;
+    if(outcome & GameOutcomeTimeout) run->timeouts++;
+    run->unlocked |= sim_achievements(&run->achievements, &run->game, outcome);
+    
+    RunPhase next = run_input_next_phase(run->phase, outcome);
+    if(next == RunPhaseLanding && run->phase != RunPhaseLanding) {
+        run->landing_left = SUCCESS_ANIM_MS;
+    }
+    run->phase = next;
+}
+
+static uint32_t sim_run_apply(Direction direction, void* context) {
+    SimRun* run = context;
+    GameEvent key = {.type = GameEventKey, .direction = direction};
+    uint32_t outcome = game_step(&run->game, &key, run->dt);
+    run->dt = 0;
+    sim_run_outcome(run, outcome);
+    return outcome;
+}
+
+// Lets dt pass; a landing that ends in it reveals the next stratagem, as
+// wheel_landing_callback() does, and feeds it the arrows typed ahead
+static void sim_run_wait(SimRun* run, uint32_t dt) {
+    while(run->phase == RunPhaseLanding && dt >= run->landing_left) {
+        dt -= run->landing_left;
+        GameEvent reveal = {.type = GameEventReveal};
+        uint32_t outcome = game_step(&run->game, &reveal, run->dt + run->landing_left);
+        run->dt = 0;
+        run->phase = RunPhasePlay;
+        sim_run_outcome(run, outcome);
+        if(run->phase == RunPhasePlay) run_input_drain(&run->input, RunPhasePlay);
+    }
+    if(run->phase == RunPhaseLanding) run->landing_left -= dt;
+    run->dt += dt;
+}
+
+static void sim_run_key(SimRun* run, Direction direction, uint32_t dt) {
+    sim_run_wait(run, dt);
+    if(run->phase != RunPhaseOver) run_input_key(&run->input, direction, run->phase);
+}
+
+// Arrows waiting for the landing to end
+static uint8_t sim_run_queued(const SimRun* run) {
+    return (run->input.head + RUN_INPUT_TYPE_AHEAD - run->input.tail) % RUN_INPUT_TYPE_AHEAD;
+}
+
+static uint8_t sim_check_pick(uint32_t random, void* context) {
+    (void)random;
+    return *(const uint8_t*)context;
+}
+
+// Two Gatlings in a row. The first is typed too slowly to count. The first
+// arrows of the second go in while the capsule lands, the rest come fast
+// once it is revealed: the sprint is what was typed after the reveal.
+static int sim_check(void) {
+    SimRun run = {0};
+    achievements_init(&run.achievements, 0);
+    uint8_t gatling = run.achievements.gatling;
+    if(gatling == 0xFF) {
+        fprintf(stderr, "balance_sim: no Orbital Gatling Barrage in the catalog\n");
+        return 1;
+    }
+    const CatalogEntry* entry = catalog_get(gatling);
+    
+    game_init(&run.game, sim_check_pick, &gatling);
+    run_input_init(&run.input, sim_run_apply, &run);
+    GameEvent start = {.type = GameEventStart, .seed = 1};
+    game_step(&run.game, &start, 0);
+    AchievementEvent start_event = {.type = AchievementEventStart};
+    run.unlocked |= achievements_dispatch(&run.achievements, &start_event);
+    
+    for(uint8_t i = 0; i < entry->length; i++) {
+        sim_run_key(&run, catalog_direction(entry, i), SIM_CHECK_SLOW_KEY_MS);
+    }
+    uint32_t first_time = run.game.last_time;
+    bool landing = run.phase == RunPhaseLanding && run.unlocked == 0;
+    
+    uint32_t ahead_ms = 0;
+    for(uint8_t i = 0; i < SIM_CHECK_TYPED_AHEAD; i++) {
+        sim_run_key(&run, catalog_direction(entry, i), SIM_CHECK_FAST_KEY_MS);
+        ahead_ms += SIM_CHECK_FAST_KEY_MS;
+    }
+    bool queued = run.game.input_index == 0 && sim_run_queued(&run) == SIM_CHECK_TYPED_AHEAD;
+    
+    // The first of these waits out the rest of the landing
+    for(uint8_t i = SIM_CHECK_TYPED_AHEAD; i < entry->length; i++) {
+        uint32_t dt = SIM_CHECK_FAST_KEY_MS;
+        if(i == SIM_CHECK_TYPED_AHEAD) dt += SUCCESS_ANIM_MS - ahead_ms;
+        sim_run_key(&run, catalog_direction(entry, i), dt);
+    }
+    uint32_t sprint_ms = (entry->length - SIM_CHECK_TYPED_AHEAD) * SIM_CHECK_FAST_KEY_MS;
+    
+    bool ok = landing && queued && run.game.completed == 2 && run.game.last_time == sprint_ms &&
+              (run.unlocked & (1UL << AchievementGatlingSprint));
+    printf("check: first Gatling %ums, second %ums after its landing (%ums expected), %s\n",
+           first_time, run.game.last_time, sprint_ms,
+           (run.unlocked & (1UL << AchievementGatlingSprint)) ? "GATLING SPRINT unlocked" : "no unlock");
+    if(!ok) {
+        fprintf(stderr, "balance_sim: check failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+static void sim_play(const SimProfile* profile, uint64_t seed, SimStats* stats) {
+    uint64_t rng = seed;
+    SimRun run = {0};
+    game_init(&run.game, NULL, NULL);
+    run_input_init(&run.input, sim_run_apply, &run);
+    
+    GameEvent start = {.type = GameEventStart, .seed = (uint32_t)sim_next(&rng)};
+    game_step(&run.game, &start, 0);
+    
+    // Every game starts with nothing unlocked, so the rates are per game
+    achievements_init(&run.achievements, 0);
+    AchievementEvent start_event = {.type = AchievementEventStart};
+    run.unlocked = achievements_dispatch(&run.achievements, &start_event);
+    
+    uint64_t elapsed = 0;
+    while(run.phase != RunPhaseOver && elapsed < SIM_MAX_GAME_MS) {
+        const CatalogEntry* current = catalog_get(run.game.stratagem);
+        
+        // Arrows typed during a landing already belong to the next stratagem;
+        // with all of them in, the player waits for it to show
+        uint8_t position = run.game.input_index + sim_run_queued(&run);
+        if(position >= current->length) {
+            elapsed += run.landing_left;
+            sim_run_wait(&run, run.landing_left);
+            continue;
+        }
+        
+        double delay = sim_lognormal(&rng, profile->key_ms, profile->key_sigma);
+        if(position == 0) {
+            delay += sim_lognormal(&rng, profile->read_ms, profile->key_sigma);
+        }
+        uint32_t dt = (uint32_t)(delay + 0.5);
+        
+        Direction direction = catalog_direction(current, position);
+        if(sim_uniform(&rng) < profile->error_rate) {
+            direction = (Direction)((direction + 1 + (sim_next(&rng) % 3)) & 3);
+        }
+        
+        sim_run_key(&run, direction, dt);
+        elapsed += dt;
+    }
+    
+    const GameCore* game = &run.game;
+    stats->keys += run.keys;
+    stats->mistakes += run.mistakes;
+    stats->timeouts += run.timeouts;
+    stats->events += run.achievements.dispatched;
+    for(size_t id = 0; id < AchievementCount; id++) {
+        if(run.unlocked & (1UL << id)) stats->unlocks[id]++;
+    }
+    
+    stats->games++;
+    if(!game->over) stats->capped++;
+    stats->score_sum += game->score;
+    stats->completed_sum += game->completed;
+    stats->level_sum += game->level;
+    stats->length_ms_sum += elapsed;
+    
+    uint64_t bucket = game->score / SIM_SCORE_BUCKET;
+    stats->score_hist[bucket < SIM_SCORE_BUCKETS ? bucket : SIM_SCORE_BUCKETS - 1]++;
+    stats->level_hist[game->level]++;
+    uint64_t length = elapsed / SIM_LENGTH_BUCKET_MS;
+    stats->length_hist[length < SIM_LENGTH_BUCKETS ? length : SIM_LENGTH_BUCKETS - 1]++;
+}
+
+static void sim_merge(SimStats* into, const SimStats* from) {
+    into->games += from->games;
+    into->capped += from->capped;
+    into->score_sum += from->score_sum;
+    into->completed_sum += from->completed_sum;
+    into->level_sum += from->level_sum;
+    into->length_ms_sum += from->length_ms_sum;
+    into->keys += from->keys;
+    into->mistakes += from->mistakes;
+    into->timeouts += from->timeouts;
+    into->events += from->events;
+    for(size_t i = 0; i < AchievementCount; i++) into->unlocks[i] += from->unlocks[i];
+    for(size_t i = 0; i < SIM_SCORE_BUCKETS; i++) into->score_hist[i] += from->score_hist[i];
+    for(size_t i = 0; i <= MAX_LEVEL; i++) into->level_hist[i] += from->level_hist[i];
+    for(size_t i = 0; i < SIM_LENGTH_BUCKETS; i++) into->length_hist[i] += from->length_hist[i];
+}
+
+static void* sim_worker(void* context) {
+    SimJob* job = context;
+    SimStats* local = calloc(SIM_PROFILE_COUNT, sizeof(SimStats));
+    if(!local) {
+        // Its games would be missing from the totals
+        fprintf(stderr, "balance_sim: out of memory for worker stats\n");
+        exit(1);
+    }
+    
+    uint64_t chunk_count = job->chunks_per_profile * SIM_PROFILE_COUNT;
+    for(;;) {
+        uint64_t chunk = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+        if(chunk >= chunk_count) break;
+        
+        size_t profile = chunk / job->chunks_per_profile;
+        uint64_t first = (chunk % job->chunks_per_profile) * SIM_CHUNK;
+        uint64_t last = first + SIM_CHUNK < job->games ? first + SIM_CHUNK : job->games;
+        for(uint64_t game = first; game < last; game++) {
+            // Seeded by game number, so results do not depend on scheduling
+            uint64_t seed = (job->seed + profile) ^ (game * 0xD1342543DE82EF95ULL);
+            sim_play(&profiles[profile], seed, &local[profile]);
+        }
+    }
+    
+    pthread_mutex_lock(&job->merge_lock);
+    for(size_t profile = 0; profile < SIM_PROFILE_COUNT; profile++) {
+        sim_merge(&job->totals[profile], &local[profile]);
+    }
+    pthread_mutex_unlock(&job->merge_lock);
+    free(local);
+    return NULL;
+}
+
+// Smallest bucket whose cumulative count reaches the given fraction
+static size_t sim_percentile(const uint64_t* hist, size_t buckets, uint64_t total, double fraction) {
+    uint64_t target = (uint64_t)(fraction * total);
+    uint64_t seen = 0;
+    for(size_t i = 0; i < buckets; i++) {
+        seen += hist[i];
+        if(seen > target) return i;
+    }
+    return buckets - 1;
+}
+
+static void sim_report_score(const SimStats* stats, const char* label, double fraction) {
+    size_t bucket = sim_percentile(stats->score_hist, SIM_SCORE_BUCKETS, stats->games, fraction);
+    printf(" %s %s%zu", label, bucket == SIM_SCORE_BUCKETS - 1 ? ">=" : "", bucket);
+}
+
+static void sim_report(const SimProfile* profile, const SimStats* stats) {
+    double games = (double)stats->games;
+    
+    printf("%s: key %.0fms (sigma %.2f), read %.0fms, errors %.1f%%\n",
+           profile->name, profile->key_ms, profile->key_sigma, profile->read_ms,
+           profile->error_rate * 100.0);
+    printf("  games %llu, still alive at %d min: %.2f%%\n",
+           (unsigned long long)stats->games, SIM_MAX_GAME_MS / 60000,
+           100.0 * stats->capped / games);
+    printf("  mean score %.0f, stratagems %.1f, level %.2f, length %.1fs\n",
+           stats->score_sum / games, stats->completed_sum / games,
+           stats->level_sum / games, stats->length_ms_sum / games / 1000.0);
+    printf("  per game: %.1f mistakes, %.2f timeouts, %.1f%% of keys wrong\n",
+           stats->mistakes / games, stats->timeouts / games,
+           stats->keys ? 100.0 * stats->mistakes / stats->keys : 0.0);
+    
+    printf("  score ");
+    sim_report_score(stats, "p10", 0.10);
+    sim_report_score(stats, " p50", 0.50);
+    sim_report_score(stats, " p90", 0.90);
+    sim_report_score(stats, " p99", 0.99);
+    printf(" (x%d)", SIM_SCORE_BUCKET);
+    uint64_t over = stats->score_hist[SIM_SCORE_BUCKETS - 1];
+    if(over) {
+        printf(", %.2f%% at %d or more", 100.0 * over / games, (SIM_SCORE_BUCKETS - 1) * SIM_SCORE_BUCKET);
+    }
+    printf("\n");
+    printf("  length p50 %zus  p90 %zus\n",
+           sim_percentile(stats->length_hist, SIM_LENGTH_BUCKETS, stats->games, 0.50) * SIM_LENGTH_BUCKET_MS / 1000,
+           sim_percentile(stats->length_hist, SIM_LENGTH_BUCKETS, stats->games, 0.90) * SIM_LENGTH_BUCKET_MS / 1000);
+    
+    printf("  level reached:");
+    for(size_t level = 0; level <= MAX_LEVEL; level++) {
+        if(stats->level_hist[level]) {
+            printf(" %zu:%.1f%%", level, 100.0 * stats->level_hist[level] / games);
+        }
+    }
+    printf("\n");
+    
+    printf("  achievements (%.1f events per game):", stats->events / games);
+    for(size_t id = 0; id < AchievementCount; id++) {
+        printf("%s %s %.2f%%", id ? "," : "", achievement_name(id), 100.0 * stats->unlocks[id] / games);
+    }
+    printf("\n\n");
+}
+
+// A made-up stream in roughly the in-game mix, restarting a run every 200
+// events so the subscriber lists stay full
+static void sim_dispatch_bench(uint64_t seed) {
+    static const AchievementEventType mix[16] = {
+        AchievementEventCompletion, AchievementEventCompletion, AchievementEventCompletion,
+        AchievementEventCompletion, AchievementEventCompletion, AchievementEventCompletion,
+        AchievementEventCompletion, AchievementEventCompletion, AchievementEventCompletion,
+        AchievementEventCompletion, AchievementEventWrong, AchievementEventWrong,
+        AchievementEventWrong, AchievementEventWrong, AchievementEventTimeout,
+        AchievementEventLifeLost,
+    };
+    
+    uint64_t rng = seed;
+    Achievements achievements;
+    achievements_init(&achievements, 0);
+    uint64_t unlocks = 0;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(uint32_t i = 0; i < SIM_DISPATCH_EVENTS; i++) {
+        uint64_t bits = sim_next(&rng);
+        AchievementEvent event = {
+            .type = i % 200 == 0 ? AchievementEventStart : mix[bits & 15],
+            .stratagem = (bits >> 8) % catalog_count(),
+            .mistakes = (bits >> 16) % 4 == 0,
+            .time_ms = (bits >> 20) % 4000,
+            .value = (bits >> 32) % 60000,
+        };
+        if(event.type == AchievementEventStart) {
+            achievements_init(&achievements, 0);
+        }
+        unlocks += __builtin_popcount(achievements_dispatch(&achievements, &event));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("achievement dispatch: %u events in %.3fs, %.1fM events/s, %.1fns each (%llu unlocks)\n",
+           SIM_DISPATCH_EVENTS, seconds, SIM_DISPATCH_EVENTS / seconds / 1e6,
+           seconds * 1e9 / SIM_DISPATCH_EVENTS, (unsigned long long)unlocks);
+}
+
+int main(int argc, char** argv) {
+    if(argc > 1 && strcmp(argv[1], "--check") == 0) {
+        return sim_check();
+    }
+    
+    uint64_t games = argc > 1 ? strtoull(argv[1], NULL, 10) : SIM_DEFAULT_GAMES;
+    long threads = argc > 2 ? strtol(argv[2], NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 0) : 0x5EED;
+    if(games == 0) games = SIM_DEFAULT_GAMES;
+    if(threads < 1) threads = 1;
+    if(threads > SIM_MAX_THREADS) threads = SIM_MAX_THREADS;
+    
+    printf("%llu games per profile on %ld threads, %u stratagems, seed 0x%llx\n",
+           (unsigned long long)games, threads, catalog_count(), (unsigned long long)seed);
+    printf("time %ums, bonus %u, penalty %u, lives %u\n\n",
+           INITIAL_TIME, TIME_BONUS, WRONG_PENALTY, INITIAL_LIVES);
+    
+    SimJob* job = calloc(1, sizeof(SimJob) + SIM_PROFILE_COUNT * sizeof(SimStats));
+    if(!job) return 1;
+    job->games = games;
+    job->seed = seed;
+    job->chunks_per_profile = (games + SIM_CHUNK - 1) / SIM_CHUNK;
+    pthread_mutex_init(&job->merge_lock, NULL);
+    
+    pthread_t pool[SIM_MAX_THREADS];
+    for(long t = 0; t < threads; t++) {
+        pthread_create(&pool[t], NULL, sim_worker, job);
+    }
+    for(long t = 0; t < threads; t++) {
+        pthread_join(pool[t], NULL);
+    }
+    
+    for(size_t profile = 0; profile < SIM_PROFILE_COUNT; profile++) {
+        sim_report(&profiles[profile], &job->totals[profile]);
+    }
+    sim_dispatch_bench(seed);
+    
+    pthread_mutex_destroy(&job->merge_lock);
+    free(job);
+    return 0;
+}
@@ -0,0 +1,428 @@
+#!/usr/bin/env python3
+"""Compile stratagems.txt into stratagem_catalog.h.
+
+The generated header holds only const data, so everything lands in flash:
+packed arrow sequences, one interned string pool, category masks, name
+widths in FontPrimary pixels, a perfect-hash index over the names and the
+16x16 icons, heatshrink-compressed one by one so the app can decode any
+single icon on demand.
+
+usage: catalog_compiler.py [--icons <icons.txt>] <catalog.txt> <output.h>
+"""
+
+import sys
+
+DIRECTIONS = {"U": 0, "D": 1, "L": 2, "R": 3}
+DIRECTION_NAMES = "UDLR"
+
+MAX_SEQUENCE_LENGTH = 10
+MAX_ENTRIES = 254
+MAX_CATEGORIES = 8
+
+# The name is drawn at x=2 on the PLAY screen and the lives start at x=104
+MAX_NAME_WIDTH = 100
+
+# Advance widths of FontPrimary (helvB08), indexed by ASCII code from 0x20
+FONT_PRIMARY_WIDTHS = [
+    2, 3, 4, 5, 5, 7, 6, 2, 3, 3, 3, 5, 2, 3, 2, 2,  # space to /
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 3, 5, 5, 5, 5,  # 0 to ?
+    8, 6, 6, 6, 6, 6, 5, 6, 6, 2, 5, 6, 5, 7, 6, 6,  # @ to O
+    6, 6, 6, 6, 5, 6, 6, 8, 6, 6, 5, 3, 2, 3, 5, 5,  # P to _
+    3, 5, 5, 5, 5, 5, 3, 5, 5, 2, 2, 5, 2, 7, 5, 5,  # ` to o
+    5, 5, 3, 5, 3, 5, 5, 6, 5, 5, 4, 3, 2, 3, 5,  # p to ~
+]
+
+ICON_SIZE = 16
+ICON_BYTES = ICON_SIZE * ICON_SIZE // 8
+
+# heatshrink parameters, the same the firmware uses for its own icons; must
+# match icon_decode() in icon_cache.c
+HEATSHRINK_WINDOW_BITS = 8
+HEATSHRINK_LOOKAHEAD_BITS = 4
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+
+class CatalogError(Exception):
+    pass
+
+
+def name_width(name):
+    width = 0
+    for char in name:
+        code = ord(char)
+        if code < 0x20 or code > 0x7E:
+            raise CatalogError("'%s': only printable ASCII can be drawn" % name)
+        width += FONT_PRIMARY_WIDTHS[code - 0x20]
+    return width
+
+
+def name_hash(name, seed):
+    # FNV-1a; the low bits only see the low bits of the seed, so fold the
+    # high half in before the caller masks it down to a slot
+    value = FNV_OFFSET ^ seed
+    for byte in name.encode("ascii"):
+        value ^= byte
+        value = (value * FNV_PRIME) & 0xFFFFFFFF
+    return value ^ (value >> 16)
+
+
+def catalog_id(names):
+    # Changes whenever an index would name a different stratagem, so files
+    # keyed by index can tell they were written for another catalog
+    value = FNV_OFFSET
+    for name in names:
+        value ^= name_hash(name, 0)
+        value = (value * FNV_PRIME) & 0xFFFFFFFF
+    return value
+
+
+def parse(path):
+    categories = []
+    entries = []
+    with open(path, encoding="utf-8") as catalog:
+        for number, line in enumerate(catalog, 1):
+            where = "%s:%d" % (path, number)
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            if line.startswith("[") and line.endswith("]"):
+                category = line[1:-1].strip()
+                if category in categories:
+                    raise CatalogError("%s: category '%s' is declared twice" % (where, category))
+                categories.append(category)
+                if len(categories) > MAX_CATEGORIES:
+                    raise CatalogError("%s: more than %d categories" % (where, MAX_CATEGORIES))
+                continue
+            if not categories:
+                raise CatalogError("%s: entry before the first [category]" % where)
+            name, sep, arrows = line.partition(":")
+            name = name.strip()
+            if not sep or not name:
+                raise CatalogError("%s: expected 'Name: arrows'" % where)
+            sequence = []
+            for arrow in arrows.split():
+                if arrow not in DIRECTIONS:
+                    raise CatalogError("%s: unknown arrow '%s'" % (where, arrow))
+                sequence.append(DIRECTIONS[arrow])
+            if not sequence or len(sequence) > MAX_SEQUENCE_LENGTH:
+                raise CatalogError(
+                    "%s: '%s' needs 1 to %d arrows" % (where, name, MAX_SEQUENCE_LENGTH)
+                )
+            entries.append(
+                {
+                    "where": where,
+                    "name": name,
+                    "sequence": sequence,
+                    "category": len(categories) - 1,
+                }
+            )
+    return categories, entries
+
+
+def parse_icons(path, entries):
+    names = {entry["name"] for entry in entries}
+    icons = {}
+    name = None
+    rows = []
+
+    def finish(where):
+        if name is not None and len(rows) != ICON_SIZE:
+            raise CatalogError("%s: '%s' needs %d rows, not %d" % (where, name, ICON_SIZE, len(rows)))
+
+    with open(path, encoding="utf-8") as source:
+        for number, line in enumerate(source, 1):
+            where = "%s:%d" % (path, number)
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            if line.startswith("[") and line.endswith("]"):
+                finish(where)
+                name = line[1:-1].strip()
+                if name not in names:
+                    raise CatalogError("%s: there is no stratagem called '%s'" % (where, name))
+                if name in icons:
+                    raise CatalogError("%s: '%s' already has an icon" % (where, name))
+                rows = []
+                icons[name] = rows
+                continue
+            if name is None:
+                raise CatalogError("%s: icon rows before the first [name]" % where)
+            if len(line) != ICON_SIZE or set(line) - set("X."):
+                raise CatalogError(
+                    "%s: rows are %d pixels of X and ." % (where, ICON_SIZE)
+                )
+            if len(rows) == ICON_SIZE:
+                raise CatalogError("%s: '%s' has more than %d rows" % (where, name, ICON_SIZE))
+            rows.append(line)
+        finish("%s:%d" % (path, number))
+    return icons
+
+
+def icon_xbm(rows):
+    # XBM: rows top to bottom, leftmost pixel in the lowest bit
+    data = bytearray()
+    for row in rows:
+        for start in range(0, ICON_SIZE, 8):
+            byte = 0
+            for bit, pixel in enumerate(row[start : start + 8]):
+                if pixel == "X":
+                    byte |= 1 << bit
+            data.append(byte)
+    return bytes(data)
+
+
+def heatshrink_compress(data):
+    # Greedy LZSS in heatshrink's bit stream: a 1 bit and 8 bits of literal,
+    # or a 0 bit, the distance back minus one and the length minus one
+    window = 1 << HEATSHRINK_WINDOW_BITS
+    lookahead = 1 << HEATSHRINK_LOOKAHEAD_BITS
+    literal_bits = 9
+    backref_bits = 1 + HEATSHRINK_WINDOW_BITS + HEATSHRINK_LOOKAHEAD_BITS
+
+    bits = []
+
+    def put(value, count):
+        for shift in range(count - 1, -1, -1):
+            bits.append((value >> shift) & 1)
+
+    position = 0
+    while position < len(data):
+        best_length = 0
+        best_distance = 0
+        for distance in range(1, min(position, window) + 1):
+            length = 0
+            while (
+                length < lookahead
+                and position + length < len(data)
+                and data[position + length - distance] == data[position + length]
+            ):
+                length += 1
+            if length > best_length:
+                best_length = length
+                best_distance = distance
+        if best_length * literal_bits > backref_bits:
+            put(0, 1)
+            put(best_distance - 1, HEATSHRINK_WINDOW_BITS)
+            put(best_length - 1, HEATSHRINK_LOOKAHEAD_BITS)
+            position += best_length
+        else:
+            put(1, 1)
+            put(data[position], 8)
+            position += 1
+
+    # Zero padding reads as the start of a back-reference that never ends
+    while len(bits) % 8:
+        bits.append(0)
+    return bytes(
+        sum(bit << (7 - index) for index, bit in enumerate(bits[start : start + 8]))
+        for start in range(0, len(bits), 8)
+    )
+
+
+def build_icon_pool(entries, icons):
+    # An icon that does not shrink is stored as is, which its size tells
+    pool = bytearray()
+    offsets = []
+    for entry in entries:
+        offsets.append(len(pool))
+        if entry["name"] not in icons:
+            continue
+        raw = icon_xbm(icons[entry["name"]])
+        packed = heatshrink_compress(raw)
+        pool += packed if len(packed) < ICON_BYTES else raw
+    offsets.append(len(pool))
+    if len(pool) > 0xFFFF:
+        raise CatalogError("icon pool exceeds 64 KiB")
+    return bytes(pool), offsets
+
+
+def validate(entries):
+    if not entries:
+        raise CatalogError("the catalog is empty")
+    if len(entries) > MAX_ENTRIES:
+        raise CatalogError("more than %d entries" % MAX_ENTRIES)
+
+    names = {}
+    sequences = {}
+    for entry in entries:
+        if entry["name"] in names:
+            raise CatalogError(
+                "%s: '%s' is already defined at %s"
+                % (entry["where"], entry["name"], names[entry["name"]]["where"])
+            )
+        names[entry["name"]] = entry
+
+        key = tuple(entry["sequence"])
+        if key in sequences:
+            raise CatalogError(
+                "%s: '%s' has the same sequence as '%s'"
+                % (entry["where"], entry["name"], sequences[key]["name"])
+            )
+        sequences[key] = entry
+
+        entry["width"] = name_width(entry["name"])
+        if entry["width"] > MAX_NAME_WIDTH:
+            raise CatalogError(
+                "%s: '%s' is %dpx wide, the screen fits %dpx"
+                % (entry["where"], entry["name"], entry["width"], MAX_NAME_WIDTH)
+            )
+
+    # A code that is a prefix of another one cannot be told apart while typing
+    for short in entries:
+        for long in entries:
+            if short is long or len(short["sequence"]) >= len(long["sequence"]):
+                continue
+            if long["sequence"][: len(short["sequence"])] == short["sequence"]:
+                raise CatalogError(
+                    "%s: '%s' is a prefix of '%s' (%s)"
+                    % (short["where"], short["name"], long["name"], long["where"])
+                )
+
+
+def build_string_pool(strings):
+    # Longest first, so shorter strings can reuse the tail of a longer one
+    pool = ""
+    offsets = {}
+    for string in sorted(set(strings), key=len, reverse=True):
+        terminated = string + "\0"
+        index = pool.find(terminated)
+        if index < 0:
+            index = len(pool)
+            pool += terminated
+        offsets[string] = index
+    if len(pool) > 0xFFFF:
+        raise CatalogError("string pool exceeds 64 KiB")
+    return pool, offsets
+
+
+def build_perfect_hash(names):
+    size = 16
+    while size < 2 * len(names):
+        size *= 2
+    for seed in range(1 << 20):
+        table = [0xFF] * size
+        for index, name in enumerate(names):
+            slot = name_hash(name, seed) & (size - 1)
+            if table[slot] != 0xFF:
+                break
+            table[slot] = index
+        else:
+            return seed, table
+    raise CatalogError("no perfect hash seed found")
+
+
+def pack_sequence(sequence):
+    packed = 0
+    for position, arrow in enumerate(sequence):
+        packed |= arrow << (2 * position)
+    return packed
+
+
+def c_string(string):
+    return '"%s\\0"' % string.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def generate(categories, entries, icons, source):
+    pool, offsets = build_string_pool(categories + [e["name"] for e in entries])
+    seed, table = build_perfect_hash([e["name"] for e in entries])
+    icon_pool, icon_offsets = build_icon_pool(entries, icons)
+
+    # Emit the pool in offset order, one string per line, skipping the
+    # strings that only live inside the tail of another one
+    pool_strings = []
+    position = 0
+    while position < len(pool):
+        end = pool.index("\0", position)
+        pool_strings.append(pool[position:end])
+        position = end + 1
+
+    out = []
+    out.append("// Generated by tools/catalog_compiler.py from %s. Do not edit." % source)
+    out.append("#pragma once")
+    out.append("")
+    out.append('#include "catalog.h"')
+    out.append("")
+    out.append("#define CATALOG_COUNT %d" % len(entries))
+    out.append("#define CATALOG_CATEGORY_COUNT %d" % len(categories))
+    out.append("#define CATALOG_HASH_SIZE %d" % len(table))
+    out.append("#define CATALOG_HASH_SEED 0x%08XU" % seed)
+    out.append("#define CATALOG_ID 0x%08XU" % catalog_id([e["name"] for e in entries]))
+    out.append("")
+    out.append("static const char catalog_string_pool[%d] =" % len(pool))
+    for string in pool_strings:
+        out.append("    %s" % c_string(string))
+    out.append("    ;")
+    out.append("")
+    out.append("static const uint16_t catalog_category_names[CATALOG_CATEGORY_COUNT] = {")
+    for category in categories:
+        out.append("    %d, // %s" % (offsets[category], category))
+    out.append("};")
+    out.append("")
+    out.append("static const CatalogEntry catalog_entries[CATALOG_COUNT] = {")
+    for entry in entries:
+        arrows = " ".join(DIRECTION_NAMES[a] for a in entry["sequence"])
+        out.append(
+            "    {0x%05X, %d, %d, %d, 0x%02X}, // %s: %s"
+            % (
+                pack_sequence(entry["sequence"]),
+                offsets[entry["name"]],
+                len(entry["sequence"]),
+                entry["width"],
+                1 << entry["category"],
+                entry["name"],
+                arrows,
+            )
+        )
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t catalog_hash_index[CATALOG_HASH_SIZE] = {")
+    for row in range(0, len(table), 16):
+        out.append("    " + ", ".join("0x%02X" % v for v in table[row : row + 16]) + ",")
+    out.append("};")
+    out.append("")
+    # One spare byte keeps the array valid when no entry has an icon
+    out.append("static const uint8_t catalog_icon_pool[%d] = {" % (len(icon_pool) + 1))
+    for index, entry in enumerate(entries):
+        data = icon_pool[icon_offsets[index] : icon_offsets[index + 1]]
+        if not data:
+            continue
+        out.append("    // %s, %d bytes" % (entry["name"], len(data)))
+        for row in range(0, len(data), 16):
+            out.append("    " + ", ".join("0x%02X" % v for v in data[row : row + 16]) + ",")
+    out.append("    0x00,")
+    out.append("};")
+    out.append("")
+    out.append("static const uint16_t catalog_icon_offsets[CATALOG_COUNT + 1] = {")
+    for row in range(0, len(icon_offsets), 8):
+        out.append("    " + ", ".join("%d" % v for v in icon_offsets[row : row + 8]) + ",")
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def main(argv):
+    icons_path = None
+    if len(argv) == 5 and argv[1] == "--icons":
+        icons_path = argv[2]
+        argv = argv[:1] + argv[3:]
+    if len(argv) != 3:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 2
+    source, target = argv[1], argv[2]
+    try:
+        categories, entries = parse(source)
+        validate(entries)
+        icons = parse_icons(icons_path, entries) if icons_path else {}
+        header = generate(categories, entries, icons, source.replace("\\", "/").split("/")[-1])
+    except CatalogError as error:
+        print("catalog_compiler: error: %s" % error, file=sys.stderr)
+        return 1
+    with open(target, "w", newline="\n") as output:
+        output.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,177 @@
+// Host benchmark of the dithered transitions in dither.c.
+//
+// Blends pairs of random 128x64 frames the way the draw callback does and
+// times each blend against copying the same frame, the floor for anything
+// that touches every pixel. The device has no SIMD, so next to the host's
+// memcpy the baseline is a plain loop of 32-bit copies, and the build turns
+// off auto-vectorisation to keep the blends scalar as well. Before timing, every fade level and
+// wipe position is checked pixel by pixel against the Bayer matrix, so the
+// numbers are for blends that are known to be right.
+//
+// build (from the app directory):
+//   cc -O2 -fno-tree-vectorize -I. tools/dither_bench.c dither.c -o dither_bench
+//
+// usage: dither_bench [frames]
+
+#include "dither.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_SIZE (128 * 64 / 8)
+#define BENCH_DEFAULT_FRAMES 2000000UL
+
+static const uint8_t bayer[8][8] = {
+    {0, 32, 8, 40, 2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44, 4, 36, 14, 46, 6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    {3, 35, 11, 43, 1, 33, 9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+static uint32_t frames_a[FRAME_SIZE / 4];
+static uint32_t frames_b[FRAME_SIZE / 4];
+static uint32_t frames_out[FRAME_SIZE / 4];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int pixel(const uint32_t* frame, int x, int y) {
+    return (((const uint8_t*)frame)[(y / 8) * 128 + x] >> (y % 8)) & 1;
+}
+
+// Whether pixel x, y of a blend at this level comes from the new frame
+static int expect_fade(int level, int x, int y) {
+    return bayer[y % 8][x % 8] < level;
+}
+
+static int expect_wipe(int edge, bool reverse, int x, int y) {
+    int distance = edge - (reverse ? 127 - x : x);
+    int level = distance * DITHER_LEVELS / DITHER_WIPE_BAND;
+    if(level < 0) level = 0;
+    if(level > DITHER_LEVELS) level = DITHER_LEVELS;
+    return expect_fade(level, x, y);
+}
+
+static int check(void) {
+    // Complementary frames, so every pixel tells which side it came from
+    memset(frames_a, 0xFF, FRAME_SIZE);
+    memset(frames_b, 0x00, FRAME_SIZE);
+    
+    for(int level = 0; level <= DITHER_LEVELS; level++) {
+        memcpy(frames_out, frames_a, FRAME_SIZE);
+        dither_fade((uint8_t*)frames_out, (const uint8_t*)frames_b, level, FRAME_SIZE);
+        for(int y = 0; y < 64; y++) {
+            for(int x = 0; x < 128; x++) {
+                if(pixel(frames_out, x, y) != expect_fade(level, x, y)) {
+                    fprintf(stderr, "fade level %d: pixel %d,%d is wrong\n", level, x, y);
+                    return 1;
+                }
+            }
+        }
+    }
+    
+    for(int reverse = 0; reverse < 2; reverse++) {
+        for(int edge = 0; edge <= 128 + DITHER_WIPE_BAND; edge++) {
+            memcpy(frames_out, frames_a, FRAME_SIZE);
+            dither_wipe((uint8_t*)frames_out, (const uint8_t*)frames_b, edge, reverse, FRAME_SIZE);
+            for(int y = 0; y < 64; y++) {
+                for(int x = 0; x < 128; x++) {
+                    if(pixel(frames_out, x, y) != expect_wipe(edge, reverse, x, y)) {
+                        fprintf(stderr, "wipe edge %d%s: pixel %d,%d is wrong\n", edge,
+                                reverse ? " reversed" : "", x, y);
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// What memcpy comes down to on the Cortex-M4
+static void __attribute__((noinline)) copy_words(uint32_t* out, const uint32_t* in, size_t words) {
+    for(size_t i = 0; i < words; i++) {
+        out[i] = in[i];
+        __asm__ volatile("");
+    }
+}
+
+typedef enum {
+    BenchMemcpy,
+    BenchCopy,
+    BenchFade,
+    BenchWipe,
+    BenchCount,
+} Bench;
+
+static const char* const bench_names[BenchCount] = {"memcpy", "copy32", "fade", "wipe"};
+
+static double bench(Bench kind, unsigned long frames) {
+    uint32_t sink = 0;
+    uint64_t start = now_ns();
+    for(unsigned long i = 0; i < frames; i++) {
+        uint8_t* out = (uint8_t*)frames_out;
+        const uint8_t* from = (const uint8_t*)frames_b;
+        switch(kind) {
+            case BenchMemcpy:
+                memcpy(out, from, FRAME_SIZE);
+                break;
+            case BenchCopy:
+                copy_words(frames_out, frames_b, FRAME_SIZE / 4);
+                break;
+            case BenchFade:
+                dither_fade(out, from, i % (DITHER_LEVELS + 1), FRAME_SIZE);
+                break;
+            case BenchWipe:
+                dither_wipe(out, from, i % (128 + DITHER_WIPE_BAND + 1), i & 1, FRAME_SIZE);
+                break;
+            default:
+                break;
+        }
+        // Keep the compiler from hoisting the blend out of the loop
+        sink += frames_out[i % (FRAME_SIZE / 4)];
+        __asm__ volatile("" : : "r"(sink) : "memory");
+    }
+    return (double)(now_ns() - start) / frames;
+}
+
+int main(int argc, char** argv) {
+    unsigned long frames = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_FRAMES;
+    if(frames == 0) {
+        fprintf(stderr, "usage: dither_bench [frames]\n");
+        return 2;
+    }
+    
+    if(check()) return 1;
+    printf("check: %d fade levels and %d wipe positions match the Bayer matrix\n",
+           DITHER_LEVELS + 1, 2 * (128 + DITHER_WIPE_BAND + 1));
+    
+    srand(1);
+    for(size_t i = 0; i < FRAME_SIZE / 4; i++) {
+        frames_a[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        frames_b[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+    memcpy(frames_out, frames_a, FRAME_SIZE);
+    
+    double copy = 0;
+    for(Bench kind = 0; kind < BenchCount; kind++) {
+        double ns = bench(kind, frames);
+        if(kind == BenchCopy) copy = ns;
+        if(kind == BenchMemcpy) {
+            printf("%-7s %8.1f ns/frame\n", bench_names[kind], ns);
+            continue;
+        }
+        printf("%-7s %8.1f ns/frame  %5.2fx copy32\n", bench_names[kind], ns, copy ? ns / copy : 0);
+    }
+    return 0;
+}
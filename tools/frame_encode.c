@@ -0,0 +1,148 @@
+// Host build of the frame stream encoder in frame_codec.c.
+//
+// Writes the packets the app would send for a generated animation to
+// stdout, choosing keyframes the way frame_stream.c does, so the stream can
+// be piped into tools/frame_stream.py or written to a pty. The animation
+// mixes small moving shapes, full-screen inversions and now and then a
+// frame of pure noise, the worst case for PackBits. Packets can be cut
+// short or have a bit flipped on the way out, as a flaky USB link would.
+//
+// --frames writes the frames themselves, 1024 bytes each, for
+// frame_stream.py --check to compare the decoded ones against.
+//
+// build (from the app directory):
+//   cc -O2 -I. tools/frame_encode.c frame_codec.c -o frame_encode
+//
+// usage: frame_encode [-n frames] [--frames out.bin] [--cut packet]... [--flip packet]...
+
+#include "frame_codec.h"
+#include "frame_stream.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENCODE_DEFAULT_FRAMES 300
+#define ENCODE_MAX_FAULTS 64
+
+static uint32_t rng_state = 1;
+
+static uint32_t xorshift(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void set_pixel(uint8_t* frame, int x, int y) {
+    if(x < 0 || y < 0 || x >= FRAME_CODEC_WIDTH || y >= FRAME_CODEC_HEIGHT) return;
+    frame[(y / 8) * FRAME_CODEC_WIDTH + x] |= 1 << (y % 8);
+}
+
+static void draw_frame(uint8_t* frame, uint32_t n) {
+    memset(frame, 0, FRAME_CODEC_FRAME_SIZE);
+    
+    if(n % 97 == 96) {
+        for(size_t i = 0; i < FRAME_CODEC_FRAME_SIZE; i++) frame[i] = (uint8_t)xorshift();
+        return;
+    }
+    
+    // A box sliding across and a line sweeping down, over a fixed border
+    for(int x = 0; x < FRAME_CODEC_WIDTH; x++) {
+        set_pixel(frame, x, 0);
+        set_pixel(frame, x, FRAME_CODEC_HEIGHT - 1);
+    }
+    int bx = (int)(n * 3 % (FRAME_CODEC_WIDTH + 16)) - 16;
+    for(int y = 20; y < 36; y++) {
+        for(int x = bx; x < bx + 16; x++) set_pixel(frame, x, y);
+    }
+    int ly = (int)(n % FRAME_CODEC_HEIGHT);
+    for(int x = 8; x < 120; x += 2) set_pixel(frame, x, ly);
+    
+    // Stars that twinkle from frame to frame
+    for(int i = 0; i < 12; i++) {
+        uint32_t bits = xorshift();
+        set_pixel(frame, bits % FRAME_CODEC_WIDTH, (bits >> 8) % FRAME_CODEC_HEIGHT);
+    }
+    
+    if(n / 50 % 2) {
+        for(size_t i = 0; i < FRAME_CODEC_FRAME_SIZE; i++) frame[i] = ~frame[i];
+    }
+}
+
+static bool listed(const uint32_t* list, uint32_t count, uint32_t value) {
+    for(uint32_t i = 0; i < count; i++) {
+        if(list[i] == value) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = ENCODE_DEFAULT_FRAMES;
+    const char* frames_path = NULL;
+    uint32_t cut[ENCODE_MAX_FAULTS], cut_count = 0;
+    uint32_t flip[ENCODE_MAX_FAULTS], flip_count = 0;
+    
+    for(int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if(strcmp(argv[i], "-n") == 0 && has_value) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--frames") == 0 && has_value) {
+            frames_path = argv[++i];
+        } else if(strcmp(argv[i], "--cut") == 0 && has_value && cut_count < ENCODE_MAX_FAULTS) {
+            cut[cut_count++] = strtoul(argv[++i], NULL, 10);
+        } else if(strcmp(argv[i], "--flip") == 0 && has_value && flip_count < ENCODE_MAX_FAULTS) {
+            flip[flip_count++] = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: frame_encode [-n frames] [--frames out.bin] [--cut packet]... [--flip packet]...\n");
+            return 2;
+        }
+    }
+    
+    FILE* reference = NULL;
+    if(frames_path) {
+        reference = fopen(frames_path, "wb");
+        if(!reference) {
+            fprintf(stderr, "frame_encode: cannot write %s\n", frames_path);
+            return 1;
+        }
+    }
+    
+    static uint8_t current[FRAME_CODEC_FRAME_SIZE];
+    static uint8_t previous[FRAME_CODEC_FRAME_SIZE];
+    static uint8_t packet[FRAME_CODEC_MAX_PACKET];
+    uint8_t since_keyframe = 0;
+    size_t total = 0;
+    size_t largest = 0;
+    
+    for(uint32_t n = 0; n < frames; n++) {
+        draw_frame(current, n);
+        if(reference) {
+            // On disk before its packet, for a checker reading along
+            fwrite(current, 1, FRAME_CODEC_FRAME_SIZE, reference);
+            fflush(reference);
+        }
+        
+        // As the encoder thread does; it only learns of failed transfers,
+        // not of packets mangled after they left
+        bool keyframe = n == 0 || since_keyframe >= FRAME_STREAM_KEYFRAME_INTERVAL;
+        size_t size = frame_codec_encode(current, keyframe ? NULL : previous, (uint8_t)n, packet);
+        since_keyframe = keyframe ? 1 : since_keyframe + 1;
+        memcpy(previous, current, FRAME_CODEC_FRAME_SIZE);
+        total += size;
+        if(size > largest) largest = size;
+        
+        if(listed(flip, flip_count, n)) packet[xorshift() % size] ^= 1 << (xorshift() % 8);
+        fwrite(packet, 1, listed(cut, cut_count, n) ? size / 2 : size, stdout);
+    }
+    
+    if(reference && fclose(reference) != 0) {
+        fprintf(stderr, "frame_encode: cannot write %s\n", frames_path);
+        return 1;
+    }
+    fprintf(stderr, "frame_encode: %u frames, %zu bytes, %zu per frame, largest %zu\n",
+            frames, total, frames ? total / frames : 0, largest);
+    return 0;
+}
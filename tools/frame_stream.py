@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""Decode the frame stream the app sends over its second USB CDC port.
+
+Reads the serial device (or a pipe with '-'), rebuilds every frame from
+the keyframe/XOR-delta PackBits packets described in frame_codec.h and
+either plays them in the terminal or writes them out as PBM images.
+With --check, every decoded frame is compared against the frames
+tools/frame_encode.c wrote.
+
+usage: frame_stream.py <device|-> [--pbm DIR] [--fps N] [--check FRAMES]
+"""
+
+import argparse
+import os
+import sys
+import time
+
+WIDTH = 128
+HEIGHT = 64
+FRAME_SIZE = WIDTH * HEIGHT // 8
+
+SYNC = b"FS"
+HEADER_SIZE = 6
+FLAG_KEYFRAME = 1 << 0
+MAX_PAYLOAD = FRAME_SIZE + FRAME_SIZE // 128
+
+
+class StreamError(Exception):
+    pass
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def unpack(payload):
+    out = bytearray()
+    position = 0
+    while position < len(payload):
+        control = payload[position]
+        position += 1
+        if control < 128:
+            out += payload[position : position + control + 1]
+            position += control + 1
+        else:
+            if position >= len(payload):
+                raise StreamError("run without a value")
+            out += bytes([payload[position]]) * (control - 125)
+            position += 1
+    if len(out) != FRAME_SIZE:
+        raise StreamError("payload unpacks to %d bytes" % len(out))
+    return out
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frame = None
+        self.sequence = None
+        self.frames = 0
+        self.keyframes = 0
+        self.corrupt = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        """Yields every frame completed by data."""
+        self.buffer += data
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[: max(0, len(self.buffer) - 1)]
+                return
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER_SIZE:
+                return
+
+            flags, sequence = self.buffer[2], self.buffer[3]
+            length = self.buffer[4] | (self.buffer[5] << 8)
+            if length > MAX_PAYLOAD:
+                self.corrupt += 1
+                del self.buffer[:2]
+                continue
+            if len(self.buffer) < HEADER_SIZE + length + 1:
+                return
+
+            packet = bytes(self.buffer[: HEADER_SIZE + length + 1])
+            if crc8(packet[2:-1]) != packet[-1]:
+                self.corrupt += 1
+                del self.buffer[:2]
+                continue
+            del self.buffer[: len(packet)]
+
+            try:
+                data = unpack(packet[HEADER_SIZE:-1])
+            except StreamError:
+                self.corrupt += 1
+                continue
+
+            if flags & FLAG_KEYFRAME:
+                self.frame = data
+                self.keyframes += 1
+            elif self.frame is not None and sequence == (self.sequence + 1) & 0xFF:
+                self.frame = bytearray(a ^ b for a, b in zip(self.frame, data))
+            else:
+                # A lost packet leaves nothing to apply the delta to
+                self.frame = None
+                self.skipped += 1
+                continue
+
+            self.sequence = sequence
+            self.frames += 1
+            yield bytes(self.frame)
+
+
+def pixel(frame, x, y):
+    return (frame[(y // 8) * WIDTH + x] >> (y % 8)) & 1
+
+
+def to_pbm(frame):
+    rows = bytearray()
+    for y in range(HEIGHT):
+        for x in range(0, WIDTH, 8):
+            byte = 0
+            for bit in range(8):
+                byte |= pixel(frame, x + bit, y) << (7 - bit)
+            rows.append(byte)
+    return b"P4\n%d %d\n" % (WIDTH, HEIGHT) + bytes(rows)
+
+
+def to_text(frame):
+    # Two pixel rows per character cell
+    glyphs = " ▀▄█"
+    lines = []
+    for y in range(0, HEIGHT, 2):
+        lines.append(
+            "".join(glyphs[pixel(frame, x, y) | (pixel(frame, x, y + 1) << 1)] for x in range(WIDTH))
+        )
+    return "\n".join(lines)
+
+
+class Checker:
+    """Matches decoded frames against the encoder's frames by sequence."""
+
+    def __init__(self, path):
+        self.path = path
+        self.frames = []
+        self.load()
+        self.index = -1
+        self.matched = 0
+        self.mismatched = 0
+
+    def load(self):
+        # The encoder may still be writing them while it streams
+        with open(self.path, "rb") as source:
+            data = source.read()
+        whole = len(data) - len(data) % FRAME_SIZE
+        self.frames = [data[i : i + FRAME_SIZE] for i in range(0, whole, FRAME_SIZE)]
+
+    def check(self, frame, sequence):
+        # Frames lost on the way only ever move the index forward
+        self.index += 1
+        if self.index + 256 > len(self.frames):
+            self.load()
+        while self.index < len(self.frames) and self.index & 0xFF != sequence:
+            self.index += 1
+        if self.index < len(self.frames) and self.frames[self.index] == frame:
+            self.matched += 1
+        else:
+            self.mismatched += 1
+            print("frame %d (sequence %d) does not match" % (self.index, sequence), file=sys.stderr)
+
+
+def open_source(path):
+    if path == "-":
+        return sys.stdin.buffer.fileno()
+    descriptor = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(descriptor):
+        import termios
+        import tty
+
+        tty.setraw(descriptor)
+        termios.tcflush(descriptor, termios.TCIFLUSH)
+    return descriptor
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("source", help="serial device, or - for stdin")
+    parser.add_argument("--pbm", metavar="DIR", help="write every frame to DIR as frame_NNNNNN.pbm")
+    parser.add_argument("--fps", type=float, default=30.0, help="terminal refresh rate (default 30)")
+    parser.add_argument("--check", metavar="FRAMES", help="compare against frames written by frame_encode")
+    args = parser.parse_args(argv[1:])
+
+    if args.pbm:
+        os.makedirs(args.pbm, exist_ok=True)
+
+    decoder = Decoder()
+    checker = Checker(args.check) if args.check else None
+    descriptor = open_source(args.source)
+    started = time.monotonic()
+    interval = 1.0 / args.fps
+    shown = 0.0
+    latest = None
+    try:
+        while True:
+            data = os.read(descriptor, 4096)
+            if not data:
+                break
+            for frame in decoder.feed(data):
+                if checker:
+                    checker.check(frame, decoder.sequence)
+                    continue
+                if args.pbm:
+                    name = os.path.join(args.pbm, "frame_%06d.pbm" % (decoder.frames - 1))
+                    with open(name, "wb") as output:
+                        output.write(to_pbm(frame))
+                latest = frame
+
+            # The terminal only ever shows the newest frame, at most fps times a second
+            now = time.monotonic()
+            if not args.pbm and latest is not None and now - shown >= interval:
+                sys.stdout.write("\x1b[H\x1b[2J" + to_text(latest) + "\n")
+                sys.stdout.flush()
+                shown = now
+                latest = None
+    except KeyboardInterrupt:
+        pass
+
+    print(
+        "frames %d, keyframes %d, corrupt %d, skipped %d"
+        % (decoder.frames, decoder.keyframes, decoder.corrupt, decoder.skipped),
+        file=sys.stderr,
+    )
+    if checker:
+        elapsed = time.monotonic() - started
+        print(
+            "check: %d of %d frames decoded and matched, %d mismatched, %.0f frames/s"
+            % (checker.matched, len(checker.frames), checker.mismatched, decoder.frames / elapsed),
+            file=sys.stderr,
+        )
+        return 1 if checker.mismatched or not checker.matched else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
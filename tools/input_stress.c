@@ -0,0 +1,538 @@
+// Input-burst stress harness for the event path of stratagem_hero.c.
+//
+// One thread fires input events at the app's run logic while a second one
+// plays the timer service, stepping the core at its deadlines and ending
+// landing animations, both under one mutex like game_mutex. The handler
+// mirrors app_input_handle() over the platform-free pieces it is built
+// from: game_core for the rules, run_input for the type-ahead ring and the
+// way keys reach the core, notify_gate for feedback and arrow_row for where
+// the PLAY screen puts the arrows. Every event checks the indices and
+// screen coordinates the frame would use.
+//
+// Patterns, each run for the same time:
+//   macro   a macro pad typing the right arrows, tap after tap
+//   mash    random arrows
+//   bounce  taps whose contacts bounce, every edge repeated 2-4 times
+//   random  any key with any event type, Back and Ok included, so runs are
+//           abandoned mid-animation and restarted
+//   player  the right arrows at a person's pace, each key held 60-160 ms
+//
+// Reports events handled per second, the worst time one took, mutex wait
+// included, how long notification_message() would have blocked the input
+// thread without the gate and how far behind the service gets with it. For
+// the player, also the mean and worst time from an arrow's press to the
+// event it is acted on.
+// Built with -DSTRATAGEM_HERO_INPUT_ON_SHORT, keys wait for the Short or
+// Long as the app's do in that build.
+//
+// build (from the app directory):
+//   python3 tools/catalog_compiler.py --icons stratagem_icons.txt stratagems.txt stratagem_catalog.h
+//   cc -O2 -pthread -I. tools/input_stress.c game_core.c catalog.c run_input.c notify_gate.c arrow_row.c arena.c -o input_stress
+// With clang, -fsanitize=address,undefined,implicit-conversion in place of
+// -O2 also catches silent uint8_t truncations. With tools/alloc_guard.c
+// linked in, any heap call once the patterns start aborts.
+//
+// usage: input_stress [seconds per pattern] [taps per second, 0 = flat out] [seed]
+//
+// A tap is the Press, Short and Release the input service reports for one
+// key; the random pattern fires single events instead.
+
+#include "game_core.h"
+#include "run_input.h"
+#include "notify_gate.h"
+#include "arrow_row.h"
+#include "scene.h"
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRESS_DEFAULT_SECONDS 2
+#define STRESS_DEFAULT_RATE 500
+
+// Longest sequence the layout is checked for, past the compiler's limit
+#define STRESS_MAX_LENGTH 16
+
+// Messages the firmware's notification service queues, besides the one it
+// plays, before notification_message() blocks
+#define SERVICE_QUEUE_LENGTH 8
+#define SERVICE_RING 16
+
+// What each sequence in stratagem_hero.c keeps the service busy for, in ms
+#define NOTIFY_CORRECT_MS 100
+#define NOTIFY_WRONG_MS 150
+#define NOTIFY_COMPLETE_MS 200
+#define NOTIFY_GAME_OVER_MS 800
+#define NOTIFY_NAVIGATE_MS 10
+
+// The welcome tune goes out a phrase at a time and starting a run stops it;
+// the longest phrase is what can still be playing when one starts
+#define NOTIFY_WELCOME_PHRASE_MS 750
+
+// The arrows in Direction order
+typedef enum {
+    KeyUp,
+    KeyDown,
+    KeyLeft,
+    KeyRight,
+    KeyOk,
+    KeyBack,
+    KeyCount,
+} Key;
+
+typedef enum {
+    TypePress,
+    TypeRelease,
+    TypeShort,
+    TypeLong,
+    TypeRepeat,
+    TypeCount,
+} Type;
+
+// A run is on screen from its start to the game over screen; run_input
+// tracks which part of it
+typedef enum {
+    StateMenu,
+    StateRun,
+    StateDiagnostics,
+} State;
+
+typedef enum {
+    PatternMacro,
+    PatternMash,
+    PatternBounce,
+    PatternRandom,
+    PatternPlayer,
+    PatternCount,
+} Pattern;
+
+static const char* const pattern_names[PatternCount] = {"macro", "mash", "bounce", "random", "player"};
+
+// The notification service as it would run with every sequence posted
+typedef struct {
+    uint32_t ends[SERVICE_RING]; // of the sequences in flight
+    uint32_t head;
+    uint32_t tail;
+    uint32_t clock; // when the poster got past its last, maybe blocked, post
+    
+    uint32_t blocked; // posts that found the queue full
+    uint32_t stall_peak; // ms the poster ended up behind real time
+} Service;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    struct timespec epoch;
+    
+    State state;
+    RunPhase phase;
+    GameCore game;
+    uint32_t game_tick;
+    uint32_t landing_at;
+    RunInput run_input;
+    
+    NotifyGate gate;
+    Service service;
+    
+    uint32_t events;
+    uint32_t runs;
+    uint32_t game_overs;
+    uint64_t handle_ns;
+    uint64_t worst_ns;
+    
+    uint64_t key_down_ns[KeyCount];
+    uint32_t arrows; // acted on in a run
+    uint64_t press_ns; // from the press to the event the arrow was acted on
+    uint64_t press_worst_ns;
+    
+    volatile int stop;
+} Stress;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Milliseconds since the harness started, the furi_get_tick() of this host
+static uint32_t stress_tick(Stress* stress) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((ts.tv_sec - stress->epoch.tv_sec) * 1000 + (ts.tv_nsec - stress->epoch.tv_nsec) / 1000000);
+}
+
+static uint32_t xorshift(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void fail(const char* what, uint32_t a, uint32_t b) {
+    fprintf(stderr, "input_stress: %s (%u, %u)\n", what, a, b);
+    abort();
+}
+
+// A poster that finds the queue full waits for the sequence playing to end,
+// and everything it would have done next waits with it
+static void service_post(Service* service, uint32_t now, uint32_t duration) {
+    uint32_t at = (int32_t)(service->clock - now) > 0 ? service->clock : now;
+    while(service->tail != service->head && (int32_t)(service->ends[service->tail % SERVICE_RING] - at) <= 0) {
+        service->tail++;
+    }
+    if(service->head - service->tail > SERVICE_QUEUE_LENGTH) {
+        service->blocked++;
+        at = service->ends[service->tail % SERVICE_RING];
+        service->tail++;
+    }
+    
+    uint32_t start = service->head != service->tail ? service->ends[(service->head - 1) % SERVICE_RING] : at;
+    service->ends[service->head % SERVICE_RING] = start + duration;
+    service->head++;
+    
+    service->clock = at;
+    if(at - now > service->stall_peak) service->stall_peak = at - now;
+}
+
+static void stress_notify(Stress* stress, uint32_t duration, bool essential) {
+    uint32_t now = stress_tick(stress);
+    service_post(&stress->service, now, duration);
+    notify_gate_admit(&stress->gate, now, duration, essential);
+}
+
+// What the frame built from this state would draw, checked against the
+// screen and the arrays it indexes
+static void stress_check(Stress* stress) {
+    GameCore* game = &stress->game;
+    if(stress->state != StateRun || stress->phase == RunPhaseOver) return;
+    
+    if(game->stratagem >= catalog_count()) fail("stratagem out of range", game->stratagem, catalog_count());
+    const CatalogEntry* current = catalog_get(game->stratagem);
+    if(game->input_index > current->length) fail("input index past the sequence", game->input_index, current->length);
+    if(game->lives > INITIAL_LIVES) fail("lives", game->lives, INITIAL_LIVES);
+    
+    uint32_t elapsed = stress_tick(stress) - stress->game_tick;
+    uint32_t left = elapsed < game->time_remaining ? game->time_remaining - elapsed : 0;
+    // Banked time past the limit shows a full bar; the width is worked out
+    // in 32 bits first
+    if(PROGRESS_WIDTH * (uint64_t)left > UINT32_MAX) {
+        fail("progress bar width overflows", left, game->time_limit);
+    }
+    
+    for(uint8_t i = 0; i < current->length; i++) {
+        int16_t x = arrow_row_x(current->length, game->input_index, i);
+        if(i == game->input_index && !arrow_row_visible(x)) fail("cursor off screen", i, current->length);
+    }
+}
+
+static uint32_t stress_dispatch(Stress* stress, const GameEvent* event) {
+    uint32_t now = stress_tick(stress);
+    uint32_t outcome = game_step(&stress->game, event, now - stress->game_tick);
+    stress->game_tick = now;
+    return outcome;
+}
+
+// The sequences game_feedback() posts for an outcome, and where it takes
+// the run
+static void stress_outcome(Stress* stress, uint32_t outcome) {
+    if(outcome & GameOutcomeWrong) {
+        stress_notify(stress, NOTIFY_WRONG_MS, false);
+    } else if(outcome & GameOutcomeCorrect) {
+        stress_notify(stress, NOTIFY_CORRECT_MS, false);
+    }
+    if(outcome & GameOutcomeCompleted) {
+        stress_notify(stress, NOTIFY_COMPLETE_MS, false);
+    }
+    if(outcome & GameOutcomeTimeout) {
+        stress_notify(stress, NOTIFY_WRONG_MS, false);
+    }
+    if(outcome & GameOutcomeGameOver) {
+        stress->game_overs++;
+        stress_notify(stress, NOTIFY_GAME_OVER_MS, true);
+    }
+    
+    RunPhase next = run_input_next_phase(stress->phase, outcome);
+    if(next == RunPhaseLanding && stress->phase != RunPhaseLanding) {
+        stress->landing_at = stress_tick(stress) + SUCCESS_ANIM_MS;
+    }
+    stress->phase = next;
+}
+
+static uint32_t stress_apply(Direction direction, void* context) {
+    Stress* stress = context;
+    GameEvent event = {.type = GameEventKey, .direction = direction};
+    uint32_t outcome = stress_dispatch(stress, &event);
+    stress_outcome(stress, outcome);
+    return outcome;
+}
+
+static void stress_to_menu(Stress* stress) {
+    stress->state = StateMenu;
+    stress_notify(stress, NOTIFY_NAVIGATE_MS, false);
+    stress_notify(stress, NOTIFY_WELCOME_PHRASE_MS, false);
+}
+
+// app_input_acts()
+static bool stress_acts(Type type) {
+    if(RUN_INPUT_ON_PRESS) return type == TypePress;
+    return type == TypeShort || type == TypeLong;
+}
+
+// app_input_handle() over the states a run goes through
+static void stress_handle(Stress* stress, Key key, Type type, uint32_t* seed) {
+    if(type == TypePress) stress->key_down_ns[key] = now_ns();
+    if(type == TypeRelease) stress->key_down_ns[key] = 0;
+    
+    bool in_run = stress->state == StateRun && stress->phase != RunPhaseOver;
+    if(in_run && key == KeyBack) {
+        if(type == TypeShort || type == TypeLong) stress_to_menu(stress);
+        return;
+    }
+    if(!stress_acts(type)) return;
+    
+    switch(stress->state) {
+        case StateMenu:
+            if(key == KeyOk) {
+                game_init(&stress->game, NULL, NULL);
+                GameEvent event = {.type = GameEventStart, .seed = xorshift(seed)};
+                game_step(&stress->game, &event, 0);
+                stress->game_tick = stress_tick(stress);
+                run_input_reset(&stress->run_input);
+                notify_gate_reset(&stress->gate, stress_tick(stress));
+                stress->state = StateRun;
+                stress->phase = RunPhasePlay;
+                stress->runs++;
+            } else if(key == KeyDown) {
+                stress->state = StateDiagnostics;
+                stress_notify(stress, NOTIFY_NAVIGATE_MS, false);
+            } else if(key != KeyBack) {
+                stress_notify(stress, NOTIFY_NAVIGATE_MS, false);
+            }
+            break;
+        case StateRun:
+            if(in_run && key <= KeyRight) {
+                if(stress->key_down_ns[key]) {
+                    uint64_t press = now_ns() - stress->key_down_ns[key];
+                    stress->key_down_ns[key] = 0;
+                    stress->arrows++;
+                    stress->press_ns += press;
+                    if(press > stress->press_worst_ns) stress->press_worst_ns = press;
+                }
+                run_input_key(&stress->run_input, (Direction)key, stress->phase);
+            } else if(!in_run && (key == KeyOk || key == KeyBack)) {
+                stress_to_menu(stress);
+            }
+            break;
+        case StateDiagnostics:
+            if(key == KeyBack) stress->state = StateMenu;
+            stress_notify(stress, NOTIFY_NAVIGATE_MS, false);
+            break;
+    }
+}
+
+static void stress_event(Stress* stress, Key key, Type type, uint32_t* seed) {
+    uint64_t start = now_ns();
+    pthread_mutex_lock(&stress->mutex);
+    stress_handle(stress, key, type, seed);
+    stress_check(stress);
+    stress->events++;
+    pthread_mutex_unlock(&stress->mutex);
+    
+    uint64_t spent = now_ns() - start;
+    stress->handle_ns += spent;
+    if(spent > stress->worst_ns) stress->worst_ns = spent;
+}
+
+// The timer service: the core's deadline and the end of the landing
+static void* stress_timer_thread(void* context) {
+    Stress* stress = context;
+    struct timespec period = {0, 1000000};
+    
+    while(!stress->stop) {
+        pthread_mutex_lock(&stress->mutex);
+        uint32_t now = stress_tick(stress);
+        bool in_run = stress->state == StateRun && stress->phase != RunPhaseOver;
+        if(in_run && !stress->game.over && now - stress->game_tick >= stress->game.time_remaining) {
+            GameEvent event = {.type = GameEventTick};
+            stress_outcome(stress, stress_dispatch(stress, &event));
+        }
+        if(stress->state == StateRun && stress->phase == RunPhaseLanding &&
+           (int32_t)(now - stress->landing_at) >= 0) {
+            stress->phase = RunPhasePlay;
+            GameEvent event = {.type = GameEventReveal};
+            stress_outcome(stress, stress_dispatch(stress, &event));
+            if(stress->phase == RunPhasePlay) {
+                run_input_drain(&stress->run_input, RunPhasePlay);
+            }
+        }
+        stress_check(stress);
+        pthread_mutex_unlock(&stress->mutex);
+        
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+// A tap as the input service reports it
+static void stress_tap(Stress* stress, Key key, uint32_t* seed) {
+    stress_event(stress, key, TypePress, seed);
+    stress_event(stress, key, TypeShort, seed);
+    stress_event(stress, key, TypeRelease, seed);
+}
+
+static void stress_sleep_ms(uint32_t ms) {
+    struct timespec wait = {ms / 1000, (long)(ms % 1000) * 1000000};
+    nanosleep(&wait, NULL);
+}
+
+// A key held for a while, then the pause before the next one. Under the
+// input service's long press time, so the release brings a Short.
+static void stress_hold(Stress* stress, Key key, uint32_t* seed) {
+    stress_event(stress, key, TypePress, seed);
+    stress_sleep_ms(60 + xorshift(seed) % 100);
+    stress_event(stress, key, TypeShort, seed);
+    stress_event(stress, key, TypeRelease, seed);
+    stress_sleep_ms(40 + xorshift(seed) % 80);
+}
+
+static void stress_fire(Stress* stress, Pattern pattern, uint32_t* seed) {
+    pthread_mutex_lock(&stress->mutex);
+    State state = stress->state;
+    bool in_run = state == StateRun && stress->phase != RunPhaseOver;
+    Direction next = DIRECTION_UP;
+    if(in_run) {
+        const CatalogEntry* current = catalog_get(stress->game.stratagem);
+        if(stress->game.input_index < current->length) {
+            next = catalog_direction(current, stress->game.input_index);
+        }
+    }
+    pthread_mutex_unlock(&stress->mutex);
+    
+    // Only the random pattern finds its own way out of the menu and a lost run
+    if(pattern != PatternRandom && !in_run) {
+        stress_tap(stress, state == StateDiagnostics ? KeyBack : KeyOk, seed);
+        return;
+    }
+    
+    switch(pattern) {
+        case PatternMacro:
+            stress_tap(stress, (Key)next, seed);
+            break;
+        case PatternMash:
+            stress_tap(stress, (Key)(xorshift(seed) % 4), seed);
+            break;
+        case PatternBounce: {
+            Key key = (Key)(xorshift(seed) % 4);
+            uint32_t bounces = 2 + xorshift(seed) % 3;
+            for(uint32_t i = 0; i < bounces; i++) {
+                stress_event(stress, key, TypePress, seed);
+                stress_event(stress, key, TypeRelease, seed);
+            }
+            break;
+        }
+        case PatternRandom:
+            stress_event(stress, (Key)(xorshift(seed) % KeyCount), (Type)(xorshift(seed) % TypeCount), seed);
+            break;
+        case PatternPlayer:
+            stress_hold(stress, (Key)next, seed);
+            break;
+        default:
+            break;
+    }
+}
+
+// Every sequence length at every cursor position: the cursor stays on
+// screen and no visible arrow reaches past either edge
+static void check_layout(void) {
+    for(uint8_t length = 1; length <= STRESS_MAX_LENGTH; length++) {
+        for(uint8_t cursor = 0; cursor <= length; cursor++) {
+            for(uint8_t i = 0; i < length; i++) {
+                int16_t x = arrow_row_x(length, cursor, i);
+                if(cursor < length && i == cursor && !arrow_row_visible(x)) fail("cursor off screen", length, cursor);
+                if(arrow_row_visible(x) && (x - ARROW_ROW_MARGIN < 0 || x + ARROW_ROW_MARGIN > ARROW_ROW_WIDTH)) {
+                    fail("arrow past the edge", length, i);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : STRESS_DEFAULT_SECONDS;
+    uint32_t rate = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : STRESS_DEFAULT_RATE;
+    uint32_t seed = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 1;
+    if(seconds <= 0 || seed == 0) {
+        fprintf(stderr, "usage: input_stress [seconds per pattern] [taps per second, 0 = flat out] [seed]\n");
+        return 2;
+    }
+    
+    check_layout();
+    
+    // Every pattern's state comes from one block sealed before the first
+    // event, as the app's does
+    size_t arena_size = PatternCount * ARENA_SLOT(sizeof(Stress));
+    uint8_t* memory = malloc(arena_size);
+    if(!memory) return 1;
+    Arena arena;
+    arena_init(&arena, memory, arena_size);
+    Stress* patterns[PatternCount];
+    for(int pattern = 0; pattern < PatternCount; pattern++) {
+        patterns[pattern] = arena_alloc(&arena, sizeof(Stress));
+    }
+    arena_seal(&arena);
+    
+    printf("%-8s %10s %12s %10s %10s %6s  %-24s %-24s %s\n", "pattern", "events", "events/s", "mean us", "worst us",
+           "runs", "ungated: stall/blocked", "gated: backlog/dropped", "press ms: mean/worst");
+    for(int pattern = 0; pattern < PatternCount; pattern++) {
+        Stress* stress = patterns[pattern];
+        pthread_mutex_init(&stress->mutex, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &stress->epoch);
+        stress->state = StateMenu;
+        notify_gate_init(&stress->gate, 0);
+        run_input_init(&stress->run_input, stress_apply, stress);
+        
+        pthread_t timer;
+        pthread_create(&timer, NULL, stress_timer_thread, stress);
+        
+        uint64_t start = now_ns();
+        uint64_t length = (uint64_t)(seconds * 1e9);
+        uint64_t fired = 0;
+        uint64_t elapsed;
+        while((elapsed = now_ns() - start) < length) {
+            if(rate) {
+                uint64_t due = fired * 1000000000u / rate;
+                if(due > elapsed) {
+                    struct timespec wait = {(time_t)((due - elapsed) / 1000000000u), (long)((due - elapsed) % 1000000000u)};
+                    nanosleep(&wait, NULL);
+                    continue;
+                }
+            }
+            stress_fire(stress, (Pattern)pattern, &seed);
+            fired++;
+        }
+        
+        stress->stop = 1;
+        pthread_join(timer, NULL);
+        
+        char ungated[64];
+        char gated[64];
+        snprintf(ungated, sizeof(ungated), "%ums/%u", stress->service.stall_peak, stress->service.blocked);
+        snprintf(gated, sizeof(gated), "%ums/%u", stress->gate.backlog_peak, stress->gate.dropped);
+        char press[64] = "-";
+        if(pattern == PatternPlayer && stress->arrows) {
+            snprintf(press, sizeof(press), "%.1f/%.1f", stress->press_ns / 1e6 / stress->arrows,
+                     stress->press_worst_ns / 1e6);
+        }
+        printf("%-8s %10u %12.0f %10.2f %10.1f %6u  %-24s %-24s %s\n", pattern_names[pattern], stress->events,
+               stress->events / (elapsed / 1e9), stress->events ? stress->handle_ns / 1e3 / stress->events : 0.0,
+               stress->worst_ns / 1e3, stress->runs, ungated, gated, press);
+        
+        pthread_mutex_destroy(&stress->mutex);
+    }
+    free(memory);
+    return 0;
+}
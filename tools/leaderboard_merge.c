@@ -0,0 +1,365 @@
+// Host build of the leaderboard merge in leaderboard.c.
+//
+// Merges score files copied off any number of devices into one top-N board,
+// the same way the app's import does, and can write the result back out as
+// a score file for the devices to import. The bench mode streams generated
+// records with repeated runs through the same parser to measure throughput
+// on inputs far bigger than an SD card would ever hold. The check mode
+// merges random small files, with duplicate runs, tied scores and flipped
+// bits, fed in random chunk sizes and in two file orders, and compares
+// each board with a brute-force sort of every record.
+//
+// build (from the app directory):
+//   cc -O2 -I. tools/leaderboard_merge.c leaderboard.c -o leaderboard_merge
+//
+// usage: leaderboard_merge [-n top] [-o merged.bin] score.bin...
+//        leaderboard_merge --bench [records] [files] [top]
+//        leaderboard_merge --check [rounds] [seed]
+
+#include "leaderboard.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MERGE_DEFAULT_TOP 10
+#define MERGE_MAX_TOP 10000
+#define MERGE_CHUNK 4096
+
+#define BENCH_DEFAULT_RECORDS 100000000ULL
+#define BENCH_DEFAULT_FILES 16
+
+// Every run shows up this many times on average across the bench files,
+// as if each device had imported the others a few times over
+#define BENCH_COPIES 4
+
+#define CHECK_DEFAULT_ROUNDS 2000
+#define CHECK_MAX_FILES 8
+#define CHECK_MAX_RECORDS 300
+#define CHECK_MAX_TOP 40
+
+typedef struct {
+    uint8_t data[LEADERBOARD_HEADER_SIZE + CHECK_MAX_RECORDS * LEADERBOARD_RECORD_SIZE];
+    size_t size;
+} CheckFile;
+
+static uint64_t bench_mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    return x ^ (x >> 33);
+}
+
+static double merge_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool merge_file(Leaderboard* board, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "leaderboard_merge: cannot open %s\n", path);
+        return false;
+    }
+    
+    LeaderboardReader reader;
+    leaderboard_reader_init(&reader);
+    uint8_t chunk[MERGE_CHUNK];
+    size_t size;
+    bool valid = true;
+    while(valid && (size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        valid = leaderboard_reader_feed(&reader, board, chunk, size);
+    }
+    fclose(file);
+    
+    if(!valid) {
+        fprintf(stderr, "leaderboard_merge: %s is not a score file\n", path);
+    }
+    return valid;
+}
+
+static bool merge_write(const Leaderboard* board, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if(!file) return false;
+    
+    // A merged board is itself a score file, written as device 0
+    uint8_t data[LEADERBOARD_RECORD_SIZE];
+    leaderboard_encode_header(0, data);
+    fwrite(data, 1, LEADERBOARD_HEADER_SIZE, file);
+    for(uint16_t i = 0; i < board->count; i++) {
+        leaderboard_encode_record(&board->entries[i], data);
+        fwrite(data, 1, LEADERBOARD_RECORD_SIZE, file);
+    }
+    return fclose(file) == 0;
+}
+
+static void merge_print(const Leaderboard* board) {
+    printf("%4s %10s %6s %5s %8s %8s\n", "rank", "score", "done", "level", "device", "run");
+    for(uint16_t i = 0; i < board->count; i++) {
+        const LeaderboardRecord* record = &board->entries[i];
+        printf("%4u %10u %6u %5u %08x %08x\n", i + 1, record->score, record->completed,
+               record->level, record->device_id, record->run_hash);
+    }
+    printf("%u records, %u duplicates, %u corrupt\n", board->offered, board->duplicates,
+           board->corrupt);
+}
+
+// Generates the files one after the other in MERGE_CHUNK pieces and feeds
+// them straight to the parser, so only the generator is in the timing
+static int bench(uint64_t records, uint32_t files, uint16_t top) {
+    LeaderboardRecord* entries = calloc(top, sizeof(LeaderboardRecord));
+    if(!entries) return 1;
+    Leaderboard board;
+    leaderboard_init(&board, entries, top);
+    
+    uint64_t runs = records / BENCH_COPIES;
+    if(runs == 0) runs = 1;
+    uint64_t per_file = records / files;
+    uint8_t chunk[MERGE_CHUNK];
+    double generate = 0;
+    double start = merge_now();
+    
+    uint64_t sequence = 0;
+    for(uint32_t f = 0; f < files; f++) {
+        LeaderboardReader reader;
+        leaderboard_reader_init(&reader);
+        leaderboard_encode_header(f, chunk);
+        leaderboard_reader_feed(&reader, &board, chunk, LEADERBOARD_HEADER_SIZE);
+        
+        uint64_t count = f + 1 == files ? records - per_file * f : per_file;
+        while(count > 0) {
+            double t = merge_now();
+            size_t fill = 0;
+            while(count > 0 && fill + LEADERBOARD_RECORD_SIZE <= sizeof(chunk)) {
+                // A run always carries the same score, wherever it turns up
+                uint64_t run = bench_mix(sequence++) % runs;
+                uint64_t bits = bench_mix(run ^ 0x5EED);
+                LeaderboardRecord record = {
+                    .run_hash = (uint32_t)run,
+                    .device_id = (uint32_t)(run % files),
+                    .score = (uint32_t)(bits % 1000000),
+                    .completed = (uint16_t)(bits >> 32) % 500,
+                    .level = (uint8_t)(bits >> 48) % 50,
+                };
+                leaderboard_encode_record(&record, &chunk[fill]);
+                fill += LEADERBOARD_RECORD_SIZE;
+                count--;
+            }
+            generate += merge_now() - t;
+            leaderboard_reader_feed(&reader, &board, chunk, fill);
+        }
+    }
+    
+    double total = merge_now() - start;
+    double merge = total - generate;
+    leaderboard_sort(&board);
+    merge_print(&board);
+    printf("\n%llu records in %u files, top %u: merge %.3fs, %.1fM records/s, %.0f MiB/s\n",
+           (unsigned long long)records, files, top, merge, records / merge / 1e6,
+           records * LEADERBOARD_RECORD_SIZE / merge / (1024.0 * 1024.0));
+    printf("board memory %zu bytes\n", sizeof(board) + top * sizeof(LeaderboardRecord));
+    
+    free(entries);
+    return 0;
+}
+
+static bool check_better(const LeaderboardRecord* a, const LeaderboardRecord* b) {
+    if(a->score != b->score) return a->score > b->score;
+    return a->run_hash < b->run_hash;
+}
+
+static int check_compare(const void* a, const void* b) {
+    const LeaderboardRecord* ra = a;
+    const LeaderboardRecord* rb = b;
+    return check_better(ra, rb) ? -1 : check_better(rb, ra) ? 1 : 0;
+}
+
+static bool check_same(const LeaderboardRecord* a, const LeaderboardRecord* b) {
+    return a->run_hash == b->run_hash && a->device_id == b->device_id && a->score == b->score &&
+           a->completed == b->completed && a->level == b->level;
+}
+
+// Feeds the files in the given order, each in random chunk sizes
+static void check_merge(Leaderboard* board, const CheckFile* files, const uint32_t* order, uint32_t count,
+                        uint64_t* state) {
+    for(uint32_t f = 0; f < count; f++) {
+        const CheckFile* file = &files[order[f]];
+        LeaderboardReader reader;
+        leaderboard_reader_init(&reader);
+        size_t position = 0;
+        while(position < file->size) {
+            *state = bench_mix(*state);
+            size_t take = 1 + *state % 64;
+            if(take > file->size - position) take = file->size - position;
+            leaderboard_reader_feed(&reader, board, &file->data[position], take);
+            position += take;
+        }
+    }
+    leaderboard_sort(board);
+}
+
+// The reference keeps every record, drops repeated run hashes and sorts
+static int check(uint32_t rounds, uint64_t seed) {
+    static CheckFile files[CHECK_MAX_FILES];
+    static LeaderboardRecord all[CHECK_MAX_FILES * CHECK_MAX_RECORDS];
+    LeaderboardRecord first[CHECK_MAX_TOP];
+    LeaderboardRecord second[CHECK_MAX_TOP];
+    uint64_t state = seed;
+    uint64_t total_records = 0;
+    uint64_t total_corrupt = 0;
+    
+    for(uint32_t round = 0; round < rounds; round++) {
+        state = bench_mix(state + round);
+        uint32_t file_count = 1 + state % CHECK_MAX_FILES;
+        uint32_t runs = 1 + (state >> 8) % 200;
+        uint16_t top = (state >> 16) % (CHECK_MAX_TOP + 1);
+        // Few distinct scores, so most of the order comes from the tie-break
+        uint32_t scores = 1 + (state >> 24) % 50;
+        
+        uint32_t valid = 0;
+        uint32_t corrupt = 0;
+        uint32_t order[CHECK_MAX_FILES];
+        for(uint32_t f = 0; f < file_count; f++) {
+            order[f] = f;
+            state = bench_mix(state);
+            uint32_t records = state % (CHECK_MAX_RECORDS + 1);
+            CheckFile* file = &files[f];
+            leaderboard_encode_header(f, file->data);
+            file->size = LEADERBOARD_HEADER_SIZE;
+            for(uint32_t r = 0; r < records; r++) {
+                // A run always carries the same fields, wherever it turns up
+                state = bench_mix(state);
+                uint32_t run = state % runs;
+                uint64_t bits = bench_mix(run ^ seed);
+                LeaderboardRecord record = {
+                    .run_hash = run * 2654435761U,
+                    .device_id = (uint32_t)(run % file_count),
+                    .score = (uint32_t)(bits % scores),
+                    .completed = (uint16_t)(bits >> 32) % 500,
+                    .level = (uint8_t)(bits >> 48) % 50,
+                };
+                uint8_t* out = &file->data[file->size];
+                leaderboard_encode_record(&record, out);
+                file->size += LEADERBOARD_RECORD_SIZE;
+                
+                // A single flipped bit always fails the crc8
+                if((state >> 40) % 32 == 0) {
+                    out[(state >> 48) % LEADERBOARD_RECORD_SIZE] ^= 1 << ((state >> 56) % 8);
+                    corrupt++;
+                } else {
+                    all[valid++] = record;
+                }
+            }
+        }
+        
+        qsort(all, valid, sizeof(all[0]), check_compare);
+        uint32_t expected = 0;
+        for(uint32_t i = 0; i < valid && expected < top; i++) {
+            bool seen = false;
+            for(uint32_t j = 0; j < expected; j++) {
+                if(all[j].run_hash == all[i].run_hash) seen = true;
+            }
+            if(!seen) all[expected++] = all[i];
+        }
+        
+        Leaderboard board;
+        leaderboard_init(&board, first, top);
+        check_merge(&board, files, order, file_count, &state);
+        bool ok = board.count == expected && board.offered == valid && board.corrupt == corrupt;
+        for(uint32_t i = 0; ok && i < expected; i++) {
+            ok = check_same(&first[i], &all[i]);
+        }
+        
+        // The board may not depend on the order the files come in
+        for(uint32_t f = file_count; f > 1; f--) {
+            state = bench_mix(state);
+            uint32_t swap = state % f;
+            uint32_t t = order[f - 1];
+            order[f - 1] = order[swap];
+            order[swap] = t;
+        }
+        Leaderboard shuffled;
+        leaderboard_init(&shuffled, second, top);
+        check_merge(&shuffled, files, order, file_count, &state);
+        ok = ok && shuffled.count == board.count;
+        for(uint32_t i = 0; ok && i < board.count; i++) {
+            ok = check_same(&first[i], &second[i]);
+        }
+        
+        if(!ok) {
+            fprintf(stderr, "leaderboard_merge: check round %u failed: %u files, top %u, "
+                            "%u records on the board, %u expected\n",
+                    round, file_count, top, board.count, expected);
+            return 1;
+        }
+        total_records += valid + corrupt;
+        total_corrupt += corrupt;
+    }
+    
+    printf("check: %u merges of %llu records, %llu corrupt, match the reference in both file orders\n",
+           rounds, (unsigned long long)total_records, (unsigned long long)total_corrupt);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if(argc > 1 && strcmp(argv[1], "--check") == 0) {
+        long rounds = argc > 2 ? strtol(argv[2], NULL, 10) : CHECK_DEFAULT_ROUNDS;
+        uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 10) : 1;
+        if(rounds < 1) rounds = CHECK_DEFAULT_ROUNDS;
+        return check(rounds, seed);
+    }
+    if(argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        uint64_t records = argc > 2 ? strtoull(argv[2], NULL, 10) : BENCH_DEFAULT_RECORDS;
+        long files = argc > 3 ? strtol(argv[3], NULL, 10) : BENCH_DEFAULT_FILES;
+        long top = argc > 4 ? strtol(argv[4], NULL, 10) : MERGE_DEFAULT_TOP;
+        if(records == 0) records = BENCH_DEFAULT_RECORDS;
+        if(files < 1) files = 1;
+        if(top < 1) top = 1;
+        if(top > MERGE_MAX_TOP) top = MERGE_MAX_TOP;
+        return bench(records, files, top);
+    }
+    
+    long top = MERGE_DEFAULT_TOP;
+    const char* output = NULL;
+    int first = 1;
+    while(first + 1 < argc && argv[first][0] == '-') {
+        if(strcmp(argv[first], "-n") == 0) {
+            top = strtol(argv[first + 1], NULL, 10);
+        } else if(strcmp(argv[first], "-o") == 0) {
+            output = argv[first + 1];
+        } else {
+            break;
+        }
+        first += 2;
+    }
+    if(first >= argc || top < 1 || top > MERGE_MAX_TOP) {
+        fprintf(stderr, "usage: leaderboard_merge [-n top] [-o merged.bin] score.bin...\n"
+                        "       leaderboard_merge --bench [records] [files] [top]\n"
+                        "       leaderboard_merge --check [rounds] [seed]\n");
+        return 2;
+    }
+    
+    LeaderboardRecord* entries = calloc(top, sizeof(LeaderboardRecord));
+    if(!entries) return 1;
+    Leaderboard board;
+    leaderboard_init(&board, entries, top);
+    
+    int status = 0;
+    for(int i = first; i < argc; i++) {
+        if(!merge_file(&board, argv[i])) status = 1;
+    }
+    
+    leaderboard_sort(&board);
+    merge_print(&board);
+    if(output && !merge_write(&board, output)) {
+        fprintf(stderr, "leaderboard_merge: cannot write %s\n", output);
+        status = 1;
+    }
+    
+    free(entries);
+    return status;
+}
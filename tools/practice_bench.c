@@ -0,0 +1,182 @@
+// Host benchmark of the practice picker in practice.c.
+//
+// First checks the sampler: after every few results, with entries still
+// waiting for the next alias table rebuild, draws a large number of samples
+// and compares how often each entry came up with its share of the weights.
+// Fails on a chi-square far past what chance gives.
+//
+// Then a simulated player practises a full catalog. Every entry has a
+// hidden miss rate and arrow speed, the worst ones far worse than the best,
+// and the picker chooses what to practise as it does in the app. Reports
+// the share of draws the weakest and the strongest quarter got, the time
+// practice_record() and practice_sample() take, and what rebuilding the
+// alias table after every result, as practice_refresh() does, would cost.
+//
+// build (from the app directory):
+//   cc -O2 -I. tools/practice_bench.c practice.c -o practice_bench -lm
+//
+// usage: practice_bench [entries] [results] [seed]
+
+#include "practice.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_RESULTS 1000000
+#define CHECK_ROUNDS 40
+#define CHECK_SAMPLES_PER_ENTRY 2000
+
+typedef struct {
+    uint16_t miss_per_mille;
+    uint16_t arrow_ms;
+} Player;
+
+static uint32_t rng_state;
+
+static uint32_t xorshift(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void random_result(Practice* practice, uint8_t index) {
+    bool clean = xorshift() % 3 != 0;
+    practice_record(practice, index, clean, 5, 5 * (150 + xorshift() % 900));
+}
+
+static int check(uint8_t entries) {
+    static Practice practice;
+    static uint32_t counts[PRACTICE_MAX_ENTRIES];
+    practice_init(&practice, entries);
+    
+    uint32_t samples = (uint32_t)entries * CHECK_SAMPLES_PER_ENTRY;
+    double worst = 0;
+    uint8_t dirty_seen = 0;
+    for(uint32_t round = 0; round < CHECK_ROUNDS; round++) {
+        // A few results per round: some rounds sample right after a
+        // rebuild, most with a partly dirty table
+        uint32_t results = 1 + xorshift() % 7;
+        for(uint32_t i = 0; i < results; i++) {
+            random_result(&practice, xorshift() % entries);
+        }
+        if(practice.dirty_count > dirty_seen) dirty_seen = practice.dirty_count;
+        
+        memset(counts, 0, sizeof(counts));
+        for(uint32_t i = 0; i < samples; i++) {
+            counts[practice_sample(&practice, xorshift())]++;
+        }
+        
+        double chi = 0;
+        for(uint8_t i = 0; i < entries; i++) {
+            double expected = (double)samples * practice.weight[i] / practice.total_weight;
+            double delta = counts[i] - expected;
+            chi += delta * delta / expected;
+        }
+        
+        // Mean entries - 1, deviation sqrt(2 (entries - 1)); six deviations
+        // out is not chance
+        double dof = entries - 1;
+        double limit = dof + 6 * sqrt(2 * dof);
+        if(chi / limit > worst) worst = chi / limit;
+        if(chi > limit) {
+            fprintf(stderr, "practice_bench: round %u, %u dirty: chi-square %.1f over %.1f\n",
+                    round, practice.dirty_count, chi, limit);
+            return 1;
+        }
+    }
+    printf("check: %u rounds of %u samples match the weights, up to %u dirty entries,"
+           " worst chi-square at %.0f%% of the limit\n",
+           CHECK_ROUNDS, samples, dirty_seen, worst * 100);
+    return 0;
+}
+
+static int compare_miss(const void* a, const void* b) {
+    const Player* pa = *(const Player* const*)a;
+    const Player* pb = *(const Player* const*)b;
+    uint32_t ca = pa->miss_per_mille * 4 + pa->arrow_ms;
+    uint32_t cb = pb->miss_per_mille * 4 + pb->arrow_ms;
+    return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+int main(int argc, char** argv) {
+    unsigned long entries = argc > 1 ? strtoul(argv[1], NULL, 10) : PRACTICE_MAX_ENTRIES;
+    unsigned long results = argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_DEFAULT_RESULTS;
+    rng_state = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 1;
+    if(entries < 2 || entries > PRACTICE_MAX_ENTRIES || results == 0 || rng_state == 0) {
+        fprintf(stderr, "usage: practice_bench [entries, 2-%d] [results] [seed]\n", PRACTICE_MAX_ENTRIES);
+        return 2;
+    }
+    
+    if(check((uint8_t)entries)) return 1;
+    
+    static Player players[PRACTICE_MAX_ENTRIES];
+    static uint32_t drawn[PRACTICE_MAX_ENTRIES];
+    for(unsigned long i = 0; i < entries; i++) {
+        // Mostly known codes, a few the player keeps fumbling
+        players[i].miss_per_mille = xorshift() % 8 == 0 ? 300 + xorshift() % 400 : xorshift() % 80;
+        players[i].arrow_ms = 120 + xorshift() % 500;
+    }
+    
+    static Practice practice;
+    practice_init(&practice, (uint8_t)entries);
+    
+    double sample_time = 0;
+    double record_time = 0;
+    uint32_t rebuilds = 0;
+    for(unsigned long n = 0; n < results; n++) {
+        uint32_t random = xorshift();
+        double t0 = bench_now();
+        uint8_t index = practice_sample(&practice, random);
+        double t1 = bench_now();
+        sample_time += t1 - t0;
+        drawn[index]++;
+        
+        const Player* player = &players[index];
+        bool clean = xorshift() % 1000 >= player->miss_per_mille;
+        uint32_t time_ms = 5 * (player->arrow_ms + xorshift() % 100);
+        
+        t0 = bench_now();
+        practice_record(&practice, index, clean, 5, time_ms);
+        t1 = bench_now();
+        record_time += t1 - t0;
+        // A result always leaves its entry dirty unless the table was rebuilt
+        if(practice.dirty_count == 0) rebuilds++;
+    }
+    
+    // The full rebuild each result used to cost
+    unsigned long refreshes = results < 100000 ? results : 100000;
+    double t0 = bench_now();
+    for(unsigned long n = 0; n < refreshes; n++) {
+        practice_refresh(&practice);
+    }
+    double refresh_time = (bench_now() - t0) / refreshes;
+    
+    // Weakest first, by the same mix of misses and speed the weights use
+    static const Player* order[PRACTICE_MAX_ENTRIES];
+    for(unsigned long i = 0; i < entries; i++) order[i] = &players[i];
+    qsort(order, entries, sizeof(order[0]), compare_miss);
+    unsigned long quarter = entries / 4 ? entries / 4 : 1;
+    uint64_t weakest = 0, strongest = 0;
+    for(unsigned long i = 0; i < quarter; i++) {
+        weakest += drawn[order[i] - players];
+        strongest += drawn[order[entries - 1 - i] - players];
+    }
+    
+    printf("%lu entries, %lu results\n", entries, results);
+    printf("draws: weakest quarter %.1f%%, strongest quarter %.1f%% (uniform %.1f%%)\n",
+           100.0 * weakest / results, 100.0 * strongest / results, 100.0 * quarter / entries);
+    printf("sample %.0f ns, record %.0f ns with %u rebuilds, rebuild every result %.0f ns\n",
+           sample_time / results * 1e9, record_time / results * 1e9, rebuilds, refresh_time * 1e9);
+    return 0;
+}
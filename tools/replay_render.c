@@ -0,0 +1,793 @@
+// Offline renderer for runs recorded in telemetry.bin.
+//
+// Every run starts with a Start record holding its seed, and its Key
+// records hold the arrows in the order the core took them. Fed to
+// game_core.c at their ticks, with each stratagem timing out exactly at its
+// deadline as the app's timer wheel does it, they play the run again
+// bit for bit. The replay is sampled at the app's frame rate into one
+// snapshot.c state per frame, then a pool of worker threads renders the
+// frames from those snapshots in any order and lays them out on PBM sprite
+// sheets, so a ten-minute run takes seconds on a multicore box. No display
+// is involved.
+//
+// Each frame is built by scene_build() in scene.c, as the app builds it,
+// and the display list is rasterized here into a framebuffer in the
+// canvas's page layout, HUD layer cache and shake included. The device's
+// fonts are not available on the host, so text is a dithered bar of about
+// its width. Transitions between screens are left out. A run that ended in
+// game over ends on the GAME OVER screen.
+//
+// Practice runs draw from weights kept in practice.bin, not in telemetry,
+// so they cannot be replayed and are skipped. So are runs resumed from a
+// suspend, which have no Start record. Versus runs show the local side of
+// the race only.
+//
+// --layer plays a bench run through the PLAY screen frame by frame and
+// checks the HUD layer cache: a steady frame may only change the progress
+// bar and the arrow row over the cached layer. It also times replaying such
+// a frame from the cache against redrawing the layer.
+//
+// Frames are rendered out of an arena sealed before the first one, as the
+// app's is; with tools/alloc_guard.c linked in, a heap call from rendering
+// aborts.
+//
+// build (from the app directory):
+//   python3 tools/catalog_compiler.py --icons stratagem_icons.txt stratagems.txt stratagem_catalog.h
+//   cc -O2 -pthread -I. tools/replay_render.c scene.c display_list.c game_core.c catalog.c snapshot.c icon_cache.c arrow_row.c anim.c achievements.c arena.c -o replay_render
+//
+// usage: replay_render [-j threads] [-o dir] [-r run] [-c columns] [-n rows] telemetry.bin
+//        replay_render --bench [minutes] [threads]
+//        replay_render --layer [minutes]
+
+#include "game_core.h"
+#include "snapshot.h"
+#include "icon_cache.h"
+#include "telemetry.h"
+#include "scene.h"
+#include "achievements.h"
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// FRAME_INTERVAL_MS of the PLAY screen
+#define FRAME_MS 50
+
+#define WIDTH 128
+#define HEIGHT 64
+#define ROW_BYTES (WIDTH / 8)
+#define FRAME_BYTES (ROW_BYTES * HEIGHT)
+
+#define RENDER_CHUNK 64
+#define RENDER_MAX_THREADS 256
+#define DEFAULT_COLUMNS 16
+#define DEFAULT_ROWS 16
+
+// Ascent and average advance of FontPrimary and FontSecondary, for the
+// bars that stand in for text
+static const uint8_t font_height[] = {8, 7};
+static const uint8_t font_advance[] = {5, 4};
+
+typedef struct {
+    TelemetryRecord record;
+    uint32_t sequence; // position in the file
+} Record;
+
+typedef struct {
+    Record* records;
+    size_t count;
+    size_t capacity;
+} Records;
+
+typedef struct {
+    uint8_t (*snapshots)[SNAPSHOT_SIZE];
+    size_t frames;
+    size_t capacity;
+    bool game_over;
+    // The last frame of a game over, which snapshot.c does not take
+    GameCore final;
+    SnapshotRun final_run;
+} Replay;
+
+typedef struct {
+    const Replay* replay;
+    const Scene* scene; // stars and planets for the GAME OVER screen
+    uint16_t columns;
+    uint16_t rows;
+    uint8_t** sheets;
+    size_t next_chunk; // claimed with __atomic
+} RenderJob;
+
+// What the canvas and the app's replay keep between commands
+typedef struct {
+    uint8_t buffer[FRAME_BYTES]; // page layout: byte [page * 128 + x], LSB on top
+    uint8_t color;
+    uint8_t font;
+    
+    uint8_t layer[FRAME_BYTES];
+    uint16_t layer_generation;
+    bool layer_valid;
+} Raster;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool records_push(Records* records, const Record* record) {
+    if(records->count == records->capacity) {
+        size_t capacity = records->capacity ? records->capacity * 2 : 1024;
+        Record* grown = realloc(records->records, capacity * sizeof(Record));
+        if(!grown) return false;
+        records->records = grown;
+        records->capacity = capacity;
+    }
+    records->records[records->count++] = *record;
+    return true;
+}
+
+// Each producer thread has its own ring, so a block holds their records
+// one ring after the other; a stable sort by tick puts them back in order
+static int record_compare(const void* a, const void* b) {
+    const Record* left = a;
+    const Record* right = b;
+    if(left->record.tick != right->record.tick) return left->record.tick < right->record.tick ? -1 : 1;
+    if((left->record.type == TelemetryRecordStart) != (right->record.type == TelemetryRecordStart)) {
+        return left->record.type == TelemetryRecordStart ? -1 : 1;
+    }
+    return left->sequence < right->sequence ? -1 : 1;
+}
+
+// Blocks hold the records as the device laid them out, little-endian like
+// the host
+static bool records_load(Records* records, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {
+        fprintf(stderr, "replay_render: cannot open %s\n", path);
+        return false;
+    }
+    
+    uint8_t block[TELEMETRY_BLOCK_SIZE];
+    bool ok = true;
+    while(ok && fread(block, 1, sizeof(block), file) == sizeof(block)) {
+        for(size_t offset = 0; offset < sizeof(block); offset += sizeof(TelemetryRecord)) {
+            Record record = {.sequence = records->count};
+            memcpy(&record.record, &block[offset], sizeof(TelemetryRecord));
+            if(record.record.type != TelemetryRecordStart && record.record.type != TelemetryRecordKey) continue;
+            ok = records_push(records, &record);
+        }
+    }
+    fclose(file);
+    
+    qsort(records->records, records->count, sizeof(Record), record_compare);
+    return ok;
+}
+
+// How far into an effect started at start the frame at tick is
+static uint16_t effect_ms(bool running, uint32_t start, uint32_t tick, uint32_t duration) {
+    if(!running || tick - start >= duration) return SNAPSHOT_EFFECT_NONE;
+    return tick - start;
+}
+
+static bool replay_push(Replay* replay, const GameCore* game, const SnapshotRun* run) {
+    if(replay->frames == replay->capacity) {
+        size_t capacity = replay->capacity ? replay->capacity * 2 : 1024;
+        void* grown = realloc(replay->snapshots, capacity * SNAPSHOT_SIZE);
+        if(!grown) return false;
+        replay->snapshots = grown;
+        replay->capacity = capacity;
+    }
+    snapshot_encode(game, run, replay->snapshots[replay->frames++]);
+    return true;
+}
+
+// Times out every stratagem whose deadline is at or before tick, each one
+// right at its deadline, as the app's expiry timer does
+static uint32_t replay_expire(GameCore* game, uint32_t* step_tick, uint32_t tick) {
+    uint32_t outcome = 0;
+    while(!game->over && tick - *step_tick >= game->time_remaining) {
+        uint32_t dt = game->time_remaining;
+        GameEvent event = {.type = GameEventTick};
+        outcome |= game_step(game, &event, dt);
+        *step_tick += dt;
+    }
+    return outcome;
+}
+
+static uint32_t replay_advance(GameCore* game, uint32_t* step_tick, uint32_t tick, const GameEvent* event) {
+    uint32_t outcome = replay_expire(game, step_tick, tick);
+    if(game->over) return outcome;
+    outcome |= game_step(game, event, tick - *step_tick);
+    *step_tick = tick;
+    return outcome;
+}
+
+// The app reveals the next stratagem to the core once the capsule is down
+static void replay_reveal(GameCore* game, uint32_t* step_tick, bool* pending, uint32_t landed, uint32_t tick) {
+    if(!*pending || (int32_t)(tick - landed) < 0) return;
+    *pending = false;
+    GameEvent event = {.type = GameEventReveal};
+    replay_advance(game, step_tick, landed, &event);
+}
+
+// Re-simulates records[0..count), which start with the run's Start record,
+// into one snapshot per frame, with the capsule landing after each
+// completion and the shake after each wrong key as the app shows them
+static bool replay_simulate(Replay* replay, const Record* records, size_t count) {
+    const TelemetryRecord* start = &records[0].record;
+    
+    GameCore game;
+    game_init(&game, NULL, NULL);
+    GameEvent event = {.type = GameEventStart, .seed = start->value};
+    game_step(&game, &event, 0);
+    uint32_t step_tick = start->tick;
+    
+    bool landing = false, shaking = false, reveal = false;
+    uint32_t landing_tick = 0, shake_tick = 0;
+    
+    // Without a game over the run was cut short; it ends at its last key
+    uint32_t end = records[count - 1].record.tick;
+    
+    size_t next = 1;
+    for(uint32_t frame = start->tick;; frame += FRAME_MS) {
+        for(; next < count && records[next].record.tick <= frame; next++) {
+            const TelemetryRecord* record = &records[next].record;
+            if(record->type != TelemetryRecordKey) continue;
+            replay_reveal(&game, &step_tick, &reveal, landing_tick + SUCCESS_ANIM_MS, record->tick);
+            GameEvent key = {.type = GameEventKey, .direction = record->a};
+            uint32_t outcome = replay_advance(&game, &step_tick, record->tick, &key);
+            if(outcome & GameOutcomeCompleted) {
+                landing = true;
+                reveal = true;
+                landing_tick = record->tick;
+            }
+            if(outcome & GameOutcomeWrong) {
+                shaking = true;
+                shake_tick = record->tick;
+            }
+        }
+        replay_reveal(&game, &step_tick, &reveal, landing_tick + SUCCESS_ANIM_MS, frame);
+        GameEvent tick = {.type = GameEventTick};
+        replay_advance(&game, &step_tick, frame, &tick);
+        
+        SnapshotRun run = {
+            .mode = start->a,
+            .input_correct = true,
+            .run_ms = frame - start->tick,
+            .landing_ms = effect_ms(landing, landing_tick, frame, SUCCESS_ANIM_MS),
+            .shake_ms = effect_ms(shaking, shake_tick, frame, SHAKE_MS),
+        };
+        if(!replay_push(replay, &game, &run)) return false;
+        if(game.over) {
+            replay->game_over = true;
+            replay->final = game;
+            replay->final_run = run;
+            break;
+        }
+        if(frame - start->tick >= end - start->tick) break;
+    }
+    return true;
+}
+
+// Black sets, white clears, as the canvas draws in ColorBlack and ColorWhite
+static void raster_dot(Raster* raster, int x, int y) {
+    if(x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+    uint8_t* byte = &raster->buffer[(y / 8) * WIDTH + x];
+    uint8_t bit = 1 << (y % 8);
+    *byte = raster->color == DisplayListColorBlack ? *byte | bit : *byte & ~bit;
+}
+
+static void raster_line(Raster* raster, int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+    while(true) {
+        raster_dot(raster, x0, y0);
+        if(x0 == x1 && y0 == y1) break;
+        int twice = 2 * error;
+        if(twice >= dy) {
+            error += dy;
+            x0 += sx;
+        }
+        if(twice <= dx) {
+            error += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void raster_box(Raster* raster, int x, int y, int w, int h) {
+    for(int j = y; j < y + h; j++) {
+        for(int i = x; i < x + w; i++) {
+            raster_dot(raster, i, j);
+        }
+    }
+}
+
+static void raster_frame(Raster* raster, int x, int y, int w, int h) {
+    if(w <= 0 || h <= 0) return;
+    raster_line(raster, x, y, x + w - 1, y);
+    raster_line(raster, x, y + h - 1, x + w - 1, y + h - 1);
+    raster_line(raster, x, y, x, y + h - 1);
+    raster_line(raster, x + w - 1, y, x + w - 1, y + h - 1);
+}
+
+// Midpoint circle outline, as u8g2 draws it
+static void raster_circle(Raster* raster, int cx, int cy, int r) {
+    int x = r, y = 0, error = 1 - r;
+    while(x >= y) {
+        raster_dot(raster, cx + x, cy + y);
+        raster_dot(raster, cx - x, cy + y);
+        raster_dot(raster, cx + x, cy - y);
+        raster_dot(raster, cx - x, cy - y);
+        raster_dot(raster, cx + y, cy + x);
+        raster_dot(raster, cx - y, cy + x);
+        raster_dot(raster, cx + y, cy - x);
+        raster_dot(raster, cx - y, cy - x);
+        y++;
+        if(error < 0) {
+            error += 2 * y + 1;
+        } else {
+            x--;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// A dithered bar where the text would be, baseline at y
+static void raster_text(Raster* raster, int x, int y, uint8_t horizontal, uint8_t vertical, const char* text) {
+    uint8_t font = raster->font < sizeof(font_height) ? raster->font : DisplayListFontPrimary;
+    int width = (int)strlen(text) * font_advance[font];
+    int height = font_height[font];
+    
+    if(horizontal == DisplayListAlignRight) x -= width;
+    if(horizontal == DisplayListAlignCenter) x -= width / 2;
+    if(vertical == DisplayListAlignTop) y += height;
+    if(vertical == DisplayListAlignCenter) y += height / 2;
+    
+    for(int j = y - height + 1; j <= y; j++) {
+        for(int i = x + ((x + j) & 1); i < x + width; i += 2) {
+            raster_dot(raster, i, j);
+        }
+    }
+}
+
+// XBM: rows top to bottom, leftmost pixel in the lowest bit; clear bits
+// leave the frame alone
+static void raster_xbm(Raster* raster, int x, int y, int w, int h, const uint8_t* bitmap) {
+    int stride = (w + 7) / 8;
+    for(int j = 0; j < h; j++) {
+        for(int i = 0; i < w; i++) {
+            if(bitmap[j * stride + i / 8] & (1 << (i % 8))) raster_dot(raster, x + i, y + j);
+        }
+    }
+}
+
+// The draw callback's replay, with this file's primitives for the canvas
+static void raster_replay(Raster* raster, const DisplayList* list) {
+    bool capturing = false;
+    
+    for(uint16_t i = 0; i < list->count; i++) {
+        const DisplayListCommand* command = &list->commands[i];
+        
+        switch(command->op) {
+            case DisplayListOpClear:
+                memset(raster->buffer, 0, FRAME_BYTES);
+                break;
+            case DisplayListOpColor:
+                raster->color = command->arg;
+                break;
+            case DisplayListOpFont:
+                raster->font = command->arg;
+                break;
+            case DisplayListOpDot:
+                raster_dot(raster, command->x, command->y);
+                break;
+            case DisplayListOpLine:
+                raster_line(raster, command->x, command->y, (int8_t)command->w, (int8_t)command->h);
+                break;
+            case DisplayListOpBox:
+                raster_box(raster, command->x, command->y, command->w, command->h);
+                break;
+            case DisplayListOpFrame:
+                raster_frame(raster, command->x, command->y, command->w, command->h);
+                break;
+            case DisplayListOpCircle:
+                raster_circle(raster, command->x, command->y, command->w);
+                break;
+            case DisplayListOpStr:
+                raster_text(raster, command->x, command->y, DisplayListAlignLeft, DisplayListAlignBottom,
+                            display_list_text(list, command));
+                break;
+            case DisplayListOpStrAligned:
+                raster_text(raster, command->x, command->y, command->arg & 0x0F, command->arg >> 4,
+                            display_list_text(list, command));
+                break;
+            case DisplayListOpXbm:
+                raster_xbm(raster, command->x, command->y, command->w, command->h,
+                           display_list_bitmap(list, command));
+                break;
+            case DisplayListOpShift:
+                scene_shift(raster->buffer, command->x, command->y);
+                break;
+            case DisplayListOpLayerBegin:
+                if(raster->layer_valid && raster->layer_generation == display_list_generation(command)) {
+                    memcpy(raster->buffer, raster->layer, FRAME_BYTES);
+                    while(i + 1 < list->count && list->commands[i + 1].op != DisplayListOpLayerEnd) {
+                        i++;
+                    }
+                } else {
+                    raster->layer_generation = display_list_generation(command);
+                    capturing = true;
+                }
+                break;
+            case DisplayListOpLayerEnd:
+                if(capturing) {
+                    memcpy(raster->layer, raster->buffer, FRAME_BYTES);
+                    raster->layer_valid = true;
+                    capturing = false;
+                }
+                break;
+            default:
+                // Transitions need the previous screen's last frame
+                break;
+        }
+    }
+}
+    
+static void render_frame(Raster* raster, Scene* scene, DisplayList* list, IconCache* icons, const GameCore* game,
+                         const SnapshotRun* run, bool game_over) {
+    // Effects are timed from run_ms, the scene's clock here
+    uint32_t now = run->run_ms;
+    scene->success_anim.start_tick = now - (run->landing_ms != SNAPSHOT_EFFECT_NONE ? run->landing_ms : 0);
+    scene->screen_shake.active = run->shake_ms != SNAPSHOT_EFFECT_NONE;
+    scene->screen_shake.start_tick = now - (scene->screen_shake.active ? run->shake_ms : 0);
+    
+    SceneFrame frame = {
+        .now = now,
+        .state = run->landing_ms != SNAPSHOT_EFFECT_NONE ? GAME_STATE_STRATAGEM_SUCCESS : GAME_STATE_PLAY,
+        .mode = run->mode,
+        .quality = QualityTierFull,
+        .game = game,
+        .time_left = game->time_remaining,
+        .icon = icon_cache_get(icons, game->stratagem),
+        .achievement_toast = AchievementCount,
+    };
+    if(game_over) {
+        frame.state = GAME_STATE_GAME_OVER;
+        scene->screen_shake.active = false;
+    }
+    if(run->mode == GAME_MODE_VERSUS) {
+        frame.race.local_count = game->completed;
+    }
+    
+    scene_build(scene, &frame, list);
+    raster_replay(raster, list);
+}
+
+static void* render_worker(void* context) {
+    RenderJob* job = context;
+    const Replay* replay = job->replay;
+    size_t per_sheet = (size_t)job->columns * job->rows;
+    size_t sheet_row = (size_t)job->columns * ROW_BYTES;
+    
+    IconCache icons;
+    icon_cache_init(&icons);
+    Scene scene = *job->scene;
+    Raster raster = {0};
+    DisplayList list;
+    
+    while(true) {
+        size_t chunk = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+        size_t first = chunk * RENDER_CHUNK;
+        if(first >= replay->frames) break;
+        size_t last = first + RENDER_CHUNK < replay->frames ? first + RENDER_CHUNK : replay->frames;
+        
+        for(size_t index = first; index < last; index++) {
+            GameCore game;
+            SnapshotRun run;
+            bool over = replay->game_over && index == replay->frames - 1;
+            if(over) {
+                game = replay->final;
+                run = replay->final_run;
+            } else {
+                game_init(&game, NULL, NULL);
+                if(!snapshot_decode(replay->snapshots[index], SNAPSHOT_SIZE, &game, &run)) continue;
+            }
+            render_frame(&raster, &scene, &list, &icons, &game, &run, over);
+            
+            // Cells are whole bytes wide, so workers never share a byte;
+            // PBM rows are MSB first
+            uint8_t* sheet = job->sheets[index / per_sheet];
+            size_t cell = index % per_sheet;
+            uint8_t* origin = sheet + (cell / job->columns) * HEIGHT * sheet_row + (cell % job->columns) * ROW_BYTES;
+            for(int y = 0; y < HEIGHT; y++) {
+                const uint8_t* page = &raster.buffer[(y / 8) * WIDTH];
+                uint8_t bit = 1 << (y % 8);
+                for(int x = 0; x < WIDTH; x += 8) {
+                    uint8_t byte = 0;
+                    for(int i = 0; i < 8; i++) {
+                        if(page[x + i] & bit) byte |= 0x80 >> i;
+                    }
+                    origin[y * sheet_row + x / 8] = byte;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+// The parts of the PLAY screen drawn over the HUD layer every frame
+static bool layer_outside(int x, int y) {
+    bool bar = x >= 4 && x < 4 + PROGRESS_WIDTH && y >= 16 && y < 22;
+    bool arrows = y >= 22 && y < 42;
+    return !bar && !arrows;
+}
+
+// Renders the replay's frames in order as the app would and checks that the
+// steady ones, with no landing or shake and the HUD layer of the frame
+// before, differ from the cached layer only in the progress bar and the
+// arrow row. Also times replaying each of them from the cached layer and
+// with the layer redrawn, as every frame was before the cache.
+static bool layer_replay(const Replay* replay, const Scene* template, Raster* raster) {
+    Scene scene = *template;
+    IconCache icons;
+    icon_cache_init(&icons);
+    DisplayList list;
+    
+    size_t steady = 0, commands = 0, changed = 0;
+    double cached = 0, redrawn = 0;
+    for(size_t index = 0; index < replay->frames; index++) {
+        GameCore game;
+        SnapshotRun run;
+        game_init(&game, NULL, NULL);
+        if(!snapshot_decode(replay->snapshots[index], SNAPSHOT_SIZE, &game, &run)) continue;
+        
+        uint16_t generation = scene.hud.generation;
+        bool layer_valid = raster->layer_valid;
+        render_frame(raster, &scene, &list, &icons, &game, &run, false);
+        if(!layer_valid || generation != scene.hud.generation || run.landing_ms != SNAPSHOT_EFFECT_NONE ||
+           run.shake_ms != SNAPSHOT_EFFECT_NONE) {
+            continue;
+        }
+        steady++;
+        
+        uint16_t end = 0;
+        while(end < list.count && list.commands[end].op != DisplayListOpLayerEnd) end++;
+        commands += list.count - end - 1;
+        
+        for(int y = 0; y < HEIGHT; y++) {
+            for(int x = 0; x < WIDTH; x++) {
+                uint8_t bit = 1 << (y % 8);
+                size_t offset = (y / 8) * WIDTH + x;
+                if(!((raster->buffer[offset] ^ raster->layer[offset]) & bit)) continue;
+                changed++;
+                if(layer_outside(x, y)) {
+                    fprintf(stderr, "replay_render: frame %zu changes %d,%d outside the progress bar and arrow row\n",
+                            index, x, y);
+                    return false;
+                }
+            }
+        }
+        
+        double t0 = now_s();
+        raster_replay(raster, &list);
+        double t1 = now_s();
+        raster->layer_valid = false;
+        raster_replay(raster, &list);
+        double t2 = now_s();
+        cached += t1 - t0;
+        redrawn += t2 - t1;
+    }
+    if(steady == 0) {
+        fprintf(stderr, "replay_render: no steady PLAY frames\n");
+        return false;
+    }
+    
+    printf("layer: %zu of %zu frames steady, %.1f commands and %.0f pixels over the layer,"
+           " all in the progress bar and arrow row\n",
+           steady, replay->frames, (double)commands / steady, (double)changed / steady);
+    printf("layer: replay %.2f us from the cached layer, %.2f us redrawing it\n",
+           cached / steady * 1e6, redrawn / steady * 1e6);
+    return true;
+}
+
+// The check with its framebuffers carved from a sealed arena
+static bool layer_check(const Replay* replay, const Scene* template) {
+    uint8_t* memory = malloc(ARENA_SLOT(sizeof(Raster)));
+    if(!memory) return false;
+    Arena arena;
+    arena_init(&arena, memory, ARENA_SLOT(sizeof(Raster)));
+    Raster* raster = arena_alloc(&arena, sizeof(Raster));
+    arena_seal(&arena);
+    bool ok = layer_replay(replay, template, raster);
+    free(memory);
+    return ok;
+}
+
+// Renders every frame of the replay onto sheets of columns x rows frames;
+// with no directory the sheets are only rendered, for timing
+static bool render(const Replay* replay, const Scene* scene, long threads, uint16_t columns, uint16_t rows,
+                   const char* directory, unsigned run) {
+    size_t per_sheet = (size_t)columns * rows;
+    size_t sheet_count = (replay->frames + per_sheet - 1) / per_sheet;
+    size_t sheet_size = per_sheet * FRAME_BYTES;
+    
+    // The sheets and the table of them, sealed before the workers start
+    size_t arena_size = ARENA_SLOT(sheet_count * sizeof(uint8_t*)) + sheet_count * ARENA_SLOT(sheet_size);
+    uint8_t* memory = malloc(arena_size);
+    if(!memory) return false;
+    Arena arena;
+    arena_init(&arena, memory, arena_size);
+    RenderJob job = {
+        .replay = replay,
+        .scene = scene,
+        .columns = columns,
+        .rows = rows,
+        .sheets = arena_alloc(&arena, sheet_count * sizeof(uint8_t*)),
+    };
+    for(size_t i = 0; i < sheet_count; i++) {
+        job.sheets[i] = arena_alloc(&arena, sheet_size);
+    }
+    arena_seal(&arena);
+    
+    double start = now_s();
+    pthread_t pool[RENDER_MAX_THREADS];
+    for(long t = 0; t < threads; t++) {
+        pthread_create(&pool[t], NULL, render_worker, &job);
+    }
+    for(long t = 0; t < threads; t++) {
+        pthread_join(pool[t], NULL);
+    }
+    double elapsed = now_s() - start;
+    printf("run %u: %zu frames (%.1f s of play) on %ld threads in %.3f s, %.0f frames/s\n", run,
+           replay->frames, replay->frames * FRAME_MS / 1000.0, threads, elapsed,
+           replay->frames / (elapsed > 0 ? elapsed : 1e-9));
+    
+    bool ok = true;
+    for(size_t i = 0; i < sheet_count && ok && directory; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/run%03u_sheet%03zu.pbm", directory, run, i);
+        FILE* file = fopen(path, "wb");
+        if(!file) {
+            fprintf(stderr, "replay_render: cannot write %s\n", path);
+            ok = false;
+            break;
+        }
+        fprintf(file, "P4\n%u %u\n", columns * WIDTH, rows * HEIGHT);
+        ok = fwrite(job.sheets[i], 1, sheet_size, file) == sheet_size;
+        ok = fclose(file) == 0 && ok;
+    }
+    
+    free(memory);
+    return ok;
+}
+
+// A player who types an arrow every 150-250 ms and misses one in 40 when
+// there is time to spare, as telemetry would have logged it. That banks
+// time faster than it runs out, so the run goes on for as long as asked.
+static bool bench_records(Records* records, uint32_t minutes) {
+    uint32_t random = 0x5EED;
+    Record start = {.record = {.tick = 1000, .type = TelemetryRecordStart, .value = 0xC0FFEE}};
+    if(!records_push(records, &start)) return false;
+    
+    GameCore game;
+    game_init(&game, NULL, NULL);
+    GameEvent event = {.type = GameEventStart, .seed = start.record.value};
+    game_step(&game, &event, 0);
+    uint32_t step_tick = start.record.tick;
+    
+    uint32_t tick = start.record.tick;
+    uint32_t end = start.record.tick + minutes * 60000;
+    while(tick < end && !game.over) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        tick += 150 + random % 100;
+        
+        Direction direction = catalog_direction(catalog_get(game.stratagem), game.input_index);
+        if(random % 40 == 0 && game.time_remaining > 2 * WRONG_PENALTY) direction = (direction + 1) % 4;
+        Record key = {
+            .record = {.tick = tick, .type = TelemetryRecordKey, .a = direction},
+            .sequence = records->count,
+        };
+        if(!records_push(records, &key)) return false;
+        
+        GameEvent press = {.type = GameEventKey, .direction = direction};
+        replay_advance(&game, &step_tick, tick, &press);
+    }
+    return true;
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: replay_render [-j threads] [-o dir] [-r run] [-c columns] [-n rows] telemetry.bin\n"
+                    "       replay_render --bench [minutes] [threads]\n"
+                    "       replay_render --layer [minutes]\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* directory = ".";
+    long only_run = -1;
+    long columns = DEFAULT_COLUMNS;
+    long rows = DEFAULT_ROWS;
+    const char* input = NULL;
+    bool bench = false;
+    bool layer = false;
+    uint32_t bench_minutes = 10;
+    
+    if(argc > 1 && (strcmp(argv[1], "--bench") == 0 || strcmp(argv[1], "--layer") == 0)) {
+        bench = true;
+        layer = strcmp(argv[1], "--layer") == 0;
+        directory = NULL;
+        if(argc > 2) bench_minutes = strtoul(argv[2], NULL, 10);
+        if(argc > 3 && !layer) threads = strtol(argv[3], NULL, 10);
+        if(bench_minutes == 0) return usage();
+    } else {
+        for(int i = 1; i < argc; i++) {
+            if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                threads = strtol(argv[++i], NULL, 10);
+            } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+                directory = argv[++i];
+            } else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+                only_run = strtol(argv[++i], NULL, 10);
+            } else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+                columns = strtol(argv[++i], NULL, 10);
+            } else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+                rows = strtol(argv[++i], NULL, 10);
+            } else if(argv[i][0] != '-' && !input) {
+                input = argv[i];
+            } else {
+                return usage();
+            }
+        }
+        if(!input || columns < 1 || columns > 256 || rows < 1 || rows > 256) return usage();
+    }
+    if(threads < 1) threads = 1;
+    if(threads > RENDER_MAX_THREADS) threads = RENDER_MAX_THREADS;
+    
+    // Every run starts from the same background, as the app's first frames do
+    Scene scene;
+    scene_init(&scene, 0);
+    srand(1);
+    scene_init_background(&scene);
+    
+    Records records = {0};
+    bool ok = bench ? bench_records(&records, bench_minutes) : records_load(&records, input);
+    
+    unsigned run = 0;
+    for(size_t i = 0; ok && i < records.count; i++) {
+        if(records.records[i].record.type != TelemetryRecordStart) continue;
+        size_t end = i + 1;
+        while(end < records.count && records.records[end].record.type != TelemetryRecordStart) end++;
+        
+        if(only_run < 0 || only_run == run) {
+            if(records.records[i].record.a == GAME_MODE_PRACTICE) {
+                printf("run %u: practice mode, skipped\n", run);
+            } else {
+                Replay replay = {0};
+                ok = replay_simulate(&replay, &records.records[i], end - i) &&
+                     (layer ? layer_check(&replay, &scene) :
+                              render(&replay, &scene, threads, columns, rows, directory, run));
+                free(replay.snapshots);
+            }
+        }
+        run++;
+        i = end - 1;
+    }
+    if(ok && run == 0) {
+        fprintf(stderr, "replay_render: no recorded runs in %s\n", input);
+    }
+    
+    free(records.records);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Break a build down into flash and RAM per subsystem.
+
+Reads the symbol table of the unstripped app ELF (ufbt copies it to
+dist/debug/<appid>_d.elf) with nm. Each symbol goes to the source file it
+was defined in; stratagem_hero.c and scene.c are further split by symbol
+name into the features the build profiles switch off. Code, read-only and
+initialised data count as flash, initialised data and bss as RAM. Buffers
+carved from the arena at run time are not symbols; the app keeps the arena's
+size in stratagem_hero_arena_size, which is read back from the ELF and shown
+as its own RAM row. The frame stream's heap, taken only while it runs, is
+not counted.
+
+Pass both profiles to compare them side by side.
+
+usage: size_report.py [--nm NM] <app_d.elf>...
+"""
+
+import os
+import re
+import struct
+import subprocess
+import sys
+
+DEFAULT_NM = "arm-none-eabi-nm"
+
+# Features inside stratagem_hero.c and scene.c, matched on the symbol name
+# in order
+APP_FEATURES = [
+    ("background", re.compile(r"star|planet|space_background")),
+    ("music", re.compile(r"welcome")),
+    ("splash", re.compile(r"splash")),
+    ("flag", re.compile(r"flag")),
+    ("effects", re.compile(r"shake|success|capsule|debris|transition")),
+    ("leaderboard", re.compile(r"leaderboard|board_|score_")),
+    ("suspend", re.compile(r"snapshot|run_")),
+    ("icons", re.compile(r"icon")),
+]
+
+FLASH_TYPES = "tTrRdD"
+RAM_TYPES = "dDbB"
+
+ARENA_SYMBOL = "stratagem_hero_arena_size"
+
+
+class ReportError(Exception):
+    pass
+
+
+def subsystem(name, source):
+    # Startup code and anything else without debug info
+    if not source:
+        return "other"
+    module = os.path.splitext(os.path.basename(source))[0]
+    if module not in ("stratagem_hero", "scene"):
+        return module
+    for feature, pattern in APP_FEATURES:
+        if pattern.search(name):
+            return feature
+    return "app" if module == "stratagem_hero" else module
+
+
+def read_symbols(nm, path):
+    try:
+        output = subprocess.run(
+            [nm, "--print-size", "--line-numbers", "--defined-only", path],
+            check=True,
+            capture_output=True,
+            text=True,
+        ).stdout
+    except (OSError, subprocess.CalledProcessError) as error:
+        raise ReportError("%s: %s" % (path, error))
+
+    sizes = {}
+    for line in output.splitlines():
+        symbol, _, location = line.partition("\t")
+        fields = symbol.split()
+        # Symbols without a size (labels, section markers) cost nothing
+        if len(fields) != 4:
+            continue
+        size, kind, name = int(fields[1], 16), fields[2], fields[3]
+        source = location.rsplit(":", 1)[0] if location else ""
+        totals = sizes.setdefault(subsystem(name, source), [0, 0])
+        if kind in FLASH_TYPES:
+            totals[0] += size
+        if kind in RAM_TYPES:
+            totals[1] += size
+    return sizes
+
+
+def read_arena_size(path):
+    """Value of the 32-bit ARENA_SYMBOL, None when the build has none."""
+    try:
+        with open(path, "rb") as elf:
+            data = elf.read()
+    except OSError as error:
+        raise ReportError("%s: %s" % (path, error))
+    if data[:4] != b"\x7fELF":
+        raise ReportError("%s: not an ELF file" % path)
+
+    wide = data[4] == 2
+    order = "<" if data[5] == 1 else ">"
+    if wide:
+        e_type, = struct.unpack_from(order + "H", data, 16)
+        shoff, = struct.unpack_from(order + "Q", data, 40)
+        shentsize, shnum = struct.unpack_from(order + "HH", data, 58)
+        section_format, symbol_format = "IIQQQQIIQQ", "IBBHQQ"
+    else:
+        e_type, = struct.unpack_from(order + "H", data, 16)
+        shoff, = struct.unpack_from(order + "I", data, 32)
+        shentsize, shnum = struct.unpack_from(order + "HH", data, 46)
+        section_format, symbol_format = "IIIIIIIIII", "IIIBBH"
+
+    # name, type, flags, addr, offset, size, link, info, addralign, entsize
+    sections = [
+        struct.unpack_from(order + section_format, data, shoff + i * shentsize)
+        for i in range(shnum)
+    ]
+    for section in sections:
+        if section[1] != 2:  # SHT_SYMTAB
+            continue
+        strtab = sections[section[6]]
+        for offset in range(section[4], section[4] + section[5], section[9]):
+            fields = struct.unpack_from(order + symbol_format, data, offset)
+            if wide:
+                name, _, _, shndx, value, _ = fields
+            else:
+                name, value, _, _, _, shndx = fields
+            start = strtab[4] + name
+            if data[start : data.index(b"\0", start)] != ARENA_SYMBOL.encode():
+                continue
+            if shndx == 0 or shndx >= len(sections):
+                return None
+            home = sections[shndx]
+            # Relocatable objects, as a fap is, hold section offsets
+            address = value if e_type == 1 else value - home[3]
+            if home[1] == 8:  # SHT_NOBITS
+                return 0
+            return struct.unpack_from(order + "I", data, home[4] + address)[0]
+    return None
+
+
+def report(paths, builds):
+    names = sorted(
+        set().union(*builds), key=lambda name: (-builds[0].get(name, [0, 0])[0], name)
+    )
+    labels = [os.path.basename(path) for path in paths]
+    width = max([len(name) for name in names] + [len("total")])
+
+    out = []
+    out.append(" " * width + "".join("  %17s" % label[-17:] for label in labels))
+    out.append("%-*s" % (width, "subsystem") + "  %8s %8s" % ("flash", "ram") * len(builds))
+    for name in names + ["total"]:
+        row = "%-*s" % (width, name)
+        for sizes in builds:
+            if name == "total":
+                flash = sum(value[0] for value in sizes.values())
+                ram = sum(value[1] for value in sizes.values())
+            else:
+                flash, ram = sizes.get(name, [0, 0])
+            row += "  %8d %8d" % (flash, ram)
+        out.append(row)
+    return "\n".join(out)
+
+
+def main(argv):
+    nm = DEFAULT_NM
+    paths = argv[1:]
+    if len(paths) >= 2 and paths[0] == "--nm":
+        nm, paths = paths[1], paths[2:]
+    if not paths:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 2
+    try:
+        builds = [read_symbols(nm, path) for path in paths]
+        for path, sizes in zip(paths, builds):
+            arena = read_arena_size(path)
+            if arena is not None:
+                sizes["arena"] = [0, arena]
+    except ReportError as error:
+        print("size_report: error: %s" % error, file=sys.stderr)
+        return 1
+    print(report(paths, builds))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,426 @@
+// Loopback test of the versus protocol in versus.c.
+//
+// Two Versus instances play full matches against each other over a
+// pseudo-terminal pair, one on each end, like two Flippers on a UART cable.
+// Both run on a shared virtual millisecond clock, each with its own random
+// clock offset, and every frame sits on the wire for the configured delay
+// plus up to the configured jitter before it is written to the pty. Frames
+// never overtake each other, as on a serial line; with a loss rate set,
+// whole frames are dropped instead. On top of that the first few final
+// Completion frames of every finish can be dropped on purpose, the case
+// where a winner that only waits for the loser's finish would be wrong.
+//
+// Each node ticks every 50 ms and after every frame it receives, as the
+// app's link poll does, and plays its race on a random pace once its side
+// of the countdown is over. Some matches are started by both nodes in the
+// same millisecond, some end in a forfeit. A match is over when both sides
+// show a result; then both go back to the menu.
+//
+// Checks that both sides agree on the seed and the result, that the result
+// matches the real finish order whenever the finishes are further apart
+// than the clocks can resolve, and that rx_lost counts the dropped frames.
+// Reports the round trip the nodes measured and how far their clock offset
+// estimate is off.
+//
+// build (from the app directory):
+//   cc -O2 -I. tools/versus_loopback.c versus.c -o versus_loopback -lutil
+//
+// usage: versus_loopback [matches] [delay ms] [jitter ms] [loss per mille] [seed] [finish drops]
+
+#include "versus.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define LOOPBACK_DEFAULT_MATCHES 50
+#define LOOPBACK_DEFAULT_DELAY 20
+#define LOOPBACK_DEFAULT_JITTER 10
+
+// As in the app: link poll period and a pause on the result screen
+#define LOOPBACK_POLL_MS 50
+#define LOOPBACK_MENU_MS 1000
+
+// A match still without a result after this long is stuck
+#define LOOPBACK_MATCH_TIMEOUT_MS 120000
+
+// Pace of one stratagem, input and landing animation included
+#define LOOPBACK_PACE_MIN_MS 600
+#define LOOPBACK_PACE_MAX_MS 1800
+
+#define LOOPBACK_WIRE_FRAMES 256
+
+typedef struct {
+    uint32_t due;
+    uint8_t data[VERSUS_FRAME_SIZE];
+} WireFrame;
+
+// One direction of the cable
+typedef struct {
+    WireFrame frames[LOOPBACK_WIRE_FRAMES];
+    uint16_t head;
+    uint16_t count;
+    uint32_t last_due;
+    uint32_t sent;
+    uint32_t dropped;
+    bool tail_dropped; // the last frame sent was lost, which no later one shows yet
+} Wire;
+
+typedef struct {
+    Versus versus;
+    int fd;
+    uint32_t clock_offset;
+    Wire* out;
+    uint32_t next_poll;
+    
+    // The race as this player runs it
+    bool racing;
+    bool done;
+    uint16_t reported;
+    int16_t forfeit_at;
+    uint32_t next_completion;
+    uint32_t finish;
+    uint32_t seed;
+    uint32_t finish_dropped;
+} Node;
+
+typedef struct {
+    uint32_t delay;
+    uint32_t jitter;
+    uint32_t loss;
+    uint32_t finish_drops; // final Completion frames lost per finish
+} WireConfig;
+
+static uint32_t wire_now;
+static uint32_t rng_state;
+static WireConfig wire_config;
+
+static uint32_t xorshift(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t random_range(uint32_t low, uint32_t high) {
+    return low + xorshift() % (high - low + 1);
+}
+
+static uint32_t node_now(const Node* node) {
+    return wire_now + node->clock_offset;
+}
+
+static void node_send(const uint8_t* data, size_t size, void* context) {
+    Node* node = context;
+    Wire* wire = node->out;
+    
+    VersusFrame frame;
+    bool finish = versus_frame_decode(data, &frame) && frame.type == VersusFrameTypeCompletion &&
+                  frame.arg >= VERSUS_MATCH_LENGTH;
+    
+    wire->sent++;
+    if(finish && node->finish_dropped < wire_config.finish_drops) {
+        node->finish_dropped++;
+        wire->dropped++;
+        wire->tail_dropped = true;
+        return;
+    }
+    if(wire_config.loss && xorshift() % 1000 < wire_config.loss) {
+        wire->dropped++;
+        wire->tail_dropped = true;
+        return;
+    }
+    if(wire->count == LOOPBACK_WIRE_FRAMES || size != VERSUS_FRAME_SIZE) {
+        fprintf(stderr, "versus_loopback: wire overflow\n");
+        exit(1);
+    }
+    
+    uint32_t due = wire_now + wire_config.delay + (wire_config.jitter ? xorshift() % (wire_config.jitter + 1) : 0);
+    if((int32_t)(due - wire->last_due) < 0) due = wire->last_due;
+    wire->last_due = due;
+    wire->tail_dropped = false;
+    
+    WireFrame* slot = &wire->frames[(wire->head + wire->count) % LOOPBACK_WIRE_FRAMES];
+    slot->due = due;
+    memcpy(slot->data, data, size);
+    wire->count++;
+}
+
+// Writes one frame into the sender's end and reads it back out of the
+// receiver's, so the bytes really cross the pty
+static void wire_transfer(Node* from, Node* to, const uint8_t* data) {
+    if(write(from->fd, data, VERSUS_FRAME_SIZE) != VERSUS_FRAME_SIZE) {
+        perror("versus_loopback: write");
+        exit(1);
+    }
+    
+    uint8_t received[VERSUS_FRAME_SIZE];
+    size_t size = 0;
+    while(size < VERSUS_FRAME_SIZE) {
+        struct pollfd pfd = {.fd = to->fd, .events = POLLIN};
+        if(poll(&pfd, 1, 1000) <= 0) {
+            fprintf(stderr, "versus_loopback: pty stalled\n");
+            exit(1);
+        }
+        ssize_t got = read(to->fd, received + size, VERSUS_FRAME_SIZE - size);
+        if(got < 0 && errno != EINTR && errno != EAGAIN) {
+            perror("versus_loopback: read");
+            exit(1);
+        }
+        if(got > 0) size += got;
+    }
+    
+    // The app feeds whatever it received, then ticks
+    versus_feed(&to->versus, received, size, node_now(to));
+    versus_tick(&to->versus, node_now(to));
+}
+
+static void wire_deliver(Wire* wire, Node* from, Node* to) {
+    while(wire->count && (int32_t)(wire_now - wire->frames[wire->head].due) >= 0) {
+        uint8_t data[VERSUS_FRAME_SIZE];
+        memcpy(data, wire->frames[wire->head].data, sizeof(data));
+        wire->head = (wire->head + 1) % LOOPBACK_WIRE_FRAMES;
+        wire->count--;
+        wire_transfer(from, to, data);
+    }
+}
+
+static void node_play(Node* node) {
+    Versus* versus = &node->versus;
+    uint32_t now = node_now(node);
+    
+    if(!node->racing && versus->match == VersusMatchRacing) {
+        node->racing = true;
+        node->seed = versus->seed;
+        node->next_completion = wire_now + random_range(LOOPBACK_PACE_MIN_MS, LOOPBACK_PACE_MAX_MS);
+    }
+    if(!node->racing || node->done || wire_now != node->next_completion) return;
+    
+    if(node->reported == node->forfeit_at) {
+        versus_report_forfeit(versus, now);
+        node->done = true;
+        return;
+    }
+    versus_report_completion(versus, now);
+    node->reported++;
+    if(node->reported >= VERSUS_MATCH_LENGTH) {
+        node->done = true;
+        node->finish = wire_now;
+    } else {
+        node->next_completion = wire_now + random_range(LOOPBACK_PACE_MIN_MS, LOOPBACK_PACE_MAX_MS);
+    }
+}
+
+static void node_step(Node* node) {
+    if(wire_now == node->next_poll) {
+        node->next_poll += LOOPBACK_POLL_MS;
+        versus_tick(&node->versus, node_now(node));
+    }
+    node_play(node);
+}
+
+static void node_to_menu(Node* node) {
+    versus_reset_match(&node->versus);
+    node->racing = false;
+    node->done = false;
+    node->reported = 0;
+    node->forfeit_at = -1;
+    node->finish = 0;
+    node->seed = 0;
+    node->finish_dropped = 0;
+}
+
+static void step(Node* a, Node* b, Wire* ab, Wire* ba) {
+    wire_now++;
+    wire_deliver(ab, a, b);
+    wire_deliver(ba, b, a);
+    node_step(a);
+    node_step(b);
+}
+
+static const char* result_name(VersusResult result) {
+    switch(result) {
+        case VersusResultWin:
+            return "win";
+        case VersusResultLose:
+            return "lose";
+        case VersusResultDraw:
+            return "draw";
+        default:
+            return "pending";
+    }
+}
+
+static int open_cable(int* a, int* b) {
+    if(openpty(a, b, NULL, NULL, NULL) < 0) {
+        perror("versus_loopback: openpty");
+        return -1;
+    }
+    
+    // No echo and no line editing: the slave end behaves like a raw UART
+    struct termios tio;
+    tcgetattr(*b, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*b, TCSANOW, &tio);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t matches = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : LOOPBACK_DEFAULT_MATCHES;
+    wire_config.delay = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : LOOPBACK_DEFAULT_DELAY;
+    wire_config.jitter = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : LOOPBACK_DEFAULT_JITTER;
+    wire_config.loss = argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 10) : 0;
+    rng_state = argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 10) : 1;
+    wire_config.finish_drops = argc > 6 ? (uint32_t)strtoul(argv[6], NULL, 10) : 0;
+    if(!rng_state) rng_state = 1;
+    
+    static Wire ab, ba;
+    static Node nodes[2];
+    Node* a = &nodes[0];
+    Node* b = &nodes[1];
+    if(open_cable(&a->fd, &b->fd) < 0) return 1;
+    
+    a->out = &ab;
+    b->out = &ba;
+    for(int i = 0; i < 2; i++) {
+        versus_init(&nodes[i].versus, node_send, &nodes[i]);
+        nodes[i].clock_offset = xorshift();
+        nodes[i].next_poll = random_range(1, LOOPBACK_POLL_MS);
+        node_to_menu(&nodes[i]);
+    }
+    
+    printf("%u matches, delay %u ms, jitter %u ms, loss %u/1000, %u finish frames dropped\n",
+           matches, wire_config.delay, wire_config.jitter, wire_config.loss, wire_config.finish_drops);
+    
+    // Two finishes this close may come out either way once each side has
+    // mapped the other's timestamp through its clock estimate
+    uint32_t resolution = wire_config.jitter + 2;
+    
+    uint32_t agreed = 0, correct = 0, close_calls = 0, forfeits = 0, stuck = 0, failed = 0;
+    uint32_t rtt_max = 0;
+    uint64_t rtt_sum = 0;
+    int32_t offset_error_max = 0;
+    
+    for(uint32_t match = 0; match < matches; match++) {
+        // Back in the menu, wait for the link before pressing start
+        uint32_t menu_end = wire_now + LOOPBACK_MENU_MS;
+        while(wire_now != menu_end ||
+              !versus_is_connected(&a->versus, node_now(a)) ||
+              !versus_is_connected(&b->versus, node_now(b))) {
+            step(a, b, &ab, &ba);
+        }
+        
+        // Every fifth match both players press start in the same millisecond
+        if(match % 5 == 4) {
+            versus_start(&a->versus, xorshift(), node_now(a));
+            versus_start(&b->versus, xorshift(), node_now(b));
+        } else {
+            Node* initiator = match % 2 ? b : a;
+            versus_start(&initiator->versus, xorshift(), node_now(initiator));
+        }
+        
+        // One match in eight ends early with one side giving up
+        if(xorshift() % 8 == 0) {
+            nodes[xorshift() % 2].forfeit_at = (int16_t)(xorshift() % VERSUS_MATCH_LENGTH);
+        }
+        
+        uint32_t deadline = wire_now + LOOPBACK_MATCH_TIMEOUT_MS;
+        while(a->versus.result == VersusResultPending || b->versus.result == VersusResultPending) {
+            if(wire_now == deadline) break;
+            step(a, b, &ab, &ba);
+        }
+        
+        VersusResult ra = a->versus.result;
+        VersusResult rb = b->versus.result;
+        bool ok = true;
+        const char* why = NULL;
+        
+        if(ra == VersusResultPending || rb == VersusResultPending) {
+            stuck++;
+            ok = false;
+            why = "no result";
+        } else if(a->seed != b->seed) {
+            ok = false;
+            why = "raced different seeds";
+        } else if(!((ra == VersusResultWin && rb == VersusResultLose) ||
+                    (ra == VersusResultLose && rb == VersusResultWin) ||
+                    (ra == VersusResultDraw && rb == VersusResultDraw))) {
+            ok = false;
+            why = "sides disagree";
+        } else {
+            agreed++;
+            
+            VersusResult expected;
+            bool decided = true;
+            if(a->forfeit_at >= 0 || b->forfeit_at >= 0) {
+                forfeits++;
+                expected = a->forfeit_at >= 0 ? VersusResultLose : VersusResultWin;
+            } else if(a->reported < VERSUS_MATCH_LENGTH || b->reported < VERSUS_MATCH_LENGTH) {
+                // The loser stops racing once the other side's finish arrives
+                expected = a->reported >= VERSUS_MATCH_LENGTH ? VersusResultWin : VersusResultLose;
+            } else {
+                int32_t delta = (int32_t)(a->finish - b->finish);
+                expected = delta < 0 ? VersusResultWin : delta > 0 ? VersusResultLose : VersusResultDraw;
+                if((uint32_t)abs(delta) <= resolution) {
+                    decided = false;
+                    close_calls++;
+                }
+            }
+            if(!decided || ra == expected) {
+                correct++;
+            } else {
+                ok = false;
+                why = "wrong winner";
+            }
+        }
+        
+        int32_t true_offset = (int32_t)(b->clock_offset - a->clock_offset);
+        int32_t offset_error = abs(a->versus.offset - true_offset);
+        if(offset_error > offset_error_max) offset_error_max = offset_error;
+        rtt_sum += a->versus.rtt;
+        if(a->versus.rtt > rtt_max) rtt_max = a->versus.rtt;
+        
+        if(!ok) {
+            failed++;
+            printf("match %u: %s (a %s, b %s, finish a %u b %u, forfeit a %d b %d)\n",
+                   match, why, result_name(ra), result_name(rb),
+                   a->finish, b->finish, a->forfeit_at, b->forfeit_at);
+        }
+        
+        node_to_menu(a);
+        node_to_menu(b);
+    }
+    
+    // A receiver only sees a loss once a later frame arrives, so run on until
+    // the heartbeats have sent one past the last drop, then let the last frames
+    // land so the loss counters are complete
+    while(ab.tail_dropped || ba.tail_dropped) {
+        step(a, b, &ab, &ba);
+    }
+    for(uint32_t i = 0; i < wire_config.delay + wire_config.jitter + 1; i++) {
+        step(a, b, &ab, &ba);
+    }
+    
+    printf("agreed %u/%u, correct %u, close calls %u, forfeits %u, stuck %u\n",
+           agreed, matches, correct, close_calls, forfeits, stuck);
+    printf("rtt mean %.1f ms, max %u ms, clock offset error max %d ms\n",
+           matches ? (double)rtt_sum / matches : 0.0, rtt_max, offset_error_max);
+    printf("a->b: %u frames, %u dropped, b counted %u lost, %u corrupt\n",
+           ab.sent, ab.dropped, b->versus.rx_lost, b->versus.rx_corrupt);
+    printf("b->a: %u frames, %u dropped, a counted %u lost, %u corrupt\n",
+           ba.sent, ba.dropped, a->versus.rx_lost, a->versus.rx_corrupt);
+    
+    // Counted on the receiving side, so compared crosswise
+    bool lost_ok = b->versus.rx_lost == ab.dropped && a->versus.rx_lost == ba.dropped;
+    if(!lost_ok) printf("loss counters do not match the frames dropped\n");
+    
+    close(a->fd);
+    close(b->fd);
+    return failed || !lost_ok ? 1 : 0;
+}
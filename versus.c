@@ -0,0 +1,328 @@
+#include "versus.h"
+
+#include <string.h>
+
+static uint8_t versus_crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for(size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put_le16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void put_le32(uint8_t* out, uint32_t value) {
+    for(uint8_t i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint16_t get_le16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+size_t versus_frame_encode(const VersusFrame* frame, uint8_t* out) {
+    out[0] = VERSUS_SYNC_BYTE;
+    out[1] = frame->type;
+    out[2] = frame->seq;
+    put_le16(&out[3], frame->arg);
+    put_le32(&out[5], frame->t0);
+    put_le32(&out[9], frame->t1);
+    out[13] = versus_crc8(&out[1], VERSUS_FRAME_SIZE - 2);
+    return VERSUS_FRAME_SIZE;
+}
+
+bool versus_frame_decode(const uint8_t* data, VersusFrame* frame) {
+    if(data[0] != VERSUS_SYNC_BYTE) return false;
+    if(versus_crc8(&data[1], VERSUS_FRAME_SIZE - 2) != data[13]) return false;
+
+    frame->type = data[1];
+    frame->seq = data[2];
+    frame->arg = get_le16(&data[3]);
+    frame->t0 = get_le32(&data[5]);
+    frame->t1 = get_le32(&data[9]);
+    return true;
+}
+
+static void versus_send(Versus* versus, uint8_t type, uint16_t arg, uint32_t t0, uint32_t t1) {
+    VersusFrame frame = {
+        .type = type,
+        .seq = versus->tx_seq++,
+        .arg = arg,
+        .t0 = t0,
+        .t1 = t1,
+    };
+    uint8_t data[VERSUS_FRAME_SIZE];
+    versus_frame_encode(&frame, data);
+    versus->send(data, sizeof(data), versus->context);
+}
+
+void versus_init(Versus* versus, VersusSendCallback send, void* context) {
+    memset(versus, 0, sizeof(Versus));
+    versus->send = send;
+    versus->context = context;
+}
+
+bool versus_is_connected(const Versus* versus, uint32_t now) {
+    return versus->peer_seen && (now - versus->last_rx_time) < VERSUS_LINK_TIMEOUT_MS;
+}
+
+void versus_get_status(const Versus* versus, uint32_t now, VersusStatus* status) {
+    status->match = versus->match;
+    status->result = versus->result;
+    status->connected = versus_is_connected(versus, now);
+    status->rtt = versus->rtt;
+    status->start_time = versus->start_time;
+    status->local_count = versus->local_count;
+    status->remote_count = versus->remote_count;
+    status->local_done = versus->local_done;
+}
+
+uint32_t versus_remote_to_local(const Versus* versus, uint32_t remote_time) {
+    return remote_time - (uint32_t)versus->offset;
+}
+
+static void versus_add_clock_sample(Versus* versus, uint32_t t0, uint32_t t1, uint32_t t2) {
+    uint32_t rtt = t2 - t0;
+    int32_t offset = (int32_t)(t1 - t0) - (int32_t)(rtt / 2);
+
+    versus->sample_rtt[versus->sample_next] = rtt;
+    versus->sample_offset[versus->sample_next] = offset;
+    versus->sample_next = (versus->sample_next + 1) % VERSUS_CLOCK_SAMPLES;
+    if(versus->sample_count < VERSUS_CLOCK_SAMPLES) versus->sample_count++;
+
+    // The sample with the shortest round trip has the least queueing jitter
+    // in it, so its offset is the most trustworthy one in the window.
+    uint8_t best = 0;
+    for(uint8_t i = 1; i < versus->sample_count; i++) {
+        if(versus->sample_rtt[i] < versus->sample_rtt[best]) best = i;
+    }
+    versus->rtt = versus->sample_rtt[best];
+    versus->offset = versus->sample_offset[best];
+    versus->synced = true;
+}
+
+static void versus_update_result(Versus* versus) {
+    if(versus->result != VersusResultPending) return;
+    if(versus->match == VersusMatchIdle || versus->match == VersusMatchCountdown) return;
+
+    if(versus->local_forfeit) {
+        versus->result = VersusResultLose;
+    } else if(versus->remote_forfeit) {
+        versus->result = VersusResultWin;
+    } else if(versus->local_done && versus->remote_done) {
+        int32_t delta = (int32_t)(versus->local_finish - versus->remote_finish);
+        if(delta < 0) {
+            versus->result = VersusResultWin;
+        } else if(delta > 0) {
+            versus->result = VersusResultLose;
+        } else {
+            versus->result = VersusResultDraw;
+        }
+    } else if(versus->remote_done) {
+        // The remote finish already happened before we received it, and we
+        // are not done yet, so there is nothing left to race for.
+        versus->result = VersusResultLose;
+    } else if(versus->local_done && versus->finish_acked) {
+        // The peer had not finished when our finish reached it, so it
+        // finishes after us; an earlier finish would have come with the ack.
+        versus->result = VersusResultWin;
+    }
+}
+
+static void versus_begin_countdown(Versus* versus, uint32_t seed, uint32_t start_time, bool initiator) {
+    versus_reset_match(versus);
+    versus->match = VersusMatchCountdown;
+    versus->initiator = initiator;
+    versus->seed = seed;
+    versus->start_time = start_time;
+}
+
+static void versus_handle_frame(Versus* versus, const VersusFrame* frame, uint32_t now) {
+    // A peer silent for longer than the link timeout may have restarted and
+    // numbers its frames from scratch
+    if(versus->rx_seq_valid && now - versus->last_rx_time < VERSUS_LINK_TIMEOUT_MS) {
+        // Behind the last frame: a duplicate or one that arrived late
+        int8_t gap = (int8_t)(frame->seq - (uint8_t)(versus->rx_seq + 1));
+        if(gap < 0) return;
+        versus->rx_lost += gap;
+    }
+    versus->rx_seq = frame->seq;
+    versus->rx_seq_valid = true;
+    versus->peer_seen = true;
+    versus->last_rx_time = now;
+
+    bool racing = versus->match == VersusMatchRacing || versus->match == VersusMatchFinished;
+
+    switch(frame->type) {
+        case VersusFrameTypePing:
+            versus_send(versus, VersusFrameTypePong, versus->local_count, frame->t0, now);
+            if(racing && frame->arg > versus->remote_count) versus->remote_count = frame->arg;
+            break;
+
+        case VersusFrameTypePong:
+            versus_add_clock_sample(versus, frame->t0, frame->t1, now);
+            if(racing && frame->arg > versus->remote_count) versus->remote_count = frame->arg;
+            break;
+
+        case VersusFrameTypeStart: {
+            // Both players may press start at once; the larger seed wins so both
+            // sides converge on the same match.
+            bool adopt = versus->match == VersusMatchIdle ||
+                         (versus->match == VersusMatchCountdown && frame->t1 > versus->seed);
+            if(adopt) {
+                uint32_t start_time = versus->synced ? versus_remote_to_local(versus, frame->t0) :
+                                                       now + VERSUS_START_DELAY_MS;
+                versus_begin_countdown(versus, frame->t1, start_time, false);
+            }
+            if(versus->seed == frame->t1) {
+                versus_send(versus, VersusFrameTypeStartAck, 0, now, frame->t1);
+            }
+            break;
+        }
+
+        case VersusFrameTypeStartAck:
+            if(versus->initiator && frame->t1 == versus->seed) versus->start_acked = true;
+            break;
+
+        case VersusFrameTypeCompletion:
+            if(!racing) break;
+            if(frame->arg > versus->remote_count) versus->remote_count = frame->arg;
+            if(frame->arg >= VERSUS_MATCH_LENGTH) {
+                if(frame->t1 && versus->local_done) {
+                    // The peer finished after ours reached it, as good as
+                    // an ack saying it was not done
+                    versus->finish_acked = true;
+                } else if(!versus->remote_done) {
+                    versus->remote_done = true;
+                    versus->remote_finish = frame->t0;
+                }
+                // Every copy is acked, the last ack may have been lost. The
+                // ack carries our own race time if we are done.
+                versus_send(versus, VersusFrameTypeCompletionAck, versus->local_count,
+                            versus->local_done ? versus->local_finish : 0, frame->t0);
+            }
+            break;
+
+        case VersusFrameTypeCompletionAck:
+            if(!racing || !versus->local_done || frame->t1 != versus->local_finish) break;
+            versus->finish_acked = true;
+            if(frame->arg >= VERSUS_MATCH_LENGTH && !versus->remote_done) {
+                versus->remote_done = true;
+                versus->remote_finish = frame->t0;
+            }
+            break;
+
+        case VersusFrameTypeForfeit:
+            if(racing) versus->remote_forfeit = true;
+            break;
+
+        default:
+            break;
+    }
+
+    versus_update_result(versus);
+}
+
+void versus_feed(Versus* versus, const uint8_t* data, size_t size, uint32_t now) {
+    for(size_t i = 0; i < size; i++) {
+        if(versus->rx_len == 0 && data[i] != VERSUS_SYNC_BYTE) continue;
+        versus->rx_buf[versus->rx_len++] = data[i];
+        if(versus->rx_len < VERSUS_FRAME_SIZE) continue;
+
+        VersusFrame frame;
+        if(versus_frame_decode(versus->rx_buf, &frame)) {
+            versus->rx_len = 0;
+            versus_handle_frame(versus, &frame, now);
+        } else {
+            // Resync on the next sync byte inside the rejected window
+            versus->rx_corrupt++;
+            uint8_t next = 1;
+            while(next < VERSUS_FRAME_SIZE && versus->rx_buf[next] != VERSUS_SYNC_BYTE) next++;
+            versus->rx_len = VERSUS_FRAME_SIZE - next;
+            memmove(versus->rx_buf, &versus->rx_buf[next], versus->rx_len);
+        }
+    }
+}
+
+void versus_tick(Versus* versus, uint32_t now) {
+    if(versus->match == VersusMatchCountdown && (int32_t)(now - versus->start_time) >= 0) {
+        versus->match = VersusMatchRacing;
+    }
+
+    if(now - versus->last_heartbeat_time >= VERSUS_HEARTBEAT_MS) {
+        versus->last_heartbeat_time = now;
+        versus_send(versus, VersusFrameTypePing, versus->local_count, now, 0);
+
+        if(versus->match == VersusMatchCountdown && versus->initiator && !versus->start_acked) {
+            versus_send(
+                versus, VersusFrameTypeStart, 0, versus->start_time, versus->seed);
+        }
+        if(versus->local_forfeit) {
+            versus_send(versus, VersusFrameTypeForfeit, versus->local_count, now, 0);
+        } else if(versus->local_done && !versus->finish_acked) {
+            versus_send(
+                versus, VersusFrameTypeCompletion, versus->local_count, versus->local_finish,
+                versus->local_behind);
+        }
+    }
+
+    versus_update_result(versus);
+}
+
+void versus_start(Versus* versus, uint32_t seed, uint32_t now) {
+    versus_begin_countdown(versus, seed, now + VERSUS_START_DELAY_MS, true);
+    versus_send(versus, VersusFrameTypeStart, 0, versus->start_time, seed);
+}
+
+void versus_reset_match(Versus* versus) {
+    versus->match = VersusMatchIdle;
+    versus->initiator = false;
+    versus->start_acked = false;
+    versus->local_count = 0;
+    versus->remote_count = 0;
+    versus->local_done = false;
+    versus->local_behind = false;
+    versus->finish_acked = false;
+    versus->remote_done = false;
+    versus->local_forfeit = false;
+    versus->remote_forfeit = false;
+    versus->result = VersusResultPending;
+}
+
+void versus_report_completion(Versus* versus, uint32_t now) {
+    if(versus->match != VersusMatchRacing) return;
+
+    versus->local_count++;
+    if(versus->local_count >= VERSUS_MATCH_LENGTH) {
+        versus->local_done = true;
+        versus->local_behind = versus->remote_done;
+        versus->local_finish = now - versus->start_time;
+        versus->match = VersusMatchFinished;
+    }
+    versus_send(
+        versus, VersusFrameTypeCompletion, versus->local_count, now - versus->start_time,
+        versus->local_behind);
+    versus_update_result(versus);
+}
+
+void versus_report_forfeit(Versus* versus, uint32_t now) {
+    if(versus->match != VersusMatchRacing) return;
+
+    versus->local_forfeit = true;
+    versus->match = VersusMatchFinished;
+    versus_send(versus, VersusFrameTypeForfeit, versus->local_count, now, 0);
+    versus_update_result(versus);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Two-device race protocol. Everything here is platform-free: the app feeds
+// received bytes in, calls versus_tick() periodically and provides a send
+// callback for the UART. All times are local milliseconds.
+
+#define VERSUS_SYNC_BYTE 0xA5
+#define VERSUS_FRAME_SIZE 14
+
+#define VERSUS_MATCH_LENGTH 10
+#define VERSUS_HEARTBEAT_MS 250
+#define VERSUS_LINK_TIMEOUT_MS 1500
+#define VERSUS_START_DELAY_MS 1500
+#define VERSUS_CLOCK_SAMPLES 8
+
+typedef enum {
+    VersusFrameTypePing = 1,
+    VersusFrameTypePong,
+    VersusFrameTypeStart,
+    VersusFrameTypeStartAck,
+    VersusFrameTypeCompletion, // t0: race time of a finish, t1: set if it came second
+    VersusFrameTypeForfeit,
+    VersusFrameTypeCompletionAck, // t0: the acker's race time if done, t1: the one acked
+} VersusFrameType;
+
+// On the wire: sync, type, seq, arg (le16), t0 (le32), t1 (le32), crc8
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint16_t arg;
+    uint32_t t0;
+    uint32_t t1;
+} VersusFrame;
+
+typedef enum {
+    VersusMatchIdle,
+    VersusMatchCountdown,
+    VersusMatchRacing,
+    VersusMatchFinished,
+} VersusMatchState;
+
+typedef enum {
+    VersusResultPending,
+    VersusResultWin,
+    VersusResultLose,
+    VersusResultDraw,
+} VersusResult;
+
+// What the screens show of a match, copied out under the owner's lock
+typedef struct {
+    VersusMatchState match;
+    VersusResult result;
+    bool connected;
+    uint32_t rtt;
+    uint32_t start_time;
+    uint16_t local_count;
+    uint16_t remote_count;
+    bool local_done;
+} VersusStatus;
+
+typedef void (*VersusSendCallback)(const uint8_t* data, size_t size, void* context);
+
+typedef struct {
+    VersusSendCallback send;
+    void* context;
+
+    uint8_t rx_buf[VERSUS_FRAME_SIZE];
+    uint8_t rx_len;
+    uint8_t tx_seq;
+    uint8_t rx_seq;
+    bool rx_seq_valid;
+    uint16_t rx_lost;
+    uint16_t rx_corrupt;
+
+    bool peer_seen;
+    uint32_t last_rx_time;
+    uint32_t last_heartbeat_time;
+
+    // Clock estimate: remote_time = local_time + offset
+    int32_t sample_offset[VERSUS_CLOCK_SAMPLES];
+    uint32_t sample_rtt[VERSUS_CLOCK_SAMPLES];
+    uint8_t sample_count;
+    uint8_t sample_next;
+    int32_t offset;
+    uint32_t rtt;
+    bool synced;
+
+    VersusMatchState match;
+    bool initiator;
+    bool start_acked;
+    uint32_t seed;
+    uint32_t start_time;
+    uint16_t local_count;
+    uint16_t remote_count;
+    // Race times, each on the finisher's own clock from its own start, so
+    // both sides compare the same two numbers
+    uint32_t local_finish;
+    uint32_t remote_finish;
+    bool local_done;
+    bool local_behind; // the peer's finish had arrived before ours
+    bool finish_acked;
+    bool remote_done;
+    bool local_forfeit;
+    bool remote_forfeit;
+    VersusResult result;
+} Versus;
+
+void versus_init(Versus* versus, VersusSendCallback send, void* context);
+
+size_t versus_frame_encode(const VersusFrame* frame, uint8_t* out);
+bool versus_frame_decode(const uint8_t* data, VersusFrame* frame);
+
+void versus_feed(Versus* versus, const uint8_t* data, size_t size, uint32_t now);
+void versus_tick(Versus* versus, uint32_t now);
+
+bool versus_is_connected(const Versus* versus, uint32_t now);
+void versus_get_status(const Versus* versus, uint32_t now, VersusStatus* status);
+uint32_t versus_remote_to_local(const Versus* versus, uint32_t remote_time);
+
+void versus_start(Versus* versus, uint32_t seed, uint32_t now);
+void versus_reset_match(Versus* versus);
+void versus_report_completion(Versus* versus, uint32_t now);
+void versus_report_forfeit(Versus* versus, uint32_t now);